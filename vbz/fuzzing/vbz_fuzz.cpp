@@ -1,11 +1,13 @@
 #include <limits>
 #include <vbz.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <utility>
 #include <vector>
@@ -90,6 +92,37 @@ void run_vbz_compress_test(const uint8_t* data, vbz_size_t size, vbz_size_t max_
     compare(data, size, decompressed.data(), decompressed_size);
 }
 
+// Shared between runs so that buffers are reused with differently sized data.
+vbz_context* get_context() {
+    static std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+    REQUIRE(context, "Failed to create context");
+    return context.get();
+}
+
+void run_vbz_context_test(const uint8_t* data, vbz_size_t size, vbz_size_t max_size, CompressionOptions const& options) {
+    // Compress the data with and without a context - which should give identical results.
+    auto expected = std::vector<uint8_t>(max_size);
+    auto const expected_size = vbz_compress_sized(data, size, expected.data(), max_size, &options);
+    RETURN_IF_VBZ_ERROR(expected_size);
+
+    auto compressed = std::vector<uint8_t>(max_size);
+    auto const compressed_size = vbz_compress_sized_ctx(get_context(), data, size, compressed.data(), max_size, &options);
+    REQUIRE_NO_VBZ_ERROR(compressed_size);
+    compare(expected.data(), expected_size, compressed.data(), compressed_size);
+
+    // Decompress the data.
+    auto decompressed = std::vector<uint8_t>(size);
+    auto const decompressed_size = vbz_decompress_sized_ctx(get_context(), compressed.data(), compressed_size, decompressed.data(), size, &options);
+    REQUIRE_NO_VBZ_ERROR(decompressed_size);
+    compare(data, size, decompressed.data(), decompressed_size);
+}
+
+vbz_dstream* get_dstream() {
+    static std::unique_ptr<vbz_dstream, decltype(&vbz_free_dstream)> stream(vbz_create_dstream(), vbz_free_dstream);
+    REQUIRE(stream, "Failed to create dstream");
+    return stream.get();
+}
+
 void run_vbz_compress_tests(const uint8_t* data, vbz_size_t size, CompressionOptions const& options) {
     auto const max_size = vbz_max_compressed_size(size, &options);
     RETURN_IF_VBZ_ERROR(max_size);
@@ -97,6 +130,7 @@ void run_vbz_compress_tests(const uint8_t* data, vbz_size_t size, CompressionOpt
     // Run sized and unsized versions.
     run_vbz_compress_test<false>(data, size, max_size, options);
     run_vbz_compress_test<true>(data, size, max_size, options);
+    run_vbz_context_test(data, size, max_size, options);
 }
 
 void run_vbz_decompress_test(const uint8_t* data, vbz_size_t size, vbz_size_t original_size, std::vector<uint8_t> & decompress_dest, CompressionOptions const& options)
@@ -125,6 +159,15 @@ void run_vbz_decompress_test(const uint8_t* data, vbz_size_t size, vbz_size_t or
         }
     }
 
+    // Context version.
+    {
+        auto const decompressed_size = vbz_decompress_sized_ctx(get_context(), data, size, decompress_dest.data(), original_size, &options);
+        if (vbz_is_error(decompressed_size))
+        {
+            debug_log("decompress_sized_ctx: Error in decompressed_size ", vbz_error_string(decompressed_size));
+        }
+    }
+
     // Extract size.
     {
         auto const decompressed_size = vbz_decompressed_size(data, size, &options);
@@ -133,6 +176,75 @@ void run_vbz_decompress_test(const uint8_t* data, vbz_size_t size, vbz_size_t or
             debug_log("decompressed_size: Error in decompressed_size ", vbz_error_string(decompressed_size));
         }
     }
+
+    // 64 bit version.
+    {
+        auto const decompressed_size = vbz_decompress64(data, size, decompress_dest.data(), original_size, &options);
+        if (vbz_is_error64(decompressed_size))
+        {
+            debug_log("decompress64: Error in decompressed_size ", decompressed_size);
+        }
+    }
+
+    // Blocked version, and a range from the middle of the data.
+    {
+        auto const decompressed_size = vbz_decompress_blocked(data, size, decompress_dest.data(), original_size, &options, 1);
+        if (vbz_is_error(decompressed_size))
+        {
+            debug_log("decompress_blocked: Error in decompressed_size ", vbz_error_string(decompressed_size));
+        }
+
+        auto const sample_count = original_size / std::max(options.integer_size, 1u);
+        auto const range_size = vbz_decompress_range(data, size, sample_count / 2, sample_count - sample_count / 2, decompress_dest.data(), original_size, &options);
+        if (vbz_is_error(range_size))
+        {
+            debug_log("decompress_range: Error in decompressed_size ", vbz_error_string(range_size));
+        }
+    }
+
+    // Described frame, which carries its own options.
+    {
+        VbzFrameInfo info;
+        auto const info_result = vbz_frame_info(data, size, &info);
+        if (vbz_is_error(info_result))
+        {
+            debug_log("frame_info: Error in frame info ", vbz_error_string(info_result));
+        }
+
+        auto const decompressed_size = vbz_decompress_auto(data, size, decompress_dest.data(), original_size);
+        if (vbz_is_error(decompressed_size))
+        {
+            debug_log("decompress_auto: Error in decompressed_size ", vbz_error_string(decompressed_size));
+        }
+    }
+
+    // Streaming version, reading a bounded number of windows so frames which expand hugely stay quick.
+    {
+        auto const stream = get_dstream();
+        auto const sample_count = vbz_dstream_begin(stream, data, size, &options);
+        auto const sample_capacity = original_size / std::max(options.integer_size, 1u);
+        if (vbz_is_error(sample_count))
+        {
+            debug_log("dstream_begin: Error in sample count ", vbz_error_string(sample_count));
+        }
+        else if (sample_capacity != 0)
+        {
+            for (int window = 0; window < 4; ++window)
+            {
+                auto const read = vbz_dstream_read_samples(stream, decompress_dest.data(), sample_capacity);
+                if (vbz_is_error(read))
+                {
+                    debug_log("dstream_read_samples: Error in read ", vbz_error_string(read));
+                    break;
+                }
+                REQUIRE(read <= sample_capacity, "read=", read, ", sample_capacity=", sample_capacity);
+                if (read < sample_capacity)
+                {
+                    break;
+                }
+            }
+        }
+    }
 }
 
 void run_vbz_decompress_tests(const uint8_t* data, vbz_size_t size, CompressionOptions const& options) {
@@ -4,6 +4,8 @@
 
 #include <gsl/gsl-lite.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <numeric>
 #include <random>
 
@@ -72,3 +74,114 @@ private:
         return results;
     }
 };
+
+// Generator that targets many short reads, each taken from a random point in the test data.
+//
+// Under a maximum target byte count.
+template <typename T>
+struct ShortReadGenerator
+{
+    static const std::size_t byte_target = 10 * 1000 * 1000; // 10 mb
+
+    static std::vector<std::vector<T>> generate(std::size_t& max_element_count, unsigned int seed = 5)
+    {
+        std::default_random_engine rand(seed);
+        std::uniform_int_distribution<std::size_t> length_dist(1000, 8000);
+
+        max_element_count = 0;
+        std::size_t generated_bytes = 0;
+        std::vector<std::vector<T>> results;
+        while (generated_bytes < byte_target)
+        {
+            auto length = std::min<std::size_t>((byte_target-generated_bytes)/sizeof(T), length_dist(rand));
+            generated_bytes += length * sizeof(T);
+            max_element_count = std::max(max_element_count, length);
+
+            std::uniform_int_distribution<std::size_t> start_dist(0, test_data.size() - length);
+            auto const start = start_dist(rand);
+
+            std::vector<T> input_values(length);
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                input_values[i] = (T)test_data[start + i];
+            }
+
+            results.push_back(input_values);
+        }
+
+        return results;
+    }
+};
+
+// Generator that targets the reads of one channel, in order, each continuing the test data where the last stopped.
+//
+// Under a maximum target byte count.
+template <typename T>
+struct ChannelReadGenerator
+{
+    static const std::size_t byte_target = 10 * 1000 * 1000; // 10 mb
+
+    static std::vector<std::vector<T>> generate(std::size_t& max_element_count)
+    {
+        std::default_random_engine rand(5);
+        std::uniform_int_distribution<std::size_t> length_dist(1000, 8000);
+
+        max_element_count = 0;
+        std::size_t generated_bytes = 0;
+        std::size_t idx = 0;
+        std::vector<std::vector<T>> results;
+        while (generated_bytes < byte_target)
+        {
+            auto length = std::min<std::size_t>((byte_target-generated_bytes)/sizeof(T), length_dist(rand));
+            generated_bytes += length * sizeof(T);
+            max_element_count = std::max(max_element_count, length);
+
+            std::vector<T> input_values(length);
+            for (auto& e : input_values)
+            {
+                e = (T)test_data[idx];
+                idx = (idx + 1) % test_data.size();
+            }
+
+            results.push_back(input_values);
+        }
+
+        return results;
+    }
+};
+
+// Generator that targets a random set of reads of random lengths, holding uniform noise across the full range of T.
+//
+// Under a maximum target byte count.
+template <typename T>
+struct NoiseGenerator
+{
+    static const std::size_t byte_target = 10 * 1000 * 1000; // 10 mb
+
+    static std::vector<std::vector<T>> generate(std::size_t& max_element_count)
+    {
+        std::default_random_engine rand(5);
+        std::uniform_int_distribution<std::uint32_t> length_dist(30000, 200000);
+        std::uniform_int_distribution<std::int64_t> value_dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+
+        max_element_count = 0;
+        std::size_t generated_bytes = 0;
+        std::vector<std::vector<T>> results;
+        while (generated_bytes < byte_target)
+        {
+            auto length = std::min<std::size_t>((byte_target-generated_bytes)/sizeof(T), length_dist(rand));
+            generated_bytes += length * sizeof(T);
+            max_element_count = std::max(max_element_count, length);
+
+            std::vector<T> input_values(length);
+            for (auto& e : input_values)
+            {
+                e = (T)value_dist(rand);
+            }
+
+            results.push_back(input_values);
+        }
+
+        return results;
+    }
+};
@@ -1,4 +1,6 @@
 #include "vbz.h"
+#include "v0/vbz_streamvbyte.h"
+#include "v1/vbz_streamvbyte.h"
 #include "test_data_generator.h"
 
 #include <benchmark/benchmark.h>
@@ -46,22 +48,872 @@ void streamvbyte_compress_benchmark(benchmark::State& state)
     state.SetBytesProcessed(state.iterations() * item_count * int_size);
 }
 
+template <typename VbzOptions, typename Generator>
+void streamvbyte_compress_context_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+    
+    std::vector<char> dest_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
+    auto context = vbz_create_context();
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
+            item_count += input_values.size();
+
+            auto bytes_used = vbz_compress_ctx(
+                context,
+                input_values.data(),
+                vbz_size_t(input_byte_count),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                &options);
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark compressing reads at zstd level state.range(0), which may be one of zstd's negative
+// "fast" levels, reporting the compression ratio alongside the throughput.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_compress_level_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        unsigned(state.range(0)),
+        VBZ_DEFAULT_VERSION
+    };
+
+    std::vector<char> dest_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
+    auto context = vbz_create_context();
+
+    std::size_t item_count = 0;
+    std::size_t compressed_bytes = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        compressed_bytes = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
+            item_count += input_values.size();
+
+            auto bytes_used = vbz_compress_sized_ctx(
+                context,
+                input_values.data(),
+                vbz_size_t(input_byte_count),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                &options);
+            compressed_bytes += bytes_used;
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.counters["ratio"] = double(item_count * int_size) / double(compressed_bytes);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+template <typename VbzOptions, typename Generator>
+void streamvbyte_compress_dictionary_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    std::vector<char> dest_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
+    auto context = vbz_create_context();
+
+    // Train on a different set of reads to the ones being compressed, range(0) is the dictionary size.
+    if (state.range(0) > 0)
+    {
+        std::size_t training_element_count = 0;
+        auto const training_list = Generator::generate(training_element_count, 6);
+        std::vector<void const*> samples;
+        std::vector<vbz_size_t> sample_sizes;
+        for (auto const& training_values : training_list)
+        {
+            samples.push_back(training_values.data());
+            sample_sizes.push_back(vbz_size_t(training_values.size() * int_size));
+        }
+
+        std::vector<char> dictionary(std::size_t(state.range(0)));
+        auto const dictionary_size = vbz_train_dictionary(
+            samples.data(),
+            sample_sizes.data(),
+            vbz_size_t(samples.size()),
+            dictionary.data(),
+            vbz_size_t(dictionary.size()),
+            &options);
+        if (vbz_is_error(dictionary_size))
+        {
+            state.SkipWithError(vbz_error_string(dictionary_size));
+        }
+        else
+        {
+            vbz_context_set_dictionary(context, dictionary.data(), dictionary_size);
+        }
+    }
+
+    std::size_t item_count = 0;
+    std::size_t compressed_bytes = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        compressed_bytes = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
+            item_count += input_values.size();
+
+            auto bytes_used = vbz_compress_sized_ctx(
+                context,
+                input_values.data(),
+                vbz_size_t(input_byte_count),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                &options);
+            compressed_bytes += bytes_used;
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.counters["ratio"] = double(item_count * int_size) / double(compressed_bytes);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// range(0) selects whether each read is compressed with the previous read as its reference.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_compress_prefix_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    auto const use_reference = state.range(0) != 0;
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    std::vector<char> dest_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
+    auto context = vbz_create_context();
+
+    std::size_t item_count = 0;
+    std::size_t compressed_bytes = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        compressed_bytes = 0;
+        std::vector<typename VbzOptions::IntType> const* reference = nullptr;
+        for (auto const& input_values : input_value_list)
+        {
+            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
+            item_count += input_values.size();
+
+            auto bytes_used = vbz_compress_sized_prefix_ctx(
+                context,
+                input_values.data(),
+                vbz_size_t(input_byte_count),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                &options,
+                reference ? reference->data() : nullptr,
+                reference ? vbz_size_t(reference->size() * int_size) : 0);
+            compressed_bytes += bytes_used;
+            if (use_reference)
+            {
+                reference = &input_values;
+            }
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.counters["ratio"] = double(item_count * int_size) / double(compressed_bytes);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// range(0) selects whether each read is compressed with the previous read as its reference.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_decompress_prefix_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    auto const use_reference = state.range(0) != 0;
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    auto context = vbz_create_context();
+    std::vector<std::vector<char>> compressed_list;
+    for (std::size_t i = 0; i < input_value_list.size(); ++i)
+    {
+        auto const& input_values = input_value_list[i];
+        auto const reference = use_reference && i > 0 ? &input_value_list[i - 1] : nullptr;
+
+        std::vector<char> compressed(vbz_max_compressed_size(vbz_size_t(input_values.size() * int_size), &options));
+        compressed.resize(vbz_compress_sized_prefix_ctx(
+            context,
+            input_values.data(),
+            vbz_size_t(input_values.size() * int_size),
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options,
+            reference ? reference->data() : nullptr,
+            reference ? vbz_size_t(reference->size() * int_size) : 0));
+        compressed_list.push_back(std::move(compressed));
+    }
+
+    // Reads are decompressed in order, each into its own buffer, since the next read needs it as a reference.
+    std::vector<std::vector<typename VbzOptions::IntType>> dest_list;
+    for (auto const& input_values : input_value_list)
+    {
+        dest_list.emplace_back(input_values.size());
+    }
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (std::size_t i = 0; i < compressed_list.size(); ++i)
+        {
+            auto& dest = dest_list[i];
+            auto const reference = use_reference && i > 0 ? &dest_list[i - 1] : nullptr;
+            item_count += dest.size();
+
+            auto bytes_used = vbz_decompress_sized_prefix_ctx(
+                context,
+                compressed_list[i].data(),
+                vbz_size_t(compressed_list[i].size()),
+                dest.data(),
+                vbz_size_t(dest.size() * int_size),
+                &options,
+                reference ? reference->data() : nullptr,
+                reference ? vbz_size_t(reference->size() * int_size) : 0);
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// range(0) selects #vbz_compress_adaptive over #vbz_compress_described.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_compress_adaptive_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    auto const compress_fn = state.range(0) != 0 ? vbz_compress_adaptive_ctx : vbz_compress_described_ctx;
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    std::vector<char> dest_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options) + VBZ_DESCRIBED_HEADER_SIZE);
+    auto context = vbz_create_context();
+
+    std::size_t item_count = 0;
+    std::size_t compressed_bytes = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        compressed_bytes = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
+            item_count += input_values.size();
+
+            auto bytes_used = compress_fn(
+                context,
+                input_values.data(),
+                vbz_size_t(input_byte_count),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                &options);
+            compressed_bytes += bytes_used;
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.counters["ratio"] = double(item_count * int_size) / double(compressed_bytes);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// range(0) selects frames from #vbz_compress_adaptive over #vbz_compress_described.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_decompress_adaptive_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    auto const compress_fn = state.range(0) != 0 ? vbz_compress_adaptive_ctx : vbz_compress_described_ctx;
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    auto context = vbz_create_context();
+    std::vector<std::vector<char>> compressed_list;
+    for (auto const& input_values : input_value_list)
+    {
+        std::vector<char> compressed(vbz_max_compressed_size(vbz_size_t(input_values.size() * int_size), &options) + VBZ_DESCRIBED_HEADER_SIZE);
+        compressed.resize(compress_fn(
+            context,
+            input_values.data(),
+            vbz_size_t(input_values.size() * int_size),
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options));
+        compressed_list.push_back(std::move(compressed));
+    }
+
+    std::vector<char> dest_buffer(max_element_count * int_size);
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (std::size_t i = 0; i < compressed_list.size(); ++i)
+        {
+            item_count += input_value_list[i].size();
+
+            auto bytes_used = vbz_decompress_auto_ctx(
+                context,
+                compressed_list[i].data(),
+                vbz_size_t(compressed_list[i].size()),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()));
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
 template <typename VbzOptions, typename Generator>
 void streamvbyte_decompress_benchmark(benchmark::State& state)
 {
     std::size_t max_element_count = 0;
     auto input_value_list = Generator::generate(max_element_count);
-    
+    
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel
+    };
+    
+    std::vector<char> compressed_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
+    std::vector<char> dest_buffer(max_element_count * int_size);
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            state.PauseTiming();
+            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
+            item_count += input_values.size();
+            compressed_buffer.resize(compressed_buffer.capacity());
+            dest_buffer.resize(input_byte_count);
+
+            auto compressed_used_bytes = vbz_compress(
+                input_values.data(),
+                vbz_size_t(input_byte_count),
+                compressed_buffer.data(),
+                vbz_size_t(compressed_buffer.size()),
+                &options
+            );
+
+            state.ResumeTiming();
+
+            auto bytes_expanded_to = vbz_decompress(
+                compressed_buffer.data(),
+                compressed_used_bytes,
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                &options
+            );
+            assert(bytes_expanded_to == input_byte_count);
+
+            benchmark::DoNotOptimize(bytes_expanded_to);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+template <typename VbzOptions, typename Generator>
+void streamvbyte_decompress_context_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+    
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+    
+    // Compress everything up front, so the loop only measures decompression.
+    std::vector<std::vector<char>> compressed_list;
+    for (auto const& input_values : input_value_list)
+    {
+        auto const input_byte_count = vbz_size_t(input_values.size() * sizeof(input_values[0]));
+        std::vector<char> compressed(vbz_max_compressed_size(input_byte_count, &options));
+        compressed.resize(vbz_compress(
+            input_values.data(),
+            input_byte_count,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options
+        ));
+        compressed_list.push_back(std::move(compressed));
+    }
+
+    std::vector<char> dest_buffer(max_element_count * int_size);
+    auto context = vbz_create_context();
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (std::size_t i = 0; i < input_value_list.size(); ++i)
+        {
+            auto const input_byte_count = input_value_list[i].size() * int_size;
+            item_count += input_value_list[i].size();
+
+            auto bytes_expanded_to = vbz_decompress_ctx(
+                context,
+                compressed_list[i].data(),
+                vbz_size_t(compressed_list[i].size()),
+                dest_buffer.data(),
+                vbz_size_t(input_byte_count),
+                &options
+            );
+            assert(bytes_expanded_to == input_byte_count);
+
+            benchmark::DoNotOptimize(bytes_expanded_to);
+        }
+    }
+
+    vbz_free_context(context);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark decompressing to calibrated floats, either converting values as they are decoded,
+// or with a separate pass over integers decompressed using vbz_decompress_sized_ctx.
+template <typename VbzOptions, typename Generator, bool ConvertWhileDecoding>
+void streamvbyte_decompress_calibrated_benchmark(benchmark::State& state)
+{
+    using IntType = typename VbzOptions::IntType;
+
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(IntType);
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+    VbzCalibration const calibration{ 13.0f, 1468.9f, 8192.0f };
+
+    // Compress everything up front, so the loop only measures decompression.
+    std::vector<std::vector<char>> compressed_list;
+    for (auto const& input_values : input_value_list)
+    {
+        auto const input_byte_count = vbz_size_t(input_values.size() * sizeof(input_values[0]));
+        std::vector<char> compressed(vbz_max_compressed_size(input_byte_count, &options));
+        compressed.resize(vbz_compress_sized(
+            input_values.data(),
+            input_byte_count,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options
+        ));
+        compressed_list.push_back(std::move(compressed));
+    }
+
+    std::vector<IntType> int_buffer(max_element_count);
+    std::vector<float> dest_buffer(max_element_count);
+    auto context = vbz_create_context();
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (std::size_t i = 0; i < input_value_list.size(); ++i)
+        {
+            auto const element_count = input_value_list[i].size();
+            item_count += element_count;
+
+            if (ConvertWhileDecoding)
+            {
+                auto bytes_expanded_to = vbz_decompress_sized_calibrated_ctx(
+                    context,
+                    compressed_list[i].data(),
+                    vbz_size_t(compressed_list[i].size()),
+                    dest_buffer.data(),
+                    vbz_size_t(dest_buffer.size() * sizeof(float)),
+                    &options,
+                    &calibration
+                );
+                assert(bytes_expanded_to == element_count * sizeof(float));
+                benchmark::DoNotOptimize(bytes_expanded_to);
+            }
+            else
+            {
+                auto bytes_expanded_to = vbz_decompress_sized_ctx(
+                    context,
+                    compressed_list[i].data(),
+                    vbz_size_t(compressed_list[i].size()),
+                    int_buffer.data(),
+                    vbz_size_t(int_buffer.size() * int_size),
+                    &options
+                );
+                assert(bytes_expanded_to == element_count * int_size);
+                benchmark::DoNotOptimize(bytes_expanded_to);
+
+                auto const scale = calibration.range / calibration.digitisation;
+                for (std::size_t j = 0; j < element_count; ++j)
+                {
+                    dest_buffer[j] = (float(int_buffer[j]) + calibration.offset) * scale;
+                }
+            }
+            benchmark::DoNotOptimize(dest_buffer.data());
+        }
+    }
+
+    vbz_free_context(context);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark compressing or decompressing all reads as one large blocked frame, on
+// state.range(0) threads, to show how blocked frames scale with cores.
+template <typename VbzOptions, typename Generator, bool Decompress>
+void streamvbyte_blocked_benchmark(benchmark::State& state)
+{
+    using IntType = typename VbzOptions::IntType;
+
+    std::size_t max_element_count = 0;
+    std::vector<IntType> input_values;
+    for (auto const& read : Generator::generate(max_element_count))
+    {
+        input_values.insert(input_values.end(), read.begin(), read.end());
+    }
+
+    auto const int_size = sizeof(IntType);
+    auto const thread_count = unsigned(state.range(0));
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    auto const input_byte_count = vbz_size_t(input_values.size() * int_size);
+    std::vector<char> compressed_buffer(vbz_max_compressed_size_blocked(input_byte_count, &options, 0));
+    auto compressed_used_bytes = vbz_compress_blocked(
+        input_values.data(),
+        input_byte_count,
+        compressed_buffer.data(),
+        vbz_size_t(compressed_buffer.size()),
+        &options,
+        0,
+        thread_count
+    );
+    std::vector<IntType> dest_buffer(input_values.size());
+
+    for (auto _ : state)
+    {
+        if (Decompress)
+        {
+            auto bytes_expanded_to = vbz_decompress_blocked(
+                compressed_buffer.data(),
+                compressed_used_bytes,
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size() * int_size),
+                &options,
+                thread_count
+            );
+            assert(bytes_expanded_to == input_byte_count);
+            benchmark::DoNotOptimize(bytes_expanded_to);
+        }
+        else
+        {
+            auto bytes_used = vbz_compress_blocked(
+                input_values.data(),
+                input_byte_count,
+                compressed_buffer.data(),
+                vbz_size_t(compressed_buffer.size()),
+                &options,
+                0,
+                thread_count
+            );
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * input_values.size());
+    state.SetBytesProcessed(state.iterations() * input_byte_count);
+}
+
+// Benchmark compressing or decompressing all reads as one batch, on state.range(0) threads.
+template <typename VbzOptions, typename Generator, bool Decompress>
+void streamvbyte_batch_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    auto const thread_count = unsigned(state.range(0));
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    std::vector<void const*> sources;
+    std::vector<vbz_size_t> source_sizes;
+    std::size_t item_count = 0;
+    for (auto const& input_values : input_value_list)
+    {
+        sources.push_back(input_values.data());
+        source_sizes.push_back(vbz_size_t(input_values.size() * int_size));
+        item_count += input_values.size();
+    }
+    auto const read_count = vbz_size_t(sources.size());
+
+    std::vector<char> compressed_buffer(vbz_max_compressed_size_batch(source_sizes.data(), read_count, &options));
+    std::vector<vbz_size64_t> compressed_offsets(sources.size() + 1);
+    vbz_compress_batch(
+        sources.data(),
+        source_sizes.data(),
+        read_count,
+        compressed_buffer.data(),
+        compressed_buffer.size(),
+        compressed_offsets.data(),
+        &options,
+        thread_count
+    );
+
+    std::vector<void const*> compressed_sources;
+    std::vector<vbz_size_t> compressed_sizes;
+    for (std::size_t read = 0; read < sources.size(); ++read)
+    {
+        compressed_sources.push_back(compressed_buffer.data() + compressed_offsets[read]);
+        compressed_sizes.push_back(vbz_size_t(compressed_offsets[read + 1] - compressed_offsets[read]));
+    }
+    std::vector<char> dest_buffer(item_count * int_size);
+    std::vector<vbz_size64_t> dest_offsets(sources.size() + 1);
+
+    for (auto _ : state)
+    {
+        if (Decompress)
+        {
+            auto bytes_expanded_to = vbz_decompress_batch(
+                compressed_sources.data(),
+                compressed_sizes.data(),
+                read_count,
+                dest_buffer.data(),
+                dest_buffer.size(),
+                dest_offsets.data(),
+                &options,
+                thread_count
+            );
+            benchmark::DoNotOptimize(bytes_expanded_to);
+        }
+        else
+        {
+            auto bytes_used = vbz_compress_batch(
+                sources.data(),
+                source_sizes.data(),
+                read_count,
+                compressed_buffer.data(),
+                compressed_buffer.size(),
+                compressed_offsets.data(),
+                &options,
+                thread_count
+            );
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark reading state.range(0) sample windows spread through one large blocked frame,
+// as a signal viewer would.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_decompress_range_benchmark(benchmark::State& state)
+{
+    using IntType = typename VbzOptions::IntType;
+
+    std::size_t max_element_count = 0;
+    std::vector<IntType> input_values;
+    for (auto const& read : Generator::generate(max_element_count))
+    {
+        input_values.insert(input_values.end(), read.begin(), read.end());
+    }
+
+    auto const int_size = sizeof(IntType);
+    auto const window_size = std::size_t(state.range(0));
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    auto const input_byte_count = vbz_size_t(input_values.size() * int_size);
+    std::vector<char> compressed_buffer(vbz_max_compressed_size_blocked(input_byte_count, &options, 0));
+    compressed_buffer.resize(vbz_compress_blocked(
+        input_values.data(),
+        input_byte_count,
+        compressed_buffer.data(),
+        vbz_size_t(compressed_buffer.size()),
+        &options,
+        0,
+        0
+    ));
+    std::vector<IntType> dest_buffer(window_size);
+    auto context = vbz_create_context();
+
+    // Windows start part way into blocks, so most straddle a block boundary.
+    std::size_t const window_stride = 1000 * 1000 + 12345;
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (std::size_t first = 0; first + window_size <= input_values.size(); first += window_stride)
+        {
+            item_count += window_size;
+            auto bytes_expanded_to = vbz_decompress_range_ctx(
+                context,
+                compressed_buffer.data(),
+                vbz_size_t(compressed_buffer.size()),
+                vbz_size_t(first),
+                vbz_size_t(window_size),
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size() * int_size),
+                &options
+            );
+            assert(bytes_expanded_to == window_size * int_size);
+            benchmark::DoNotOptimize(bytes_expanded_to);
+        }
+    }
+
+    vbz_free_context(context);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark compressing reads with a vbz_cstream, pushing state.range(0) samples at a time
+// as an acquisition loop would.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_compress_stream_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
     auto const int_size = sizeof(typename VbzOptions::IntType);
-    
+    auto const push_size = std::size_t(state.range(0));
+
     CompressionOptions options{
         VbzOptions::UseZigZag,
         int_size,
-        VbzOptions::ZstdLevel
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
     };
-    
-    std::vector<char> compressed_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
-    std::vector<char> dest_buffer(max_element_count * int_size);
+
+    std::vector<char> dest_buffer(vbz_max_compressed_size(vbz_size_t(max_element_count * int_size), &options));
+    auto stream = vbz_create_cstream();
+    auto context = vbz_create_context();
 
     std::size_t item_count = 0;
     for (auto _ : state)
@@ -69,28 +921,165 @@ void streamvbyte_decompress_benchmark(benchmark::State& state)
         item_count = 0;
         for (auto const& input_values : input_value_list)
         {
-            state.PauseTiming();
-            auto const input_byte_count = input_values.size() * sizeof(input_values[0]);
             item_count += input_values.size();
-            compressed_buffer.resize(compressed_buffer.capacity());
-            dest_buffer.resize(input_byte_count);
 
-            auto compressed_used_bytes = vbz_compress(
+            vbz_cstream_begin(stream, &options);
+            for (std::size_t pushed = 0; pushed < input_values.size(); pushed += push_size)
+            {
+                auto const count = std::min(push_size, input_values.size() - pushed);
+                vbz_cstream_push_samples(stream, input_values.data() + pushed, vbz_size_t(count));
+            }
+            auto bytes_used = vbz_cstream_end(stream, context, dest_buffer.data(), vbz_size_t(dest_buffer.size()));
+
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
+
+    vbz_free_context(context);
+    vbz_free_cstream(stream);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark decompressing reads with a vbz_dstream, reading state.range(0) samples at a time
+// into a single reused window.
+template <typename VbzOptions, typename Generator>
+void streamvbyte_decompress_stream_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename VbzOptions::IntType);
+    auto const window_size = std::size_t(state.range(0));
+
+    CompressionOptions options{
+        VbzOptions::UseZigZag,
+        int_size,
+        VbzOptions::ZstdLevel,
+        VBZ_DEFAULT_VERSION
+    };
+
+    std::vector<std::vector<char>> compressed_list;
+    for (auto const& input_values : input_value_list)
+    {
+        auto const input_size = vbz_size_t(input_values.size() * int_size);
+        std::vector<char> compressed(vbz_max_compressed_size(input_size, &options));
+        auto const compressed_size = vbz_compress_sized(
+            input_values.data(),
+            input_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options
+        );
+        compressed.resize(compressed_size);
+        compressed_list.push_back(std::move(compressed));
+    }
+
+    std::vector<typename VbzOptions::IntType> window(window_size);
+    auto stream = vbz_create_dstream();
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (auto const& compressed : compressed_list)
+        {
+            vbz_dstream_begin(stream, compressed.data(), vbz_size_t(compressed.size()), &options);
+            vbz_size_t read = 0;
+            do
+            {
+                read = vbz_dstream_read_samples(stream, window.data(), vbz_size_t(window.size()));
+                item_count += read;
+                benchmark::DoNotOptimize(window.data());
+            } while (read == window.size());
+        }
+    }
+
+    vbz_free_dstream(stream);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+// Benchmark the delta zig zag + streamvbyte stage alone, so the cost of converting
+// samples is not hidden behind zstd.
+template <typename StreamVByteOptions, typename Generator>
+void streamvbyte_stage_compress_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename StreamVByteOptions::IntType);
+    std::vector<char> dest_buffer(
+        StreamVByteOptions::max_compressed_size(int_size, vbz_size_t(max_element_count * int_size)));
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto const input_byte_count = input_values.size() * int_size;
+            item_count += input_values.size();
+
+            auto bytes_used = StreamVByteOptions::compress(
                 input_values.data(),
                 vbz_size_t(input_byte_count),
-                compressed_buffer.data(),
-                vbz_size_t(compressed_buffer.size()),
-                &options
-            );
+                dest_buffer.data(),
+                vbz_size_t(dest_buffer.size()),
+                int(int_size),
+                StreamVByteOptions::UseZigZag);
 
-            state.ResumeTiming();
+            benchmark::DoNotOptimize(bytes_used);
+        }
+    }
 
-            auto bytes_expanded_to = vbz_decompress(
-                compressed_buffer.data(),
-                compressed_used_bytes,
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * int_size);
+}
+
+template <typename StreamVByteOptions, typename Generator>
+void streamvbyte_stage_decompress_benchmark(benchmark::State& state)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+
+    auto const int_size = sizeof(typename StreamVByteOptions::IntType);
+
+    // Compress everything up front, so the loop only measures decompression.
+    std::vector<std::vector<char>> compressed_list;
+    for (auto const& input_values : input_value_list)
+    {
+        auto const input_byte_count = vbz_size_t(input_values.size() * int_size);
+        std::vector<char> compressed(StreamVByteOptions::max_compressed_size(int_size, input_byte_count));
+        compressed.resize(StreamVByteOptions::compress(
+            input_values.data(),
+            input_byte_count,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            int(int_size),
+            StreamVByteOptions::UseZigZag
+        ));
+        compressed_list.push_back(std::move(compressed));
+    }
+
+    std::vector<char> dest_buffer(max_element_count * int_size);
+
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        for (std::size_t i = 0; i < input_value_list.size(); ++i)
+        {
+            auto const input_byte_count = input_value_list[i].size() * int_size;
+            item_count += input_value_list[i].size();
+
+            auto bytes_expanded_to = StreamVByteOptions::decompress(
+                compressed_list[i].data(),
+                vbz_size_t(compressed_list[i].size()),
                 dest_buffer.data(),
-                vbz_size_t(dest_buffer.size()),
-                &options
+                vbz_size_t(input_byte_count),
+                int(int_size),
+                StreamVByteOptions::UseZigZag
             );
             assert(bytes_expanded_to == input_byte_count);
 
@@ -118,6 +1107,26 @@ struct VbzZStd
     static const std::size_t ZstdLevel = 1;
 };
 
+template <typename _IntType, bool _UseZigZag>
+struct StreamVByteV0
+{
+    using IntType = _IntType;
+    static const bool UseZigZag = _UseZigZag;
+    static constexpr decltype(&vbz_max_streamvbyte_compressed_size_v0) max_compressed_size = vbz_max_streamvbyte_compressed_size_v0;
+    static constexpr decltype(&vbz_delta_zig_zag_streamvbyte_compress_v0) compress = vbz_delta_zig_zag_streamvbyte_compress_v0;
+    static constexpr decltype(&vbz_delta_zig_zag_streamvbyte_decompress_v0) decompress = vbz_delta_zig_zag_streamvbyte_decompress_v0;
+};
+
+template <typename _IntType, bool _UseZigZag>
+struct StreamVByteV1
+{
+    using IntType = _IntType;
+    static const bool UseZigZag = _UseZigZag;
+    static constexpr decltype(&vbz_max_streamvbyte_compressed_size_v1) max_compressed_size = vbz_max_streamvbyte_compressed_size_v1;
+    static constexpr decltype(&vbz_delta_zig_zag_streamvbyte_compress_v1) compress = vbz_delta_zig_zag_streamvbyte_compress_v1;
+    static constexpr decltype(&vbz_delta_zig_zag_streamvbyte_decompress_v1) decompress = vbz_delta_zig_zag_streamvbyte_decompress_v1;
+};
+
 template <typename CompressionOptions>
 void compress_sequence(benchmark::State& state)
 {
@@ -142,6 +1151,132 @@ void decompress_random(benchmark::State& state)
     streamvbyte_decompress_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
 }
 
+template <typename CompressionOptions>
+void compress_random_context(benchmark::State& state)
+{
+    streamvbyte_compress_context_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_random_context(benchmark::State& state)
+{
+    streamvbyte_decompress_context_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_calibrated_random(benchmark::State& state)
+{
+    streamvbyte_decompress_calibrated_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>, true>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_then_calibrate_random(benchmark::State& state)
+{
+    streamvbyte_decompress_calibrated_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>, false>(state);
+}
+
+template <typename CompressionOptions>
+void compress_blocked_random(benchmark::State& state)
+{
+    streamvbyte_blocked_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>, false>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_blocked_random(benchmark::State& state)
+{
+    streamvbyte_blocked_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>, true>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_range_random(benchmark::State& state)
+{
+    streamvbyte_decompress_range_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void compress_batch_random(benchmark::State& state)
+{
+    streamvbyte_batch_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>, false>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_batch_random(benchmark::State& state)
+{
+    streamvbyte_batch_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>, true>(state);
+}
+
+template <typename CompressionOptions>
+void compress_level_random(benchmark::State& state)
+{
+    streamvbyte_compress_level_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void compress_dictionary_short_reads(benchmark::State& state)
+{
+    streamvbyte_compress_dictionary_benchmark<CompressionOptions, ShortReadGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void compress_prefix_channel_reads(benchmark::State& state)
+{
+    streamvbyte_compress_prefix_benchmark<CompressionOptions, ChannelReadGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_prefix_channel_reads(benchmark::State& state)
+{
+    streamvbyte_decompress_prefix_benchmark<CompressionOptions, ChannelReadGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void compress_adaptive_random(benchmark::State& state)
+{
+    streamvbyte_compress_adaptive_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void compress_adaptive_noise(benchmark::State& state)
+{
+    streamvbyte_compress_adaptive_benchmark<CompressionOptions, NoiseGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_adaptive_random(benchmark::State& state)
+{
+    streamvbyte_decompress_adaptive_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_adaptive_noise(benchmark::State& state)
+{
+    streamvbyte_decompress_adaptive_benchmark<CompressionOptions, NoiseGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void compress_stream_random(benchmark::State& state)
+{
+    streamvbyte_compress_stream_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename CompressionOptions>
+void decompress_stream_random(benchmark::State& state)
+{
+    streamvbyte_decompress_stream_benchmark<CompressionOptions, SignalGenerator<typename CompressionOptions::IntType>>(state);
+}
+
+template <typename StreamVByteOptions>
+void streamvbyte_compress_random(benchmark::State& state)
+{
+    streamvbyte_stage_compress_benchmark<StreamVByteOptions, SignalGenerator<typename StreamVByteOptions::IntType>>(state);
+}
+
+template <typename StreamVByteOptions>
+void streamvbyte_decompress_random(benchmark::State& state)
+{
+    streamvbyte_stage_decompress_benchmark<StreamVByteOptions, SignalGenerator<typename StreamVByteOptions::IntType>>(state);
+}
+
 BENCHMARK_TEMPLATE(compress_sequence, VbzZStd<std::int8_t>);
 BENCHMARK_TEMPLATE(compress_sequence, VbzZStd<std::int16_t>);
 BENCHMARK_TEMPLATE(compress_sequence, VbzZStd<std::int32_t>);
@@ -170,6 +1305,64 @@ BENCHMARK_TEMPLATE(decompress_random, VbzNoZStd<std::int8_t>);
 BENCHMARK_TEMPLATE(decompress_random, VbzNoZStd<std::int16_t>);
 BENCHMARK_TEMPLATE(decompress_random, VbzNoZStd<std::int32_t>);
 
+BENCHMARK_TEMPLATE(compress_random_context, VbzZStd<std::int8_t>);
+BENCHMARK_TEMPLATE(compress_random_context, VbzZStd<std::int16_t>);
+BENCHMARK_TEMPLATE(compress_random_context, VbzZStd<std::int32_t>);
+
+BENCHMARK_TEMPLATE(decompress_random_context, VbzZStd<std::int8_t>);
+BENCHMARK_TEMPLATE(decompress_random_context, VbzZStd<std::int16_t>);
+BENCHMARK_TEMPLATE(decompress_random_context, VbzZStd<std::int32_t>);
+
+BENCHMARK_TEMPLATE(decompress_calibrated_random, VbzZStd<std::int16_t>);
+BENCHMARK_TEMPLATE(decompress_calibrated_random, VbzNoZStd<std::int16_t>);
+BENCHMARK_TEMPLATE(decompress_then_calibrate_random, VbzZStd<std::int16_t>);
+BENCHMARK_TEMPLATE(decompress_then_calibrate_random, VbzNoZStd<std::int16_t>);
+
+BENCHMARK_TEMPLATE(compress_blocked_random, VbzZStd<std::int16_t>)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(decompress_blocked_random, VbzZStd<std::int16_t>)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(compress_batch_random, VbzZStd<std::int16_t>)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(decompress_batch_random, VbzZStd<std::int16_t>)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(compress_level_random, VbzZStd<std::int16_t>)->Arg(-50)->Arg(-5)->Arg(-1)->Arg(1)->Arg(3);
+BENCHMARK_TEMPLATE(compress_dictionary_short_reads, VbzZStd<std::int16_t>)->Arg(0)->Arg(16 * 1024)->Arg(100 * 1024);
+BENCHMARK_TEMPLATE(compress_prefix_channel_reads, VbzZStd<std::int16_t>)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(decompress_prefix_channel_reads, VbzZStd<std::int16_t>)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(compress_adaptive_random, VbzZStd<std::int16_t>)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(compress_adaptive_noise, VbzZStd<std::int16_t>)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(decompress_adaptive_random, VbzZStd<std::int16_t>)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(decompress_adaptive_noise, VbzZStd<std::int16_t>)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(compress_stream_random, VbzZStd<std::int16_t>)->Arg(400)->Arg(4000);
+BENCHMARK_TEMPLATE(compress_stream_random, VbzNoZStd<std::int16_t>)->Arg(400)->Arg(4000);
+BENCHMARK_TEMPLATE(decompress_stream_random, VbzZStd<std::int16_t>)->Arg(400)->Arg(4000);
+BENCHMARK_TEMPLATE(decompress_stream_random, VbzNoZStd<std::int16_t>)->Arg(400)->Arg(4000);
+BENCHMARK_TEMPLATE(decompress_range_random, VbzZStd<std::int16_t>)->Arg(10 * 1000)->Arg(1000 * 1000);
+
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV0<std::int8_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV0<std::int16_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV0<std::int32_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV0<std::int8_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV0<std::int16_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV0<std::int32_t, false>);
+
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV1<std::int8_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV1<std::int16_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV1<std::int32_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV1<std::int8_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV1<std::int16_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_compress_random, StreamVByteV1<std::int32_t, false>);
+
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV0<std::int8_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV0<std::int16_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV0<std::int32_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV0<std::int8_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV0<std::int16_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV0<std::int32_t, false>);
+
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV1<std::int8_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV1<std::int16_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV1<std::int32_t, true>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV1<std::int8_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV1<std::int16_t, false>);
+BENCHMARK_TEMPLATE(streamvbyte_decompress_random, StreamVByteV1<std::int32_t, false>);
 
 // Run the benchmark
 BENCHMARK_MAIN();
@@ -2,11 +2,14 @@
 #include "v1/vbz_streamvbyte.h"
 
 #include "vbz.h"
+#include "vbz_streamvbyte_kernels.h"
 
 #include "test_utils.h"
 
+#include <cstdlib>
 #include <numeric>
 #include <random>
+#include <string>
 
 #include <catch2/catch.hpp>
 
@@ -237,3 +240,356 @@ SCENARIO("streamvbyte int16 encoding with known values.")
         }
     }
 }
+
+SCENARIO("streamvbyte int8 encoding with known values.")
+{
+    // More than 8 values, so both the vectorised and tail paths are exercised.
+    std::vector<std::int8_t> const input_values{ 0, -1, 3, -7, 15, -31, 63, -127, 127, -128, 5, 6, 7, 100, -100, 1, 2, 3, 4 };
+
+    GIVEN("delta zig zag encoding")
+    {
+        std::vector<int8_t> compressed_values_v0{ 0, 64, 21, 16, 0, 0, 1, 8, 19, 44, 91, -68, 123, 1, -4, 1, -3, 1, 10, 1, 2, 2, -70, -113, 1, -54, 2, 2, 2 };
+        perform_int_compressed_value_test(v0_functions, input_values, true, compressed_values_v0);
+    }
+
+    GIVEN("no delta zig zag encoding")
+    {
+        std::vector<int8_t> compressed_values_v0{ -52, -52, 12, 48, 0, 0, -1, -1, -1, -1, 3, -7, -1, -1, -1, 15, -31, -1, -1, -1, 63, -127, -1, -1, -1, 127, -128, -1, -1, -1, 5, 6, 7, 100, -100, -1, -1, -1, 1, 2, 3, 4 };
+        perform_int_compressed_value_test(v0_functions, input_values, false, compressed_values_v0);
+    }
+}
+
+SCENARIO("streamvbyte int16 encoding with known values and no delta zig zag.")
+{
+    std::vector<std::int16_t> const input_values{ 0, -1, 300, -32768, 32767, 1, 2, 255, 256, -256, 4096, -1, 12, 13, 14, 15, 16, 17, 18 };
+    std::vector<int8_t> const compressed_values{ -36, 1, -35, 0, 0, 0, -1, -1, -1, -1, 44, 1, 0, -128, -1, -1, -1, 127, 1, 2, -1, 0, 1, 0, -1, -1, -1, 0, 16, -1, -1, -1, -1, 12, 13, 14, 15, 16, 17, 18 };
+
+    GIVEN("v0 functions")
+    {
+        perform_int_compressed_value_test(v0_functions, input_values, false, compressed_values);
+    }
+
+    GIVEN("v1 functions")
+    {
+        perform_int_compressed_value_test(v1_functions, input_values, false, compressed_values);
+    }
+}
+
+SCENARIO("streamvbyte int32 encoding with known values.")
+{
+    std::vector<std::int32_t> const input_values{ 0, -1, 70000, -70000, 16777216, -16777216, 2147483647, -2147483647 - 1, 1, 2, 3, 1000000, 5, 6, 7, 8, 9, 10, 11 };
+
+    GIVEN("delta zig zag encoding")
+    {
+        std::vector<int8_t> const compressed_values{ -96, 63, -125, 2, 0, 0, 1, -30, 34, 2, -65, 69, 4, -32, 34, 2, 2, -1, -1, -1, 3, 1, 0, 0, -2, 2, -3, -1, -1, -1, 2, 2, 122, -124, 30, 117, -124, 30, 2, 2, 2, 2, 2, 2 };
+
+        GIVEN("v0 functions")
+        {
+            perform_int_compressed_value_test(v0_functions, input_values, true, compressed_values);
+        }
+
+        GIVEN("v1 functions")
+        {
+            perform_int_compressed_value_test(v1_functions, input_values, true, compressed_values);
+        }
+    }
+
+    GIVEN("no delta zig zag encoding")
+    {
+        std::vector<int8_t> const compressed_values{ -20, -1, -128, 0, 0, 0, -1, -1, -1, -1, 112, 17, 1, -112, -18, -2, -1, 0, 0, 0, 1, 0, 0, 0, -1, -1, -1, -1, 127, 0, 0, 0, -128, 1, 2, 3, 64, 66, 15, 5, 6, 7, 8, 9, 10, 11 };
+
+        GIVEN("v0 functions")
+        {
+            perform_int_compressed_value_test(v0_functions, input_values, false, compressed_values);
+        }
+
+        GIVEN("v1 functions")
+        {
+            perform_int_compressed_value_test(v1_functions, input_values, false, compressed_values);
+        }
+    }
+}
+
+SCENARIO("streamvbyte kernel selection")
+{
+    GIVEN("The kernels selected for this machine")
+    {
+        auto const& kernels = vbz_streamvbyte_kernels();
+
+        THEN("Every supported integer size has kernels")
+        {
+            for (int integer_size : { 1, 2, 4 })
+            {
+                auto const index = streamvbyte_kernel_index(integer_size);
+                REQUIRE(index >= 0);
+                for (int use_delta_zig_zag_encoding = 0; use_delta_zig_zag_encoding < 2; ++use_delta_zig_zag_encoding)
+                {
+                    CHECK(kernels.compress_v0[index][use_delta_zig_zag_encoding]);
+                    CHECK(kernels.decompress_v0[index][use_delta_zig_zag_encoding]);
+                    CHECK(kernels.compress_v1[index][use_delta_zig_zag_encoding]);
+                    CHECK(kernels.decompress_v1[index][use_delta_zig_zag_encoding]);
+                }
+            }
+            CHECK(streamvbyte_kernel_index(3) == -1);
+        }
+
+        // Scalar kernels are always built, so forcing them must always succeed.
+        char const* forced_name = std::getenv("VBZ_FORCE_ISA");
+        if (forced_name && std::string(forced_name) == "scalar")
+        {
+            THEN("The forced kernels are used")
+            {
+                CHECK(std::string(kernels.name) == "scalar");
+            }
+        }
+    }
+
+    GIVEN("A CPU without AVX2")
+    {
+        auto const no_avx2 = [](char const* instruction_set) {
+            return std::string(instruction_set) != "avx2" && vbz_cpu_supports(instruction_set);
+        };
+
+        THEN("Forcing an instruction set never selects AVX2 kernels")
+        {
+            CHECK(std::string(vbz_select_streamvbyte_kernels("scalar", no_avx2)) == "scalar");
+            for (char const* forced_name : { "ssse3", "avx2", "unknown" })
+            {
+                INFO("Forced " << forced_name);
+                auto const name = std::string(vbz_select_streamvbyte_kernels(forced_name, no_avx2));
+                CHECK(name != "avx2");
+                CHECK(vbz_cpu_supports(name.c_str()));
+            }
+            CHECK(std::string(vbz_select_streamvbyte_kernels(nullptr, no_avx2)) != "avx2");
+        }
+
+        // Only the selected tier is run, so these kernels are safe to use on this CPU.
+        THEN("The selected kernels round trip data")
+        {
+            for (char const* forced_name : { "scalar", "ssse3" })
+            {
+                auto const name = std::string(vbz_select_streamvbyte_kernels(forced_name, no_avx2));
+                INFO("Forced " << forced_name << ", selected " << name);
+                auto const& kernels = vbz_streamvbyte_kernels_named(name.c_str());
+                CHECK(std::string(kernels.name) == name);
+
+                std::vector<std::int16_t> const input_values{ 5, -3, 1000, -32768, 32767, 0, 7, 7 };
+                auto const input = gsl::make_span((char const*)input_values.data(), input_values.size() * sizeof(std::int16_t));
+                std::vector<char> compressed(vbz_max_streamvbyte_compressed_size_v0(2, vbz_size_t(input.size())));
+                auto const compressed_size = kernels.compress_v0[1][1](input, gsl::make_span(compressed), 0);
+                REQUIRE(!vbz_is_error(compressed_size));
+                compressed.resize(compressed_size);
+
+                std::vector<std::int16_t> decompressed(input_values.size());
+                auto const output = gsl::make_span((char*)decompressed.data(), decompressed.size() * sizeof(std::int16_t));
+                CHECK(kernels.decompress_v0[1][1](gsl::make_span(compressed), output, 0) == input.size());
+                CHECK(decompressed == input_values);
+            }
+        }
+    }
+}
+
+template <typename T>
+void check_converted_decompression(
+    StreamVByteKernels const& kernels,
+    int version,
+    bool use_delta_zig_zag_encoding,
+    std::vector<char> const& compressed,
+    std::vector<T> const& input_values,
+    std::int32_t seed)
+{
+    auto const index = streamvbyte_kernel_index(sizeof(T));
+    auto const decompress_float = version == 0 ? kernels.decompress_float_v0 : kernels.decompress_float_v1;
+    auto const decompress_int32 = version == 0 ? kernels.decompress_int32_v0 : kernels.decompress_int32_v1;
+
+    StreamVByteCalibration const calibration{ 13.0f, 1468.9f / 8192.0f };
+    std::vector<float> expected_floats(input_values.size());
+    std::vector<std::int32_t> expected_int32s(input_values.size());
+    for (std::size_t i = 0; i < input_values.size(); ++i)
+    {
+        expected_floats[i] = (float(input_values[i]) + calibration.offset) * calibration.scale;
+        expected_int32s[i] = input_values[i];
+    }
+
+    std::vector<float> floats(input_values.size());
+    CHECK(decompress_float[index][use_delta_zig_zag_encoding](gsl::make_span(compressed), gsl::make_span(floats), calibration, seed)
+        == floats.size() * sizeof(float));
+    CHECK(floats == expected_floats);
+
+    std::vector<std::int32_t> int32s(input_values.size());
+    CHECK(decompress_int32[index][use_delta_zig_zag_encoding](gsl::make_span(compressed), gsl::make_span(int32s), seed)
+        == int32s.size() * sizeof(std::int32_t));
+    CHECK(int32s == expected_int32s);
+}
+
+template <typename T>
+void perform_kernel_match_test(std::vector<T> const& input_values)
+{
+    auto const& kernels = vbz_streamvbyte_kernels();
+    auto const& scalar_kernels = vbz_streamvbyte_kernels_scalar();
+    INFO("Kernels " << kernels.name);
+
+    auto const index = streamvbyte_kernel_index(sizeof(T));
+    auto const input = gsl::make_span((char const*)input_values.data(), input_values.size() * sizeof(T));
+    auto const max_size = vbz_max_streamvbyte_compressed_size_v0(sizeof(T), vbz_size_t(input.size()));
+
+    for (int version = 0; version < 2; ++version)
+    {
+        for (int use_delta_zig_zag_encoding = 0; use_delta_zig_zag_encoding < 2; ++use_delta_zig_zag_encoding)
+        {
+            for (std::int32_t const seed : { 0, -3, 77 })
+            {
+                INFO("Version " << version << ", delta zig zag " << use_delta_zig_zag_encoding << ", seed " << seed);
+                auto const compress = version == 0 ? kernels.compress_v0 : kernels.compress_v1;
+                auto const decompress = version == 0 ? kernels.decompress_v0 : kernels.decompress_v1;
+                auto const scalar_compress = version == 0 ? scalar_kernels.compress_v0 : scalar_kernels.compress_v1;
+                auto const scalar_decompress = version == 0 ? scalar_kernels.decompress_v0 : scalar_kernels.decompress_v1;
+
+                std::vector<char> compressed(max_size);
+                std::vector<char> scalar_compressed(max_size);
+                auto const compressed_size = compress[index][use_delta_zig_zag_encoding](input, gsl::make_span(compressed), seed);
+                auto const scalar_compressed_size = scalar_compress[index][use_delta_zig_zag_encoding](input, gsl::make_span(scalar_compressed), seed);
+                REQUIRE(!vbz_is_error(compressed_size));
+                REQUIRE(compressed_size == scalar_compressed_size);
+                compressed.resize(compressed_size);
+                scalar_compressed.resize(scalar_compressed_size);
+                CHECK(compressed == scalar_compressed);
+
+                std::vector<T> decompressed(input_values.size());
+                std::vector<T> scalar_decompressed(input_values.size());
+                auto const output = gsl::make_span((char*)decompressed.data(), decompressed.size() * sizeof(T));
+                auto const scalar_output = gsl::make_span((char*)scalar_decompressed.data(), scalar_decompressed.size() * sizeof(T));
+                CHECK(decompress[index][use_delta_zig_zag_encoding](gsl::make_span(compressed), output, seed) == input.size());
+                CHECK(scalar_decompress[index][use_delta_zig_zag_encoding](gsl::make_span(compressed), scalar_output, seed) == input.size());
+                CHECK(decompressed == input_values);
+                CHECK(scalar_decompressed == input_values);
+                check_converted_decompression(kernels, version, use_delta_zig_zag_encoding != 0, compressed, input_values, seed);
+
+                // Streams are checked as they are decoded, truncated or padded streams must still be rejected,
+                // with the same error whichever kernels are used.
+                if (!compressed.empty())
+                {
+                    auto const truncated = gsl::make_span(compressed.data(), compressed.size() - 1);
+                    CHECK(decompress[index][use_delta_zig_zag_encoding](truncated, output, seed) == VBZ_STREAMVBYTE_STREAM_ERROR);
+                    CHECK(scalar_decompress[index][use_delta_zig_zag_encoding](truncated, scalar_output, seed) == VBZ_STREAMVBYTE_STREAM_ERROR);
+
+                    auto const truncated_keys = gsl::make_span(compressed.data(), (input_values.size() + 3) / 4 - 1);
+                    CHECK(decompress[index][use_delta_zig_zag_encoding](truncated_keys, output, seed) == VBZ_STREAMVBYTE_STREAM_ERROR);
+                    CHECK(scalar_decompress[index][use_delta_zig_zag_encoding](truncated_keys, scalar_output, seed) == VBZ_STREAMVBYTE_STREAM_ERROR);
+                }
+
+                compressed.push_back(0);
+                CHECK(decompress[index][use_delta_zig_zag_encoding](gsl::make_span(compressed), output, seed) == VBZ_STREAMVBYTE_STREAM_ERROR);
+                CHECK(scalar_decompress[index][use_delta_zig_zag_encoding](gsl::make_span(compressed), scalar_output, seed) == VBZ_STREAMVBYTE_STREAM_ERROR);
+            }
+        }
+    }
+}
+
+template <typename T>
+void run_kernel_match_test_suite()
+{
+    GIVEN("Random data of lengths around the kernel block sizes")
+    {
+        auto seed = std::random_device()();
+        INFO("Seed " << seed);
+        std::default_random_engine rand(seed);
+        // The full range of T, so int16 deltas overflow 16 bits and must be wrapped the same way by every tier.
+        std::uniform_int_distribution<std::int64_t> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+        std::uniform_int_distribution<std::int64_t> small_dist(-8, 8);
+
+        for (std::size_t length : { 0, 1, 7, 8, 15, 16, 17, 31, 33, 100, 1023, 1025, 10000 })
+        {
+            std::vector<T> random_data(length);
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                // Mix runs of small values into the data so every key code is produced.
+                random_data[i] = T((i / 64) % 2 ? small_dist(rand) : dist(rand));
+            }
+
+            INFO("Length " << length);
+            perform_kernel_match_test(random_data);
+        }
+    }
+}
+
+SCENARIO("streamvbyte kernels match the scalar kernels")
+{
+    GIVEN("int8 data")
+    {
+        run_kernel_match_test_suite<std::int8_t>();
+    }
+
+    GIVEN("int16 data")
+    {
+        run_kernel_match_test_suite<std::int16_t>();
+    }
+
+    GIVEN("int32 data")
+    {
+        run_kernel_match_test_suite<std::int32_t>();
+    }
+}
+
+template <typename T>
+void perform_scalar_stream_decode_test()
+{
+    auto const& kernels = vbz_streamvbyte_kernels();
+    auto const& scalar_kernels = vbz_streamvbyte_kernels_scalar();
+    INFO("Kernels " << kernels.name);
+
+    // Use the full range of T, so deltas taken in 32 bits can need more than sizeof(T) bytes. The scalar
+    // kernels now wrap int16 deltas to 16 bits, but older generic builds wrote 32 bit int16 deltas, which
+    // is what the scalar int32 kernels write for the same values.
+    std::vector<T> input_values(10000);
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+    std::uniform_int_distribution<std::int64_t> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+    for (auto& e : input_values)
+    {
+        e = T(dist(rand));
+    }
+
+    auto const index = streamvbyte_kernel_index(sizeof(T));
+    auto const input = gsl::make_span((char const*)input_values.data(), input_values.size() * sizeof(T));
+    std::vector<std::int32_t> const wide_values(input_values.begin(), input_values.end());
+    auto const wide_input = gsl::make_span((char const*)wide_values.data(), wide_values.size() * sizeof(std::int32_t));
+    for (int version = 0; version < 2; ++version)
+    {
+        INFO("Version " << version);
+        auto const scalar_compress = version == 0 ? scalar_kernels.compress_v0 : scalar_kernels.compress_v1;
+        auto const decompress = version == 0 ? kernels.decompress_v0 : kernels.decompress_v1;
+
+        std::vector<char> compressed(vbz_max_streamvbyte_compressed_size_v0(4, vbz_size_t(wide_input.size())));
+        auto const compressed_size = sizeof(T) == 2
+            ? scalar_compress[streamvbyte_kernel_index(4)][true](wide_input, gsl::make_span(compressed), 0)
+            : scalar_compress[index][true](input, gsl::make_span(compressed), 0);
+        REQUIRE(!vbz_is_error(compressed_size));
+        compressed.resize(compressed_size);
+
+        std::vector<T> decompressed(input_values.size());
+        auto const output = gsl::make_span((char*)decompressed.data(), decompressed.size() * sizeof(T));
+        CHECK(decompress[index][true](gsl::make_span(compressed), output, 0) == input.size());
+        CHECK(decompressed == input_values);
+        check_converted_decompression(kernels, version, true, compressed, input_values, 0);
+    }
+}
+
+SCENARIO("streamvbyte kernels decode delta zig zag streams from the scalar kernels")
+{
+    GIVEN("int8 data")
+    {
+        perform_scalar_stream_decode_test<std::int8_t>();
+    }
+
+    GIVEN("int16 data")
+    {
+        perform_scalar_stream_decode_test<std::int16_t>();
+    }
+
+    GIVEN("int32 data")
+    {
+        perform_scalar_stream_decode_test<std::int32_t>();
+    }
+}
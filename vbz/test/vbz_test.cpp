@@ -1,9 +1,18 @@
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "vbz.h"
+#include "vbz_sized64.h"
 #include "test_utils.h"
 
 #include "test_data.h"
@@ -348,3 +357,1675 @@ SCENARIO("vbz sized compression")
         }
     }
 }
+
+SCENARIO("vbz context compression")
+{
+    GIVEN("A context reused for several compressions")
+    {
+        std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+        REQUIRE(context);
+
+        std::vector<CompressionOptions> const option_list{
+            { true, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION },
+            { true, sizeof(test_data[0]), 0, VBZ_DEFAULT_VERSION },
+            { false, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION },
+            { true, sizeof(test_data[0]), 1, 1 },
+            { false, 0, 1, VBZ_DEFAULT_VERSION },
+        };
+
+        // Vary the size between calls, so buffers have to be both grown and reused.
+        for (auto const element_count : { test_data.size(), std::size_t(10), test_data.size() / 2, std::size_t(0), test_data.size() })
+        {
+            auto const input = gsl::make_span(test_data).subspan(0, element_count);
+            auto const input_data_size = vbz_size_t(input.size_bytes());
+
+            for (auto const& options : option_list)
+            {
+                INFO("Element count " << element_count << ", zig zag " << options.perform_delta_zig_zag
+                    << ", integer size " << options.integer_size << ", zstd " << options.zstd_compression_level
+                    << ", version " << options.vbz_version);
+
+                std::vector<int8_t> expected(vbz_max_compressed_size(input_data_size, &options));
+                auto const expected_size = vbz_compress_sized(
+                    input.data(),
+                    input_data_size,
+                    expected.data(),
+                    vbz_size_t(expected.size()),
+                    &options);
+                REQUIRE(!vbz_is_error(expected_size));
+                expected.resize(expected_size);
+
+                std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+                auto const compressed_size = vbz_compress_sized_ctx(
+                    context.get(),
+                    input.data(),
+                    input_data_size,
+                    compressed.data(),
+                    vbz_size_t(compressed.size()),
+                    &options);
+                REQUIRE(!vbz_is_error(compressed_size));
+                compressed.resize(compressed_size);
+                CHECK(compressed == expected);
+
+                std::vector<std::int16_t> decompressed(element_count);
+                auto const decompressed_size = vbz_decompress_sized_ctx(
+                    context.get(),
+                    compressed.data(),
+                    vbz_size_t(compressed.size()),
+                    decompressed.data(),
+                    vbz_size_t(decompressed.size() * sizeof(decompressed[0])),
+                    &options);
+                REQUIRE(decompressed_size == input_data_size);
+                CHECK(gsl::make_span(decompressed) == input);
+            }
+        }
+    }
+}
+
+template <typename T>
+void perform_calibrated_decompression_test(
+    vbz_context* context,
+    std::vector<T> const& data,
+    CompressionOptions const& options)
+{
+    INFO("Element count " << data.size() << ", zig zag " << options.perform_delta_zig_zag
+        << ", integer size " << options.integer_size << ", zstd " << options.zstd_compression_level
+        << ", version " << options.vbz_version);
+
+    auto const input_data_size = vbz_size_t(data.size() * sizeof(data[0]));
+    std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+    auto const compressed_size = vbz_compress_sized(
+        data.data(),
+        input_data_size,
+        compressed.data(),
+        vbz_size_t(compressed.size()),
+        &options);
+    REQUIRE(!vbz_is_error(compressed_size));
+    compressed.resize(compressed_size);
+
+    VbzCalibration const calibration{ 13.0f, 1468.9f, 8192.0f };
+    auto const scale = calibration.range / calibration.digitisation;
+    std::vector<float> expected_floats(data.size());
+    std::vector<std::int32_t> expected_int32s(data.size());
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        expected_floats[i] = (float(data[i]) + calibration.offset) * scale;
+        expected_int32s[i] = data[i];
+    }
+
+    std::vector<float> floats(data.size());
+    auto const float_size = vbz_decompress_sized_calibrated(
+        compressed.data(),
+        vbz_size_t(compressed.size()),
+        floats.data(),
+        vbz_size_t(floats.size() * sizeof(floats[0])),
+        &options,
+        &calibration);
+    REQUIRE(float_size == floats.size() * sizeof(floats[0]));
+    CHECK(floats == expected_floats);
+
+    std::fill(floats.begin(), floats.end(), 0.0f);
+    auto const context_float_size = vbz_decompress_sized_calibrated_ctx(
+        context,
+        compressed.data(),
+        vbz_size_t(compressed.size()),
+        floats.data(),
+        vbz_size_t(floats.size() * sizeof(floats[0])),
+        &options,
+        &calibration);
+    REQUIRE(context_float_size == floats.size() * sizeof(floats[0]));
+    CHECK(floats == expected_floats);
+
+    std::vector<std::int32_t> int32s(data.size());
+    auto const int32_size = vbz_decompress_sized_int32_ctx(
+        context,
+        compressed.data(),
+        vbz_size_t(compressed.size()),
+        int32s.data(),
+        vbz_size_t(int32s.size() * sizeof(int32s[0])),
+        &options);
+    REQUIRE(int32_size == int32s.size() * sizeof(int32s[0]));
+    CHECK(int32s == expected_int32s);
+
+    if (!data.empty())
+    {
+        CHECK(vbz_decompress_sized_calibrated(
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            floats.data(),
+            vbz_size_t(floats.size() * sizeof(floats[0]) - 1),
+            &options,
+            &calibration) == VBZ_DESTINATION_SIZE_ERROR);
+    }
+}
+
+template <typename T>
+void run_calibrated_decompression_test_suite(std::vector<T> const& data)
+{
+    std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+    REQUIRE(context);
+
+    for (unsigned int version = 0; version < 2; ++version)
+    {
+        for (auto const zstd_level : { 0u, 1u })
+        {
+            for (auto const delta_zig_zag : { false, true })
+            {
+                CompressionOptions const options{ delta_zig_zag, sizeof(T), zstd_level, version };
+                perform_calibrated_decompression_test(context.get(), data, options);
+            }
+        }
+    }
+}
+
+template <typename T>
+std::vector<T> make_random_signal(std::default_random_engine& rand, std::size_t size)
+{
+    std::uniform_int_distribution<std::int64_t> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+
+    std::vector<T> data(size);
+    for (auto& e : data)
+    {
+        e = T(dist(rand));
+    }
+    return data;
+}
+
+SCENARIO("vbz calibrated decompression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Test data from a realistic dataset")
+    {
+        run_calibrated_decompression_test_suite(test_data);
+    }
+
+    GIVEN("Random int8 data")
+    {
+        for (std::size_t size : { 0, 1, 17, 1000, 5000 })
+        {
+            run_calibrated_decompression_test_suite(make_random_signal<std::int8_t>(rand, size));
+        }
+    }
+
+    GIVEN("Random int16 data")
+    {
+        for (std::size_t size : { 0, 1, 17, 1000, 5000 })
+        {
+            run_calibrated_decompression_test_suite(make_random_signal<std::int16_t>(rand, size));
+        }
+    }
+
+    GIVEN("Random int32 data")
+    {
+        for (std::size_t size : { 0, 1, 17, 1000, 5000 })
+        {
+            run_calibrated_decompression_test_suite(make_random_signal<std::int32_t>(rand, size));
+        }
+    }
+
+    GIVEN("Data stored without streamvbyte")
+    {
+        std::vector<std::int16_t> data{ 1, 2, 3 };
+        CompressionOptions const options{ false, 0, 1, VBZ_DEFAULT_VERSION };
+        std::vector<int8_t> compressed(vbz_max_compressed_size(vbz_size_t(data.size() * sizeof(data[0])), &options));
+        auto const compressed_size = vbz_compress_sized(
+            data.data(),
+            vbz_size_t(data.size() * sizeof(data[0])),
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options);
+        REQUIRE(!vbz_is_error(compressed_size));
+
+        THEN("Values cannot be converted, as their type is unknown")
+        {
+            VbzCalibration const calibration{ 0.0f, 1.0f, 1.0f };
+            std::vector<float> floats(data.size());
+            CHECK(vbz_decompress_sized_calibrated(
+                compressed.data(),
+                compressed_size,
+                floats.data(),
+                vbz_size_t(floats.size() * sizeof(floats[0])),
+                &options,
+                &calibration) == VBZ_INTEGER_SIZE_ERROR);
+        }
+    }
+}
+
+template <typename T>
+void perform_blocked_compression_test(
+    std::vector<T> const& data,
+    CompressionOptions const& options,
+    vbz_size_t block_size)
+{
+    INFO("Element count " << data.size() << ", block size " << block_size << ", zig zag " << options.perform_delta_zig_zag
+        << ", integer size " << options.integer_size << ", zstd " << options.zstd_compression_level
+        << ", version " << options.vbz_version);
+
+    auto const input_data_size = vbz_size_t(data.size() * sizeof(data[0]));
+    auto const max_size = vbz_max_compressed_size_blocked(input_data_size, &options, block_size);
+    REQUIRE(!vbz_is_error(max_size));
+
+    std::vector<int8_t> expected;
+    for (unsigned int thread_count = 1; thread_count <= 4; ++thread_count)
+    {
+        INFO("Thread count " << thread_count);
+        std::vector<int8_t> compressed(max_size);
+        auto const compressed_size = vbz_compress_blocked(
+            data.data(),
+            input_data_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options,
+            block_size,
+            thread_count);
+        REQUIRE(!vbz_is_error(compressed_size));
+        compressed.resize(compressed_size);
+
+        // The frame must not depend on how blocks were shared between threads.
+        if (expected.empty())
+        {
+            expected = compressed;
+        }
+        CHECK(compressed == expected);
+
+        CHECK(vbz_decompressed_size(compressed.data(), vbz_size_t(compressed.size()), &options) == input_data_size);
+
+        std::vector<T> decompressed(data.size());
+        auto const decompressed_size = vbz_decompress_blocked(
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            decompressed.data(),
+            vbz_size_t(decompressed.size() * sizeof(decompressed[0])),
+            &options,
+            thread_count);
+        REQUIRE(decompressed_size == input_data_size);
+        CHECK(decompressed == data);
+
+        if (!data.empty())
+        {
+            CHECK(vbz_is_error(vbz_decompress_blocked(
+                compressed.data(),
+                vbz_size_t(compressed.size() - 1),
+                decompressed.data(),
+                vbz_size_t(decompressed.size() * sizeof(decompressed[0])),
+                &options,
+                thread_count)));
+        }
+    }
+}
+
+template <typename T>
+void run_blocked_compression_test_suite(std::vector<T> const& data)
+{
+    std::vector<CompressionOptions> const option_list{
+        { true, sizeof(T), 1, VBZ_DEFAULT_VERSION },
+        { true, sizeof(T), 0, VBZ_DEFAULT_VERSION },
+        { false, sizeof(T), 1, VBZ_DEFAULT_VERSION },
+        { true, sizeof(T), 1, 1 },
+        { false, 0, 1, VBZ_DEFAULT_VERSION },
+    };
+
+    for (auto const& options : option_list)
+    {
+        for (vbz_size_t block_size : { 7, 100, 4096, 0 })
+        {
+            perform_blocked_compression_test(data, options, block_size);
+        }
+    }
+}
+
+SCENARIO("vbz blocked compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Test data from a realistic dataset")
+    {
+        run_blocked_compression_test_suite(test_data);
+    }
+
+    GIVEN("Random int8 data")
+    {
+        for (std::size_t size : { 0, 1, 1000 })
+        {
+            run_blocked_compression_test_suite(make_random_signal<std::int8_t>(rand, size));
+        }
+    }
+
+    GIVEN("Random int32 data")
+    {
+        for (std::size_t size : { 0, 1, 1000 })
+        {
+            run_blocked_compression_test_suite(make_random_signal<std::int32_t>(rand, size));
+        }
+    }
+
+    GIVEN("Data which fits in one block")
+    {
+        CompressionOptions const options{ true, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION };
+        auto const input_data_size = vbz_size_t(test_data.size() * sizeof(test_data[0]));
+
+        std::vector<int8_t> blocked(vbz_max_compressed_size_blocked(input_data_size, &options, 0));
+        auto const blocked_size = vbz_compress_blocked(
+            test_data.data(),
+            input_data_size,
+            blocked.data(),
+            vbz_size_t(blocked.size()),
+            &options,
+            0,
+            2);
+        REQUIRE(!vbz_is_error(blocked_size));
+
+        std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+        auto const compressed_size = vbz_compress(
+            test_data.data(),
+            input_data_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options);
+        REQUIRE(!vbz_is_error(compressed_size));
+
+        THEN("The block is compressed as vbz_compress would compress it, after the header and index")
+        {
+            auto const frame_overhead = 3 * sizeof(vbz_size_t) + 3 * sizeof(vbz_size_t);
+            REQUIRE(blocked_size == compressed_size + frame_overhead);
+            CHECK(std::equal(compressed.begin(), compressed.begin() + compressed_size, blocked.begin() + frame_overhead));
+        }
+    }
+}
+
+SCENARIO("vbz range decompression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Test data compressed into blocks")
+    {
+        std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+        REQUIRE(context);
+
+        std::vector<CompressionOptions> const option_list{
+            { true, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION },
+            { true, sizeof(test_data[0]), 0, VBZ_DEFAULT_VERSION },
+            { true, sizeof(test_data[0]), 1, 1 },
+            { false, 0, 1, VBZ_DEFAULT_VERSION },
+        };
+
+        for (auto const& options : option_list)
+        {
+            INFO("Zig zag " << options.perform_delta_zig_zag << ", integer size " << options.integer_size
+                << ", zstd " << options.zstd_compression_level << ", version " << options.vbz_version);
+
+            auto const input_data_size = vbz_size_t(test_data.size() * sizeof(test_data[0]));
+            std::vector<int8_t> compressed(vbz_max_compressed_size_blocked(input_data_size, &options, 100));
+            auto const compressed_size = vbz_compress_blocked(
+                test_data.data(),
+                input_data_size,
+                compressed.data(),
+                vbz_size_t(compressed.size()),
+                &options,
+                100,
+                2);
+            REQUIRE(!vbz_is_error(compressed_size));
+            compressed.resize(compressed_size);
+
+            // Ranges are counted in integers, or bytes when streamvbyte is disabled.
+            auto const sample_size = std::max<std::size_t>(options.integer_size, 1);
+            auto const sample_total = input_data_size / sample_size;
+            auto const input_bytes = reinterpret_cast<char const*>(test_data.data());
+
+            std::vector<std::pair<std::size_t, std::size_t>> ranges{
+                { 0, 0 }, { 0, 1 }, { 99, 2 }, { 100, 100 }, { 150, 1000 }, { sample_total - 1, 1 }, { 0, sample_total },
+            };
+            std::uniform_int_distribution<std::size_t> first_dist(0, sample_total);
+            for (int i = 0; i < 20; ++i)
+            {
+                auto const first = first_dist(rand);
+                std::uniform_int_distribution<std::size_t> count_dist(0, std::min<std::size_t>(sample_total - first, 500));
+                ranges.emplace_back(first, count_dist(rand));
+            }
+
+            for (auto const& range : ranges)
+            {
+                INFO("First sample " << range.first << ", sample count " << range.second);
+                std::vector<char> expected(input_bytes + range.first * sample_size, input_bytes + (range.first + range.second) * sample_size);
+
+                std::vector<char> decompressed(expected.size());
+                auto const decompressed_size = vbz_decompress_range_ctx(
+                    context.get(),
+                    compressed.data(),
+                    vbz_size_t(compressed.size()),
+                    vbz_size_t(range.first),
+                    vbz_size_t(range.second),
+                    decompressed.data(),
+                    vbz_size_t(decompressed.size()),
+                    &options);
+                REQUIRE(decompressed_size == expected.size());
+                CHECK(decompressed == expected);
+
+                std::fill(decompressed.begin(), decompressed.end(), 0);
+                CHECK(vbz_decompress_range(
+                    compressed.data(),
+                    vbz_size_t(compressed.size()),
+                    vbz_size_t(range.first),
+                    vbz_size_t(range.second),
+                    decompressed.data(),
+                    vbz_size_t(decompressed.size()),
+                    &options) == expected.size());
+                CHECK(decompressed == expected);
+            }
+
+            std::vector<char> decompressed(sample_size * 2);
+            CHECK(vbz_decompress_range(
+                compressed.data(),
+                vbz_size_t(compressed.size()),
+                vbz_size_t(sample_total - 1),
+                2,
+                decompressed.data(),
+                vbz_size_t(decompressed.size()),
+                &options) == VBZ_INPUT_SIZE_ERROR);
+            CHECK(vbz_decompress_range(
+                compressed.data(),
+                vbz_size_t(compressed.size()),
+                0,
+                2,
+                decompressed.data(),
+                vbz_size_t(decompressed.size() - 1),
+                &options) == VBZ_DESTINATION_SIZE_ERROR);
+        }
+    }
+}
+
+SCENARIO("vbz 64 bit sized compression")
+{
+    std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+    REQUIRE(context);
+
+    std::vector<CompressionOptions> const option_list{
+        { true, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION },
+        { true, sizeof(test_data[0]), 0, VBZ_DEFAULT_VERSION },
+        { false, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION },
+        { true, sizeof(test_data[0]), 1, 1 },
+        { false, 0, 1, VBZ_DEFAULT_VERSION },
+    };
+    auto const input_data_size = vbz_size64_t(test_data.size() * sizeof(test_data[0]));
+
+    GIVEN("Data small enough for a 32 bit sized frame")
+    {
+        for (auto const& options : option_list)
+        {
+            INFO("Zig zag " << options.perform_delta_zig_zag << ", integer size " << options.integer_size
+                << ", zstd " << options.zstd_compression_level << ", version " << options.vbz_version);
+
+            std::vector<int8_t> compressed(vbz_max_compressed_size64(input_data_size, &options));
+            auto const compressed_size = vbz_compress64(
+                test_data.data(),
+                input_data_size,
+                compressed.data(),
+                compressed.size(),
+                &options);
+            REQUIRE(!vbz_is_error64(compressed_size));
+            compressed.resize(std::size_t(compressed_size));
+
+            THEN("The frame can be read by the 32 bit functions")
+            {
+                std::vector<int8_t> expected(vbz_max_compressed_size(vbz_size_t(input_data_size), &options));
+                auto const expected_size = vbz_compress_sized(
+                    test_data.data(),
+                    vbz_size_t(input_data_size),
+                    expected.data(),
+                    vbz_size_t(expected.size()),
+                    &options);
+                REQUIRE(!vbz_is_error(expected_size));
+                expected.resize(expected_size);
+                CHECK(compressed == expected);
+
+                std::vector<std::int16_t> decompressed(test_data.size());
+                CHECK(vbz_decompressed_size64(compressed.data(), compressed.size(), &options) == input_data_size);
+                CHECK(vbz_decompress64_ctx(
+                    context.get(),
+                    compressed.data(),
+                    compressed.size(),
+                    decompressed.data(),
+                    decompressed.size() * sizeof(decompressed[0]),
+                    &options) == input_data_size);
+                CHECK(decompressed == test_data);
+            }
+        }
+    }
+
+    GIVEN("Data split into pieces")
+    {
+        for (auto const& options : option_list)
+        {
+            for (vbz_size_t piece_size : { 4, 400, 4096 })
+            {
+                INFO("Piece size " << piece_size << ", zig zag " << options.perform_delta_zig_zag << ", integer size "
+                    << options.integer_size << ", zstd " << options.zstd_compression_level << ", version " << options.vbz_version);
+
+                std::vector<int8_t> compressed(vbz_max_compressed_size64_pieces(input_data_size, &options, piece_size));
+                auto const compressed_size = vbz_compress64_pieces(
+                    context.get(),
+                    test_data.data(),
+                    input_data_size,
+                    compressed.data(),
+                    compressed.size(),
+                    &options,
+                    piece_size);
+                REQUIRE(!vbz_is_error64(compressed_size));
+                compressed.resize(std::size_t(compressed_size));
+
+                CHECK(vbz_decompressed_size64(compressed.data(), compressed.size(), &options) == input_data_size);
+
+                std::vector<std::int16_t> decompressed(test_data.size());
+                CHECK(vbz_decompress64(
+                    compressed.data(),
+                    compressed.size(),
+                    decompressed.data(),
+                    decompressed.size() * sizeof(decompressed[0]),
+                    &options) == input_data_size);
+                CHECK(decompressed == test_data);
+
+                auto const truncated_result = vbz_decompress64(
+                    compressed.data(),
+                    compressed.size() - 1,
+                    decompressed.data(),
+                    decompressed.size() * sizeof(decompressed[0]),
+                    &options);
+                CHECK(vbz_is_error64(truncated_result));
+                CHECK(vbz_is_error(vbz_size_t(truncated_result)));
+
+                CHECK(vbz_decompress64(
+                    compressed.data(),
+                    compressed.size(),
+                    decompressed.data(),
+                    decompressed.size() * sizeof(decompressed[0]) - 1,
+                    &options) == vbz_size64_t(std::int64_t(std::int32_t(VBZ_DESTINATION_SIZE_ERROR))));
+            }
+        }
+    }
+}
+
+template <typename T>
+void perform_stream_compression_test(
+    vbz_cstream* stream,
+    vbz_context* context,
+    std::default_random_engine& rand,
+    std::vector<T> const& data,
+    CompressionOptions const& options)
+{
+    INFO("Element count " << data.size() << ", zig zag " << options.perform_delta_zig_zag
+        << ", integer size " << options.integer_size << ", zstd " << options.zstd_compression_level
+        << ", version " << options.vbz_version);
+
+    // Push samples a few at a time, in uneven amounts.
+    auto const sample_size = std::max<std::size_t>(options.integer_size, 1);
+    auto const input_data_size = data.size() * sizeof(data[0]);
+    auto const sample_total = input_data_size / sample_size;
+    auto const input_bytes = reinterpret_cast<char const*>(data.data());
+    std::uniform_int_distribution<std::size_t> push_dist(0, 3000);
+
+    REQUIRE(vbz_cstream_begin(stream, &options) == 0);
+    for (std::size_t pushed = 0; pushed < sample_total;)
+    {
+        auto const count = std::min(sample_total - pushed, push_dist(rand));
+        REQUIRE(vbz_cstream_push_samples(stream, input_bytes + pushed * sample_size, vbz_size_t(count)) == count);
+        pushed += count;
+    }
+
+    std::vector<int8_t> compressed(vbz_cstream_max_compressed_size(stream));
+    auto const compressed_size = vbz_cstream_end(stream, context, compressed.data(), vbz_size_t(compressed.size()));
+    REQUIRE(!vbz_is_error(compressed_size));
+    compressed.resize(compressed_size);
+
+    std::vector<T> decompressed(data.size());
+    auto const decompressed_size = vbz_decompress_sized(
+        compressed.data(),
+        vbz_size_t(compressed.size()),
+        decompressed.data(),
+        vbz_size_t(decompressed.size() * sizeof(decompressed[0])),
+        &options);
+    REQUIRE(decompressed_size == input_data_size);
+    CHECK(decompressed == data);
+
+    // Without zstd, the streamvbyte stream must match one compressed in a single call.
+    if (options.zstd_compression_level == 0)
+    {
+        std::vector<int8_t> expected(vbz_max_compressed_size(vbz_size_t(input_data_size), &options));
+        auto const expected_size = vbz_compress_sized(
+            data.data(),
+            vbz_size_t(input_data_size),
+            expected.data(),
+            vbz_size_t(expected.size()),
+            &options);
+        REQUIRE(!vbz_is_error(expected_size));
+        expected.resize(expected_size);
+        CHECK(compressed == expected);
+    }
+}
+
+template <typename T>
+void run_stream_compression_test_suite(std::default_random_engine& rand, std::vector<T> const& data)
+{
+    std::unique_ptr<vbz_cstream, decltype(&vbz_free_cstream)> stream(vbz_create_cstream(), vbz_free_cstream);
+    REQUIRE(stream);
+    std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+    REQUIRE(context);
+
+    for (unsigned int version = 0; version < 2; ++version)
+    {
+        for (auto const zstd_level : { 0u, 1u })
+        {
+            for (auto const delta_zig_zag : { false, true })
+            {
+                CompressionOptions const options{ delta_zig_zag, sizeof(T), zstd_level, version };
+                perform_stream_compression_test(stream.get(), context.get(), rand, data, options);
+            }
+        }
+    }
+
+    CompressionOptions const raw_options{ false, 0, 1, VBZ_DEFAULT_VERSION };
+    perform_stream_compression_test(stream.get(), nullptr, rand, data, raw_options);
+}
+
+SCENARIO("vbz streaming compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Test data from a realistic dataset")
+    {
+        run_stream_compression_test_suite(rand, test_data);
+    }
+
+    GIVEN("Random int8 data")
+    {
+        // 70001 samples spread keys and nibble data over several section blocks.
+        for (std::size_t size : { 0, 1, 1023, 1025, 5001, 70001 })
+        {
+            run_stream_compression_test_suite(rand, make_random_signal<std::int8_t>(rand, size));
+        }
+    }
+
+    GIVEN("Random int32 data")
+    {
+        for (std::size_t size : { 0, 1, 1025, 5001 })
+        {
+            run_stream_compression_test_suite(rand, make_random_signal<std::int32_t>(rand, size));
+        }
+    }
+
+    GIVEN("A destination too small for the frame")
+    {
+        std::unique_ptr<vbz_cstream, decltype(&vbz_free_cstream)> stream(vbz_create_cstream(), vbz_free_cstream);
+        REQUIRE(stream);
+
+        auto const data = make_random_signal<std::int16_t>(rand, 50000);
+        CompressionOptions const options{ true, sizeof(data[0]), 1, VBZ_DEFAULT_VERSION };
+        REQUIRE(vbz_cstream_begin(stream.get(), &options) == 0);
+        REQUIRE(vbz_cstream_push_samples(stream.get(), data.data(), vbz_size_t(data.size())) == data.size());
+
+        std::vector<int8_t> compressed(vbz_cstream_max_compressed_size(stream.get()));
+        CHECK(vbz_cstream_end(stream.get(), nullptr, compressed.data(), 1000) == VBZ_DESTINATION_SIZE_ERROR);
+
+        // The frame is left in progress, so can be ended again with enough room.
+        auto const compressed_size = vbz_cstream_end(stream.get(), nullptr, compressed.data(), vbz_size_t(compressed.size()));
+        REQUIRE(!vbz_is_error(compressed_size));
+
+        std::vector<std::int16_t> decompressed(data.size());
+        auto const decompressed_size = vbz_decompress_sized(
+            compressed.data(),
+            compressed_size,
+            decompressed.data(),
+            vbz_size_t(decompressed.size() * sizeof(decompressed[0])),
+            &options);
+        REQUIRE(decompressed_size == data.size() * sizeof(data[0]));
+        CHECK(decompressed == data);
+    }
+
+    GIVEN("A stream which has not begun")
+    {
+        std::unique_ptr<vbz_cstream, decltype(&vbz_free_cstream)> stream(vbz_create_cstream(), vbz_free_cstream);
+        REQUIRE(stream);
+
+        std::int16_t const sample = 1;
+        std::vector<int8_t> compressed(16);
+        CHECK(vbz_cstream_push_samples(stream.get(), &sample, 1) == VBZ_INPUT_SIZE_ERROR);
+        CHECK(vbz_cstream_end(stream.get(), nullptr, compressed.data(), vbz_size_t(compressed.size())) == VBZ_INPUT_SIZE_ERROR);
+    }
+}
+
+template <typename T>
+void perform_stream_decompression_test(
+    vbz_dstream* stream,
+    std::default_random_engine& rand,
+    std::vector<T> const& data,
+    CompressionOptions const& options)
+{
+    auto const input_size = vbz_size_t(data.size() * sizeof(data[0]));
+    std::vector<int8_t> compressed(vbz_max_compressed_size(input_size, &options));
+    auto const compressed_size = vbz_compress_sized(
+        data.data(),
+        input_size,
+        compressed.data(),
+        vbz_size_t(compressed.size()),
+        &options
+    );
+    REQUIRE(!vbz_is_error(compressed_size));
+    compressed.resize(compressed_size);
+
+    WHEN("Reading the frame in random sized windows")
+    {
+        INFO("Options " << options.vbz_version << " " << options.zstd_compression_level << " " << options.perform_delta_zig_zag);
+        REQUIRE(vbz_dstream_begin(stream, compressed.data(), compressed_size, &options) == data.size());
+
+        std::uniform_int_distribution<std::size_t> window_size(1, 5000);
+        std::vector<T> decompressed;
+        std::vector<T> window;
+        for (;;)
+        {
+            window.resize(window_size(rand));
+            auto const read = vbz_dstream_read_samples(stream, window.data(), vbz_size_t(window.size()));
+            REQUIRE(!vbz_is_error(read));
+            decompressed.insert(decompressed.end(), window.begin(), window.begin() + read);
+            if (read < window.size())
+            {
+                break;
+            }
+        }
+        CHECK(decompressed == data);
+        CHECK(vbz_dstream_read_samples(stream, window.data(), vbz_size_t(window.size())) == 0);
+    }
+
+    WHEN("Reading a truncated frame")
+    {
+        if (compressed_size > sizeof(vbz_size_t) + 1)
+        {
+            auto const truncated_size = compressed_size - 1;
+            auto result = vbz_dstream_begin(stream, compressed.data(), truncated_size, &options);
+            std::vector<T> window(data.size());
+            while (!vbz_is_error(result) && result != 0)
+            {
+                result = vbz_dstream_read_samples(stream, window.data(), vbz_size_t(window.size()));
+            }
+            CHECK(vbz_is_error(result));
+        }
+    }
+}
+
+template <typename T>
+void run_stream_decompression_test_suite(std::default_random_engine& rand, std::vector<T> const& data)
+{
+    std::unique_ptr<vbz_dstream, decltype(&vbz_free_dstream)> stream(vbz_create_dstream(), vbz_free_dstream);
+    REQUIRE(stream);
+
+    for (unsigned int version = 0; version < 2; ++version)
+    {
+        for (auto const zstd_level : { 0u, 1u })
+        {
+            for (auto const delta_zig_zag : { false, true })
+            {
+                CompressionOptions const options{ delta_zig_zag, sizeof(T), zstd_level, version };
+                perform_stream_decompression_test(stream.get(), rand, data, options);
+            }
+        }
+    }
+
+    CompressionOptions const raw_options{ false, 0, 1, VBZ_DEFAULT_VERSION };
+    perform_stream_decompression_test(stream.get(), rand, data, raw_options);
+}
+
+SCENARIO("vbz streaming decompression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Test data from a realistic dataset")
+    {
+        run_stream_decompression_test_suite(rand, test_data);
+    }
+
+    GIVEN("Random int8 data")
+    {
+        for (std::size_t size : { 0, 1, 4095, 4097, 100001 })
+        {
+            run_stream_decompression_test_suite(rand, make_random_signal<std::int8_t>(rand, size));
+        }
+    }
+
+    GIVEN("Random int32 data")
+    {
+        for (std::size_t size : { 0, 1, 4097, 50001 })
+        {
+            run_stream_decompression_test_suite(rand, make_random_signal<std::int32_t>(rand, size));
+        }
+    }
+
+    GIVEN("A stream which has not begun")
+    {
+        std::unique_ptr<vbz_dstream, decltype(&vbz_free_dstream)> stream(vbz_create_dstream(), vbz_free_dstream);
+        REQUIRE(stream);
+
+        std::int16_t sample = 0;
+        CHECK(vbz_dstream_read_samples(stream.get(), &sample, 1) == VBZ_INPUT_SIZE_ERROR);
+    }
+}
+
+template <typename T>
+void run_batch_compression_test_suite(std::vector<std::vector<T>> const& items)
+{
+    std::vector<void const*> sources;
+    std::vector<vbz_size_t> source_sizes;
+    for (auto const& item : items)
+    {
+        sources.push_back(item.data());
+        source_sizes.push_back(vbz_size_t(item.size() * sizeof(T)));
+    }
+    auto const item_count = vbz_size_t(items.size());
+
+    for (auto const zstd_level : { 0u, 1u })
+    {
+        CompressionOptions const options{ true, sizeof(T), zstd_level, VBZ_DEFAULT_VERSION };
+
+        vbz_size64_t max_size = 0;
+        for (auto const source_size : source_sizes)
+        {
+            max_size += vbz_max_compressed_size(source_size, &options);
+        }
+        CHECK(vbz_max_compressed_size_batch(source_sizes.data(), item_count, &options) == max_size);
+
+        std::vector<int8_t> compressed(vbz_max_compressed_size_batch(source_sizes.data(), item_count, &options));
+        std::vector<vbz_size64_t> compressed_offsets(items.size() + 1);
+        auto const compressed_size = vbz_compress_batch(
+            sources.data(),
+            source_sizes.data(),
+            item_count,
+            compressed.data(),
+            compressed.size(),
+            compressed_offsets.data(),
+            &options,
+            3);
+        REQUIRE(!vbz_is_error64(compressed_size));
+        CHECK(compressed_offsets.back() == compressed_size);
+
+        THEN("Each item is compressed as vbz_compress_sized would compress it")
+        {
+            for (std::size_t item = 0; item < items.size(); ++item)
+            {
+                std::vector<int8_t> sized(vbz_max_compressed_size(source_sizes[item], &options));
+                auto const sized_size = vbz_compress_sized(
+                    sources[item],
+                    source_sizes[item],
+                    sized.data(),
+                    vbz_size_t(sized.size()),
+                    &options);
+                REQUIRE(!vbz_is_error(sized_size));
+                REQUIRE(compressed_offsets[item + 1] - compressed_offsets[item] == sized_size);
+                CHECK(std::equal(sized.begin(), sized.begin() + sized_size, compressed.begin() + std::ptrdiff_t(compressed_offsets[item])));
+            }
+        }
+
+        THEN("The output does not depend on the thread count")
+        {
+            std::vector<int8_t> single_threaded(compressed.size());
+            std::vector<vbz_size64_t> single_threaded_offsets(items.size() + 1);
+            auto const single_threaded_size = vbz_compress_batch(
+                sources.data(),
+                source_sizes.data(),
+                item_count,
+                single_threaded.data(),
+                single_threaded.size(),
+                single_threaded_offsets.data(),
+                &options,
+                1);
+            REQUIRE(single_threaded_size == compressed_size);
+            CHECK(single_threaded_offsets == compressed_offsets);
+            CHECK(std::equal(compressed.begin(), compressed.begin() + std::ptrdiff_t(compressed_size), single_threaded.begin()));
+        }
+
+        THEN("The batch decompresses to the original items")
+        {
+            std::vector<void const*> compressed_sources;
+            std::vector<vbz_size_t> compressed_sizes;
+            for (std::size_t item = 0; item < items.size(); ++item)
+            {
+                compressed_sources.push_back(compressed.data() + compressed_offsets[item]);
+                compressed_sizes.push_back(vbz_size_t(compressed_offsets[item + 1] - compressed_offsets[item]));
+            }
+
+            auto const decompressed_size = vbz_decompressed_size_batch(
+                compressed_sources.data(),
+                compressed_sizes.data(),
+                item_count,
+                &options);
+            REQUIRE(!vbz_is_error64(decompressed_size));
+
+            std::vector<T> decompressed(std::size_t(decompressed_size / sizeof(T)));
+            std::vector<vbz_size64_t> decompressed_offsets(items.size() + 1);
+            auto const result = vbz_decompress_batch(
+                compressed_sources.data(),
+                compressed_sizes.data(),
+                item_count,
+                decompressed.data(),
+                decompressed_size,
+                decompressed_offsets.data(),
+                &options,
+                3);
+            REQUIRE(result == decompressed_size);
+
+            for (std::size_t item = 0; item < items.size(); ++item)
+            {
+                auto const begin = decompressed.begin() + std::ptrdiff_t(decompressed_offsets[item] / sizeof(T));
+                CHECK(std::vector<T>(begin, begin + std::ptrdiff_t(items[item].size())) == items[item]);
+            }
+        }
+
+        THEN("A destination which is too small is rejected")
+        {
+            std::vector<vbz_size64_t> offsets(items.size() + 1);
+            auto const result = vbz_compress_batch(
+                sources.data(),
+                source_sizes.data(),
+                item_count,
+                compressed.data(),
+                compressed.size() - 1,
+                offsets.data(),
+                &options,
+                3);
+            CHECK(vbz_size_t(result) == VBZ_DESTINATION_SIZE_ERROR);
+        }
+    }
+}
+
+SCENARIO("vbz batch compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Reads of different lengths")
+    {
+        std::vector<std::vector<std::int16_t>> items{ test_data, {} };
+        for (std::size_t size : { 1, 30000, 5, 200000, 1000 })
+        {
+            items.push_back(make_random_signal<std::int16_t>(rand, size));
+        }
+        run_batch_compression_test_suite(items);
+    }
+
+    GIVEN("Random int8 reads")
+    {
+        std::vector<std::vector<std::int8_t>> items;
+        for (std::size_t size : { 1000, 7, 5000 })
+        {
+            items.push_back(make_random_signal<std::int8_t>(rand, size));
+        }
+        run_batch_compression_test_suite(items);
+    }
+}
+
+template <typename T>
+void perform_described_compression_test(std::vector<T> const& data, CompressionOptions const& options)
+{
+    GIVEN("Compression options " << options.vbz_version << " " << options.integer_size << " " << options.zstd_compression_level << " " << options.perform_delta_zig_zag)
+    {
+        auto const input_data_size = vbz_size_t(data.size() * sizeof(data[0]));
+        std::vector<int8_t> described(vbz_max_compressed_size(input_data_size, &options) + VBZ_DESCRIBED_HEADER_SIZE);
+        auto const described_size = vbz_compress_described(
+            data.data(),
+            input_data_size,
+            described.data(),
+            vbz_size_t(described.size()),
+            &options);
+        REQUIRE(!vbz_is_error(described_size));
+
+        THEN("The data is stored as vbz_compress_sized would store it, after the header")
+        {
+            std::vector<int8_t> sized(vbz_max_compressed_size(input_data_size, &options));
+            auto const sized_size = vbz_compress_sized(
+                data.data(),
+                input_data_size,
+                sized.data(),
+                vbz_size_t(sized.size()),
+                &options);
+            REQUIRE(described_size == sized_size + VBZ_DESCRIBED_HEADER_SIZE - sizeof(vbz_size_t));
+            CHECK(std::equal(sized.begin(), sized.begin() + sized_size, described.begin() + VBZ_DESCRIBED_HEADER_SIZE - sizeof(vbz_size_t)));
+        }
+
+        THEN("The frame info matches the options and size")
+        {
+            VbzFrameInfo info;
+            REQUIRE(vbz_frame_info(described.data(), described_size, &info) == 0);
+            CHECK(info.options.perform_delta_zig_zag == options.perform_delta_zig_zag);
+            CHECK(info.options.integer_size == options.integer_size);
+            CHECK(info.options.zstd_compression_level == options.zstd_compression_level);
+            CHECK(info.options.vbz_version == options.vbz_version);
+            CHECK(info.original_size == input_data_size);
+        }
+
+        THEN("The frame decompresses without the options")
+        {
+            std::vector<T> decompressed(data.size());
+            auto const decompressed_size = vbz_decompress_auto(
+                described.data(),
+                described_size,
+                decompressed.data(),
+                input_data_size);
+            REQUIRE(decompressed_size == input_data_size);
+            CHECK(decompressed == data);
+        }
+    }
+}
+
+template <typename T>
+void run_described_compression_test_suite(std::vector<T> const& data)
+{
+    for (unsigned int version = 0; version < 2; ++version)
+    {
+        for (auto const zstd_level : { 0u, 1u })
+        {
+            for (auto const delta_zig_zag : { false, true })
+            {
+                perform_described_compression_test(data, CompressionOptions{ delta_zig_zag, sizeof(T), zstd_level, version });
+            }
+        }
+    }
+    perform_described_compression_test(data, CompressionOptions{ false, 0, 3, VBZ_DEFAULT_VERSION });
+}
+
+SCENARIO("vbz described compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    GIVEN("Test data from a realistic dataset")
+    {
+        run_described_compression_test_suite(test_data);
+    }
+
+    GIVEN("Random int8 data")
+    {
+        run_described_compression_test_suite(make_random_signal<std::int8_t>(rand, 1000));
+    }
+
+    GIVEN("Random int32 data")
+    {
+        run_described_compression_test_suite(make_random_signal<std::int32_t>(rand, 1000));
+    }
+
+    GIVEN("Frames which are not described")
+    {
+        CompressionOptions const options{ true, sizeof(test_data[0]), 1, VBZ_DEFAULT_VERSION };
+        auto const input_data_size = vbz_size_t(test_data.size() * sizeof(test_data[0]));
+        std::vector<int8_t> sized(vbz_max_compressed_size(input_data_size, &options) + VBZ_DESCRIBED_HEADER_SIZE);
+        auto const sized_size = vbz_compress_sized(
+            test_data.data(),
+            input_data_size,
+            sized.data(),
+            vbz_size_t(sized.size()),
+            &options);
+        REQUIRE(!vbz_is_error(sized_size));
+
+        VbzFrameInfo info;
+        CHECK(vbz_frame_info(sized.data(), sized_size, &info) == VBZ_FRAME_HEADER_ERROR);
+        CHECK(vbz_frame_info(sized.data(), VBZ_DESCRIBED_HEADER_SIZE - 1, &info) == VBZ_INPUT_SIZE_ERROR);
+
+        std::vector<std::int16_t> decompressed(test_data.size());
+        CHECK(vbz_decompress_auto(sized.data(), sized_size, decompressed.data(), input_data_size) == VBZ_FRAME_HEADER_ERROR);
+        CHECK(std::string(vbz_error_string(VBZ_FRAME_HEADER_ERROR)) == "VBZ_FRAME_HEADER_ERROR");
+
+        auto const described_size = vbz_compress_described(
+            test_data.data(),
+            input_data_size,
+            sized.data(),
+            vbz_size_t(sized.size()),
+            &options);
+        REQUIRE(!vbz_is_error(described_size));
+
+        // Bump the format version.
+        sized[4] = 2;
+        CHECK(vbz_frame_info(sized.data(), described_size, &info) == VBZ_VERSION_ERROR);
+    }
+}
+
+template <typename T>
+void perform_adaptive_compression_test(std::vector<T> const& data, CompressionOptions const& options, vbz_size_t max_size)
+{
+    GIVEN("Compression options " << options.vbz_version << " " << options.integer_size << " " << options.zstd_compression_level << " " << options.perform_delta_zig_zag << " for " << data.size() << " integers")
+    {
+        auto const input_data_size = vbz_size_t(data.size() * sizeof(data[0]));
+        std::vector<int8_t> adaptive(vbz_max_compressed_size(input_data_size, &options) + VBZ_DESCRIBED_HEADER_SIZE);
+        auto const adaptive_size = vbz_compress_adaptive(
+            data.data(),
+            input_data_size,
+            adaptive.data(),
+            vbz_size_t(adaptive.size()),
+            &options);
+        REQUIRE(!vbz_is_error(adaptive_size));
+
+        THEN("The frame is no larger than expected")
+        {
+            CHECK(adaptive_size <= max_size);
+        }
+
+        THEN("The frame info holds the requested options")
+        {
+            VbzFrameInfo info;
+            REQUIRE(vbz_frame_info(adaptive.data(), adaptive_size, &info) == 0);
+            CHECK(info.options.perform_delta_zig_zag == options.perform_delta_zig_zag);
+            CHECK(info.options.integer_size == options.integer_size);
+            CHECK(info.options.zstd_compression_level == options.zstd_compression_level);
+            CHECK(info.original_size == input_data_size);
+        }
+
+        THEN("The frame decompresses without the options")
+        {
+            std::vector<T> decompressed(data.size());
+            auto const decompressed_size = vbz_decompress_auto(
+                adaptive.data(),
+                adaptive_size,
+                decompressed.data(),
+                input_data_size);
+            REQUIRE(decompressed_size == input_data_size);
+            CHECK(decompressed == data);
+        }
+    }
+}
+
+SCENARIO("vbz adaptive compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    CompressionOptions const options{ true, sizeof(std::int16_t), 1, VBZ_DEFAULT_VERSION };
+    auto const header_size = VBZ_DESCRIBED_HEADER_SIZE;
+
+    GIVEN("Test data from a realistic dataset")
+    {
+        auto const input_data_size = vbz_size_t(test_data.size() * sizeof(test_data[0]));
+
+        THEN("No stage is skipped, and the frame matches a described frame")
+        {
+            std::vector<int8_t> described(vbz_max_compressed_size(input_data_size, &options) + header_size);
+            described.resize(vbz_compress_described(
+                test_data.data(),
+                input_data_size,
+                described.data(),
+                vbz_size_t(described.size()),
+                &options));
+            std::vector<int8_t> adaptive(vbz_max_compressed_size(input_data_size, &options) + header_size);
+            adaptive.resize(vbz_compress_adaptive(
+                test_data.data(),
+                input_data_size,
+                adaptive.data(),
+                vbz_size_t(adaptive.size()),
+                &options));
+            CHECK(adaptive == described);
+        }
+
+        perform_adaptive_compression_test(test_data, options, input_data_size);
+        perform_adaptive_compression_test(test_data, CompressionOptions{ false, 0, 1, VBZ_DEFAULT_VERSION }, input_data_size);
+    }
+
+    GIVEN("Constant data")
+    {
+        std::vector<std::int16_t> const data(10000, 1234);
+        perform_adaptive_compression_test(data, options, header_size + sizeof(std::int16_t));
+        perform_adaptive_compression_test(data, CompressionOptions{ true, sizeof(std::int16_t), 0, 1 }, header_size + sizeof(std::int16_t));
+        perform_adaptive_compression_test(std::vector<std::int32_t>(777, -5), CompressionOptions{ true, sizeof(std::int32_t), 1, 0 }, header_size + sizeof(std::int32_t));
+        perform_adaptive_compression_test(std::vector<std::int8_t>(1, 7), CompressionOptions{ false, 0, 1, 0 }, header_size + 1);
+    }
+
+    GIVEN("Tiny data")
+    {
+        std::vector<std::int16_t> const data = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        perform_adaptive_compression_test(data, options, vbz_size_t(header_size + data.size() * sizeof(data[0])));
+        perform_adaptive_compression_test(std::vector<std::int16_t>(), options, header_size);
+    }
+
+    GIVEN("Noise")
+    {
+        for (std::size_t size : { 33, 1000, 100 * 1000 })
+        {
+            auto const data = make_random_signal<std::int32_t>(rand, size);
+            auto const raw_size = vbz_size_t(header_size + data.size() * sizeof(data[0]));
+            perform_adaptive_compression_test(data, CompressionOptions{ true, sizeof(std::int32_t), 1, 0 }, raw_size);
+            perform_adaptive_compression_test(data, CompressionOptions{ false, sizeof(std::int32_t), 1, 0 }, raw_size);
+            perform_adaptive_compression_test(data, CompressionOptions{ false, sizeof(std::int32_t), 0, 0 }, raw_size);
+        }
+    }
+
+    GIVEN("Invalid input")
+    {
+        std::vector<int8_t> adaptive(1024);
+        CHECK(vbz_compress_adaptive(test_data.data(), 3, adaptive.data(), vbz_size_t(adaptive.size()), &options) == VBZ_INPUT_SIZE_ERROR);
+        CHECK(vbz_compress_adaptive(test_data.data(), 1000, adaptive.data(), 100, &options) == VBZ_DESTINATION_SIZE_ERROR);
+
+        // Constant frames hold exactly one integer.
+        std::vector<std::int16_t> const data(100, 3);
+        auto const adaptive_size = vbz_compress_adaptive(data.data(), 200, adaptive.data(), vbz_size_t(adaptive.size()), &options);
+        REQUIRE(adaptive_size == header_size + sizeof(std::int16_t));
+        std::vector<std::int16_t> decompressed(data.size());
+        CHECK(vbz_decompress_auto(adaptive.data(), adaptive_size - 1, decompressed.data(), 200) == VBZ_INPUT_SIZE_ERROR);
+        CHECK(vbz_decompress_auto(adaptive.data(), adaptive_size, decompressed.data(), 199) == VBZ_DESTINATION_SIZE_ERROR);
+
+        // A constant frame claiming to hold no data must not write its integer.
+        auto empty_constant = adaptive;
+        vbz_size_t const zero_size = 0;
+        std::memcpy(empty_constant.data() + header_size - sizeof(vbz_size_t), &zero_size, sizeof(zero_size));
+        std::vector<std::int16_t> empty_destination;
+        CHECK(vbz_decompress_auto(empty_constant.data(), adaptive_size, empty_destination.data(), 0) == VBZ_INPUT_SIZE_ERROR);
+        CHECK(vbz_decompress_auto(empty_constant.data(), adaptive_size, decompressed.data(), 200) == VBZ_INPUT_SIZE_ERROR);
+    }
+}
+
+SCENARIO("vbz advanced zstd compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    auto const data = make_random_signal<std::int16_t>(rand, 100 * 1000);
+    auto const input_data_size = vbz_size_t(data.size() * sizeof(data[0]));
+
+    auto const check_round_trip = [&](CompressionOptions const& options, VbzZstdParameters const* zstd_parameters)
+    {
+        std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+        auto const compressed_size = vbz_compress_sized_advanced(
+            data.data(),
+            input_data_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options,
+            zstd_parameters);
+        REQUIRE(!vbz_is_error(compressed_size));
+
+        std::vector<std::int16_t> decompressed(data.size());
+        auto const decompressed_size = vbz_decompress_sized(
+            compressed.data(),
+            compressed_size,
+            decompressed.data(),
+            input_data_size,
+            &options);
+        REQUIRE(decompressed_size == input_data_size);
+        CHECK(decompressed == data);
+        return std::vector<int8_t>(compressed.begin(), compressed.begin() + compressed_size);
+    };
+
+    GIVEN("Negative zstd levels")
+    {
+        for (int level : { -1, -5, -50 })
+        {
+            CompressionOptions const options{ true, sizeof(std::int16_t), unsigned(level), VBZ_DEFAULT_VERSION };
+            check_round_trip(options, nullptr);
+        }
+    }
+
+    GIVEN("Advanced zstd parameters")
+    {
+        CompressionOptions const options{ true, sizeof(std::int16_t), 3, VBZ_DEFAULT_VERSION };
+        for (auto const& parameters : {
+                VbzZstdParameters{ 0, 0, 0, 0 },
+                VbzZstdParameters{ 20, 0, 0, 0 },
+                VbzZstdParameters{ 0, 1, 0, 0 },
+                VbzZstdParameters{ 0, 9, 0, 0 },
+                VbzZstdParameters{ 27, 0, 1, 0 },
+                VbzZstdParameters{ 0, 0, 0, 2 },
+            })
+        {
+            check_round_trip(options, &parameters);
+        }
+    }
+
+    GIVEN("Default parameters")
+    {
+        CompressionOptions const options{ true, sizeof(std::int16_t), 1, VBZ_DEFAULT_VERSION };
+        VbzZstdParameters const parameters{ 0, 0, 0, 0 };
+
+        THEN("The data is compressed as vbz_compress_sized would compress it")
+        {
+            std::vector<int8_t> sized(vbz_max_compressed_size(input_data_size, &options));
+            auto const sized_size = vbz_compress_sized(
+                data.data(),
+                input_data_size,
+                sized.data(),
+                vbz_size_t(sized.size()),
+                &options);
+            REQUIRE(!vbz_is_error(sized_size));
+            sized.resize(sized_size);
+
+            CHECK(check_round_trip(options, nullptr) == sized);
+            CHECK(check_round_trip(options, &parameters) == sized);
+        }
+    }
+
+    GIVEN("A context previously used with advanced parameters")
+    {
+        CompressionOptions const options{ true, sizeof(std::int16_t), 1, VBZ_DEFAULT_VERSION };
+        VbzZstdParameters const parameters{ 27, 9, 1, 0 };
+        std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+        REQUIRE(context);
+
+        std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+        REQUIRE(!vbz_is_error(vbz_compress_sized_advanced_ctx(
+            context.get(),
+            data.data(),
+            input_data_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options,
+            &parameters)));
+
+        THEN("Later calls without parameters compress as a fresh context would")
+        {
+            auto const expected = check_round_trip(options, nullptr);
+            auto const compressed_size = vbz_compress_sized_ctx(
+                context.get(),
+                data.data(),
+                input_data_size,
+                compressed.data(),
+                vbz_size_t(compressed.size()),
+                &options);
+            REQUIRE(!vbz_is_error(compressed_size));
+            compressed.resize(compressed_size);
+            CHECK(compressed == expected);
+        }
+    }
+
+    GIVEN("An invalid window size")
+    {
+        CompressionOptions const options{ true, sizeof(std::int16_t), 1, VBZ_DEFAULT_VERSION };
+        VbzZstdParameters const parameters{ 5, 0, 0, 0 };
+
+        std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+        CHECK(vbz_compress_sized_advanced(
+            data.data(),
+            input_data_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options,
+            &parameters) == VBZ_ZSTD_ERROR);
+    }
+}
+
+SCENARIO("vbz dictionary compression")
+{
+    auto seed = std::random_device()();
+    INFO("Seed " << seed);
+    std::default_random_engine rand(seed);
+
+    // Short reads, taken from random points in the realistic dataset.
+    auto const make_reads = [&](std::size_t count)
+    {
+        std::uniform_int_distribution<std::size_t> length_dist(1000, 4000);
+        std::vector<std::vector<std::int16_t>> reads;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto const length = length_dist(rand);
+            std::uniform_int_distribution<std::size_t> start_dist(0, test_data.size() - length);
+            auto const start = test_data.begin() + std::ptrdiff_t(start_dist(rand));
+            reads.emplace_back(start, start + std::ptrdiff_t(length));
+        }
+        return reads;
+    };
+
+    CompressionOptions const options{ true, sizeof(std::int16_t), 1, VBZ_DEFAULT_VERSION };
+
+    GIVEN("A dictionary trained on short reads")
+    {
+        auto const training_reads = make_reads(500);
+        std::vector<void const*> samples;
+        std::vector<vbz_size_t> sample_sizes;
+        for (auto const& read : training_reads)
+        {
+            samples.push_back(read.data());
+            sample_sizes.push_back(vbz_size_t(read.size() * sizeof(read[0])));
+        }
+
+        std::vector<char> dictionary(16 * 1024);
+        auto const dictionary_size = vbz_train_dictionary(
+            samples.data(),
+            sample_sizes.data(),
+            vbz_size_t(samples.size()),
+            dictionary.data(),
+            vbz_size_t(dictionary.size()),
+            &options);
+        REQUIRE(!vbz_is_error(dictionary_size));
+        dictionary.resize(dictionary_size);
+
+        auto const dictionary_id = vbz_dictionary_id(dictionary.data(), dictionary_size);
+        CHECK(dictionary_id != 0);
+
+        std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+        std::unique_ptr<vbz_context, decltype(&vbz_free_context)> plain_context(vbz_create_context(), vbz_free_context);
+        REQUIRE(vbz_context_set_dictionary(context.get(), dictionary.data(), dictionary_size) == 0);
+
+        WHEN("Compressing other short reads with the dictionary")
+        {
+            std::size_t dictionary_total = 0;
+            std::size_t plain_total = 0;
+            for (auto const& read : make_reads(50))
+            {
+                auto const input_data_size = vbz_size_t(read.size() * sizeof(read[0]));
+                std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+                auto const compressed_size = vbz_compress_sized_ctx(
+                    context.get(),
+                    read.data(),
+                    input_data_size,
+                    compressed.data(),
+                    vbz_size_t(compressed.size()),
+                    &options);
+                REQUIRE(!vbz_is_error(compressed_size));
+                dictionary_total += compressed_size;
+
+                std::vector<int8_t> plain(vbz_max_compressed_size(input_data_size, &options));
+                auto const plain_size = vbz_compress_sized_ctx(
+                    plain_context.get(),
+                    read.data(),
+                    input_data_size,
+                    plain.data(),
+                    vbz_size_t(plain.size()),
+                    &options);
+                REQUIRE(!vbz_is_error(plain_size));
+                plain_total += plain_size;
+
+                CHECK(vbz_frame_dictionary_id(compressed.data(), compressed_size, &options) == dictionary_id);
+                CHECK(vbz_frame_dictionary_id(plain.data(), plain_size, &options) == 0);
+
+                std::vector<std::int16_t> decompressed(read.size());
+                CHECK(vbz_decompress_sized_ctx(
+                    context.get(),
+                    compressed.data(),
+                    compressed_size,
+                    decompressed.data(),
+                    input_data_size,
+                    &options) == input_data_size);
+                CHECK(decompressed == read);
+
+                // Frames without the dictionary still decompress with it set, but not the other way round.
+                CHECK(vbz_decompress_sized_ctx(
+                    context.get(),
+                    plain.data(),
+                    plain_size,
+                    decompressed.data(),
+                    input_data_size,
+                    &options) == input_data_size);
+                CHECK(decompressed == read);
+                CHECK(vbz_decompress_sized_ctx(
+                    plain_context.get(),
+                    compressed.data(),
+                    compressed_size,
+                    decompressed.data(),
+                    input_data_size,
+                    &options) == VBZ_ZSTD_ERROR);
+            }
+
+            THEN("The reads compress better than without it")
+            {
+                CHECK(dictionary_total < plain_total);
+            }
+        }
+
+        WHEN("Compressing a read at another level")
+        {
+            CompressionOptions const level_options{ true, sizeof(std::int16_t), 5, VBZ_DEFAULT_VERSION };
+            auto const read = make_reads(1).front();
+            auto const input_data_size = vbz_size_t(read.size() * sizeof(read[0]));
+            std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &level_options));
+            auto const compressed_size = vbz_compress_sized_ctx(
+                context.get(),
+                read.data(),
+                input_data_size,
+                compressed.data(),
+                vbz_size_t(compressed.size()),
+                &level_options);
+            REQUIRE(!vbz_is_error(compressed_size));
+
+            THEN("The read decompresses with the dictionary")
+            {
+                std::vector<std::int16_t> decompressed(read.size());
+                CHECK(vbz_decompress_sized_ctx(
+                    context.get(),
+                    compressed.data(),
+                    compressed_size,
+                    decompressed.data(),
+                    input_data_size,
+                    &level_options) == input_data_size);
+                CHECK(decompressed == read);
+            }
+        }
+
+        WHEN("The dictionary is removed")
+        {
+            REQUIRE(vbz_context_set_dictionary(context.get(), nullptr, 0) == 0);
+
+            auto const read = make_reads(1).front();
+            auto const input_data_size = vbz_size_t(read.size() * sizeof(read[0]));
+            std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+            auto const compressed_size = vbz_compress_sized_ctx(
+                context.get(),
+                read.data(),
+                input_data_size,
+                compressed.data(),
+                vbz_size_t(compressed.size()),
+                &options);
+            REQUIRE(!vbz_is_error(compressed_size));
+            CHECK(vbz_frame_dictionary_id(compressed.data(), compressed_size, &options) == 0);
+        }
+    }
+}
+
+SCENARIO("vbz prefix compression")
+{
+    CompressionOptions const options{ true, sizeof(std::int16_t), 1, VBZ_DEFAULT_VERSION };
+    std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context(vbz_create_context(), vbz_free_context);
+
+    // Consecutive reads from one channel, each compressed against the one before.
+    std::vector<std::vector<std::int16_t>> reads;
+    std::size_t const read_length = 3000;
+    for (std::size_t start = 0; start + read_length <= test_data.size() && reads.size() < 10; start += read_length)
+    {
+        reads.emplace_back(test_data.begin() + std::ptrdiff_t(start), test_data.begin() + std::ptrdiff_t(start + read_length));
+    }
+    REQUIRE(reads.size() > 1);
+
+    auto const compress = [&](std::vector<std::int16_t> const& read, std::vector<std::int16_t> const* reference)
+    {
+        auto const input_data_size = vbz_size_t(read.size() * sizeof(read[0]));
+        std::vector<int8_t> compressed(vbz_max_compressed_size(input_data_size, &options));
+        auto const compressed_size = vbz_compress_sized_prefix_ctx(
+            context.get(),
+            read.data(),
+            input_data_size,
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            &options,
+            reference ? reference->data() : nullptr,
+            reference ? vbz_size_t(reference->size() * sizeof(std::int16_t)) : 0);
+        REQUIRE(!vbz_is_error(compressed_size));
+        compressed.resize(compressed_size);
+        return compressed;
+    };
+
+    auto const decompress = [&](std::vector<int8_t> const& compressed, std::vector<std::int16_t> const* reference, std::vector<std::int16_t>& read)
+    {
+        return vbz_decompress_sized_prefix_ctx(
+            context.get(),
+            compressed.data(),
+            vbz_size_t(compressed.size()),
+            read.data(),
+            vbz_size_t(read.size() * sizeof(read[0])),
+            &options,
+            reference ? reference->data() : nullptr,
+            reference ? vbz_size_t(reference->size() * sizeof(std::int16_t)) : 0);
+    };
+
+    GIVEN("A chain of reads compressed against the previous read")
+    {
+        std::vector<std::vector<int8_t>> compressed_reads;
+        for (std::size_t i = 0; i < reads.size(); ++i)
+        {
+            compressed_reads.push_back(compress(reads[i], i > 0 ? &reads[i - 1] : nullptr));
+        }
+
+        THEN("The first read matches a read compressed without a reference")
+        {
+            auto const input_data_size = vbz_size_t(reads[0].size() * sizeof(reads[0][0]));
+            std::vector<int8_t> sized(vbz_max_compressed_size(input_data_size, &options));
+            sized.resize(vbz_compress_sized(
+                reads[0].data(),
+                input_data_size,
+                sized.data(),
+                vbz_size_t(sized.size()),
+                &options));
+            CHECK(sized == compressed_reads[0]);
+        }
+
+        THEN("Each read decompresses given the previous read")
+        {
+            for (std::size_t i = 0; i < reads.size(); ++i)
+            {
+                std::vector<std::int16_t> decompressed(reads[i].size());
+                CHECK(decompress(compressed_reads[i], i > 0 ? &reads[i - 1] : nullptr, decompressed) == decompressed.size() * sizeof(decompressed[0]));
+                CHECK(decompressed == reads[i]);
+            }
+        }
+    }
+
+    GIVEN("A read compressed against itself")
+    {
+        auto const& read = reads[1];
+        auto const plain = compress(read, nullptr);
+        auto const prefixed = compress(read, &read);
+
+        THEN("The reference is used")
+        {
+            CHECK(prefixed.size() * 10 < plain.size());
+        }
+
+        THEN("The read only decompresses with its reference")
+        {
+            std::vector<std::int16_t> decompressed(read.size());
+            CHECK(decompress(prefixed, &read, decompressed) == read.size() * sizeof(read[0]));
+            CHECK(decompressed == read);
+
+            CHECK(decompress(prefixed, nullptr, decompressed) == VBZ_ZSTD_ERROR);
+            // zstd cannot detect the wrong reference, but the data it finds is not the read.
+            decompress(prefixed, &reads[0], decompressed);
+            CHECK(decompressed != read);
+
+            // The context is still usable for frames without a reference.
+            CHECK(decompress(plain, nullptr, decompressed) == read.size() * sizeof(read[0]));
+            CHECK(decompressed == read);
+        }
+    }
+}
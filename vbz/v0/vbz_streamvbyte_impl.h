@@ -1,107 +1,189 @@
 #pragma once
 
 #include "vbz.h"
+#include "vbz_streamvbyte_output.h"
+#include "vbz_streamvbyte_tile.h"
 
 #include "streamvbyte.h"
-#include "streamvbyte_zigzag.h"
 
 #include <gsl/gsl-lite.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
-#include <vector>
+#include <cstring>
 
-/// \brief Generic implementation, safe for all integer types, and platforms.
-template <typename T, bool UseZigZag>
-struct StreamVByteWorkerV0
+namespace {
+
+/// \brief Encode [count] values as streamvbyte, writing keys from [key_ptr] and values from [data_ptr].
+/// \note Each value is stored as a full 4 byte write, so the output must be sized using
+///       streamvbyte_max_compressedbytes.
+/// \return Pointer to the first unused data byte.
+static inline std::uint8_t* streamvbyte_encode_tile(
+    std::uint32_t const* input,
+    std::size_t count,
+    std::uint8_t* key_ptr,
+    std::uint8_t* data_ptr)
 {
-    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output)
+    for (std::size_t i = 0; i < count; i += 4)
     {
-        auto const input = input_bytes.as_span<T const>();
-        
-        if (!UseZigZag)
+        auto const group_size = std::min<std::size_t>(4, count - i);
+        std::uint8_t key = 0;
+        for (std::size_t j = 0; j < group_size; ++j)
         {
-            auto input_buffer = cast<std::uint32_t>(input);
-            return vbz_size_t(streamvbyte_encode(
-                input_buffer.data(),
-                std::uint32_t(input_buffer.size()),
-                output.as_span<std::uint8_t>().data()
-            ));
+            auto const value = input[i + j];
+            auto const code = (value > 0x000000FF) + (value > 0x0000FFFF) + (value > 0x00FFFFFF);
+            std::memcpy(data_ptr, &value, sizeof(value));
+            data_ptr += code + 1;
+            key |= std::uint8_t(code << (j * 2));
         }
-        
-        std::vector<std::int32_t> input_buffer = cast<std::int32_t>(input);
-        std::vector<std::uint32_t> intermediate_buffer(input.size());
-        zigzag_delta_encode(input_buffer.data(), intermediate_buffer.data(), input_buffer.size(), 0);
-
-        return vbz_size_t(streamvbyte_encode(
-            intermediate_buffer.data(),
-            std::uint32_t(intermediate_buffer.size()),
-            output.as_span<std::uint8_t>().data()
-        ));
+        *key_ptr++ = key;
     }
-    
-    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes)
+    return data_ptr;
+}
+
+/// \brief Decode [count] streamvbyte values, reading keys from [key_ptr] and values from [data_ptr].
+/// \note Bounds are checked as values are decoded, so the stream needs no validating first.
+/// \return Pointer to the first unused data byte, or nullptr if a value extends past [data_end].
+static inline std::uint8_t const* streamvbyte_decode_tile(
+    std::uint8_t const* key_ptr,
+    std::uint8_t const* data_ptr,
+    std::uint8_t const* data_end,
+    std::uint32_t* output,
+    std::size_t count)
+{
+    static const std::uint32_t code_masks[4] = { 0x000000FF, 0x0000FFFF, 0x00FFFFFF, 0xFFFFFFFF };
+
+    // Decode 32 values at a time while they, and the 4 byte read of the last one, fit in the input.
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
     {
-        auto const output = output_bytes.as_span<T>();
-        auto in_data = input.as_span<std::uint8_t const>().data();
-        auto const out_size = vbz_size_t(output.size());
+        std::uint64_t keys = 0;
+        std::memcpy(&keys, key_ptr + i / 4, sizeof(keys));
+        if (data_end - data_ptr < std::ptrdiff_t(32 + streamvbyte_code_units(keys, false) + 3))
+        {
+            break;
+        }
 
-        if (!streamvbyte_validate_stream(in_data, input.size_bytes(), out_size)) {
-            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        for (std::size_t j = 0; j < 32; ++j)
+        {
+            auto const code = (keys >> (j * 2)) & 0x3;
+            std::uint32_t value = 0;
+            std::memcpy(&value, data_ptr, sizeof(value));
+            data_ptr += code + 1;
+            output[i + j] = value & code_masks[code];
         }
+    }
 
-        // streamvbyte requires additional padding, so copy to a temporary buffer that has that
-        std::vector<uint8_t> in_temp(input.size_bytes() + STREAMVBYTE_PADDING);
-        std::copy_n(in_data, input.size_bytes(), in_temp.begin());
-        in_data = in_temp.data();
-
-        std::vector<std::uint32_t> intermediate_buffer(out_size);
-        auto read_bytes = streamvbyte_decode(
-            in_data,
-            intermediate_buffer.data(),
-            out_size
-        );
-        if (read_bytes != input.size())
+    for (; i < count; ++i)
+    {
+        auto const code = (key_ptr[i / 4] >> ((i % 4) * 2)) & 0x3;
+        std::uint32_t value = 0;
+        if (data_end - data_ptr >= std::ptrdiff_t(sizeof(value)))
         {
-            return VBZ_STREAMVBYTE_STREAM_ERROR;
+            std::memcpy(&value, data_ptr, sizeof(value));
+            value &= code_masks[code];
+        }
+        else if (data_end - data_ptr >= code + 1)
+        {
+            std::memcpy(&value, data_ptr, code + 1);
         }
-        
-        if (!UseZigZag)
+        else
         {
-            cast(gsl::make_span(intermediate_buffer), output);
-            return vbz_size_t(output.size() * sizeof(T));
+            return nullptr;
         }
-        
-        std::vector<std::int32_t> output_buffer(output.size());
-        zigzag_delta_decode(intermediate_buffer.data(), output_buffer.data(), output_buffer.size(), 0);
-        
-        cast(gsl::make_span(output_buffer), output);
-        return vbz_size_t(output.size() * sizeof(T));
+        data_ptr += code + 1;
+        output[i] = value;
     }
-    
-    template <typename U, typename V>
-    static std::vector<U> cast(gsl::span<V> const& input)
+    return data_ptr;
+}
+
+/// \brief Generic implementation, safe for all integer types, and platforms.
+///
+/// Input is converted and encoded one tile at a time, so no intermediate buffers are allocated.
+template <typename T, bool UseZigZag>
+struct StreamVByteWorkerV0
+{
+    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output, std::int32_t seed)
     {
-        std::vector<U> output(input.size());
-        for (std::size_t i = 0; i < input.size(); ++i)
+        auto const input = input_bytes.as_span<T const>();
+        auto const count = input.size();
+        if (output.size() < streamvbyte_max_compressedbytes(std::uint32_t(count)))
         {
-            output[i] = input[i];
+            return VBZ_DESTINATION_SIZE_ERROR;
         }
-        return output;
+
+        auto const output_begin = output.as_span<std::uint8_t>().data();
+        auto const key_ptr = output_begin;
+        auto data_ptr = key_ptr + (count + 3) / 4;
+
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        std::uint32_t previous = std::uint32_t(seed);
+        for (std::size_t offset = 0; offset < count; offset += tile.size())
+        {
+            auto const tile_count = std::min(tile.size(), count - offset);
+            to_streamvbyte_values<UseZigZag>(input.data() + offset, tile.data(), tile_count, previous);
+            data_ptr = streamvbyte_encode_tile(tile.data(), tile_count, key_ptr + offset / 4, data_ptr);
+        }
+
+        return vbz_size_t(data_ptr - output_begin);
     }
     
-    template <typename U, typename V>
-    static void cast(gsl::span<U> input, gsl::span<V> output)
+    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes, std::int32_t seed)
     {
-        for (std::size_t i = 0; i < input.size(); ++i)
+        auto const output = output_bytes.as_span<T>();
+        return decompressed_bytes<T>(decompress_to(input, output.size(), IntegerOutput<T>{ output.data() }, seed));
+    }
+
+    /// \brief Decode [count] values from [input], writing them to [output].
+    /// \param seed The value preceding the first value, which zig zag deltas start from.
+    /// \return The number of values decoded, or an error.
+    template <typename Output>
+    static vbz_size_t decompress_to(gsl::span<char const> input, std::size_t count, Output output, std::int32_t seed)
+    {
+        auto const in_data = input.as_span<std::uint8_t const>().data();
+
+        vbz_size_t key_byte_count = vbz_size_t((count + 3) / 4);
+        if (input.size() < key_byte_count)
         {
-            output[i] = input[i];
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
         }
+
+        auto const key_ptr = in_data;
+        auto const data_end = in_data + input.size_bytes();
+        auto data_ptr = key_ptr + key_byte_count;
+
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        std::uint32_t previous = std::uint32_t(seed);
+        for (std::size_t offset = 0; offset < count; offset += tile.size())
+        {
+            auto const tile_count = std::min(tile.size(), count - offset);
+            data_ptr = streamvbyte_decode_tile(key_ptr + offset / 4, data_ptr, data_end, tile.data(), tile_count);
+            if (!data_ptr)
+            {
+                return VBZ_STREAMVBYTE_STREAM_ERROR;
+            }
+            output.template store_tile<UseZigZag>(offset, tile.data(), tile_count, previous);
+        }
+
+        if (data_ptr != data_end)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+        return vbz_size_t(count);
     }
 };
 
-#ifdef __SSE3__
+} // namespace
+
+#ifdef __SSSE3__
 
 #include "vbz_streamvbyte_impl_sse3.h"
 
 #endif
+
+#ifdef __AVX2__
+
+#include "vbz_streamvbyte_impl_avx2.h"
+
+#endif
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cstring>
+
+#if (defined __INTEL_COMPILER) && (defined WIN32)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+/// \brief Shuffles for streamvbyte coding 8 16 bit values, where each value takes 1 or 2 bytes.
+///
+/// Each table is indexed by a byte with a bit per value, set when that value needs 2 bytes.
+struct StreamVByteInt16ShuffleTables
+{
+    std::uint8_t encode[256][16];
+    std::uint8_t decode[256][16];
+    std::uint8_t length[256];
+};
+
+constexpr StreamVByteInt16ShuffleTables make_int16_shuffle_tables()
+{
+    StreamVByteInt16ShuffleTables tables{};
+    for (std::size_t mask = 0; mask < 256; ++mask)
+    {
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            tables.encode[mask][position] = std::uint8_t(i * 2);
+            tables.decode[mask][i * 2] = std::uint8_t(position);
+            position += 1;
+
+            if ((mask >> i) & 1)
+            {
+                tables.encode[mask][position] = std::uint8_t(i * 2 + 1);
+                tables.decode[mask][i * 2 + 1] = std::uint8_t(position);
+                position += 1;
+            }
+            else
+            {
+                tables.decode[mask][i * 2 + 1] = 0x80;
+            }
+        }
+
+        tables.length[mask] = std::uint8_t(position);
+        for (; position < 16; ++position)
+        {
+            tables.encode[mask][position] = 0x80;
+        }
+    }
+    return tables;
+}
+
+static constexpr StreamVByteInt16ShuffleTables int16_shuffle_tables = make_int16_shuffle_tables();
+
+inline static __m256i combine_registers(__m128i low, __m128i high)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+/// \brief Optimised avx2 implementation for x64 when performing zig zag deltas on int16 data.
+///
+/// Produces the same bytes as StreamVByteWorkerV0Int16ZigZagSse3, 16 values at a time. Zig zag
+/// encoded 16 bit deltas need at most 2 bytes, so only key codes 0 and 1 are generated.
+struct StreamVByteWorkerV0Int16ZigZagAvx2
+{
+    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output, std::int32_t seed)
+    {
+        auto const input = input_bytes.as_span<std::int16_t const>();
+        auto const count = input.size();
+        if (output.size() < streamvbyte_max_compressedbytes(std::uint32_t(count)))
+        {
+            return VBZ_DESTINATION_SIZE_ERROR;
+        }
+
+        auto const output_begin = output.as_span<std::uint8_t>().data();
+        auto key_ptr = output_begin;
+        auto data_ptr = key_ptr + (count + 3) / 4;
+
+        auto const zero = _mm256_setzero_si256();
+        auto previous = _mm256_set1_epi16(std::int16_t(seed));
+        std::size_t completed = 0;
+        for (; completed + 16 <= count; completed += 16)
+        {
+            auto const current = _mm256_loadu_si256((__m256i const*)(input.data() + completed));
+
+            // Shift each value up one position, pulling in the last value of the previous register.
+            auto const carried = _mm256_permute2x128_si256(previous, current, 0x21);
+            auto const delta = _mm256_sub_epi16(current, _mm256_alignr_epi8(current, carried, 14));
+            previous = current;
+
+            auto const zig_zag = _mm256_xor_si256(_mm256_slli_epi16(delta, 1), _mm256_srai_epi16(delta, 15));
+
+            // Find a bit per value, set when the value needs 2 bytes.
+            auto const one_byte = _mm256_cmpeq_epi16(_mm256_srli_epi16(zig_zag, 8), zero);
+            auto const one_byte_bits = std::uint32_t(_mm256_movemask_epi8(_mm256_packs_epi16(one_byte, one_byte)));
+            auto const two_bytes = ~((one_byte_bits & 0xFF) | ((one_byte_bits >> 8) & 0xFF00)) & 0xFFFF;
+
+            // Spread each bit into a 2 bit key.
+            std::uint32_t keys = two_bytes;
+            keys = (keys | (keys << 8)) & 0x00FF00FF;
+            keys = (keys | (keys << 4)) & 0x0F0F0F0F;
+            keys = (keys | (keys << 2)) & 0x33333333;
+            keys = (keys | (keys << 1)) & 0x55555555;
+            std::memcpy(key_ptr, &keys, sizeof(keys));
+            key_ptr += sizeof(keys);
+
+            auto const low_mask = two_bytes & 0xFF;
+            auto const high_mask = two_bytes >> 8;
+            auto const shuffle = combine_registers(
+                _mm_loadu_si128((__m128i const*)int16_shuffle_tables.encode[low_mask]),
+                _mm_loadu_si128((__m128i const*)int16_shuffle_tables.encode[high_mask])
+            );
+            auto const packed = _mm256_shuffle_epi8(zig_zag, shuffle);
+
+            _mm_storeu_si128((__m128i*)data_ptr, _mm256_castsi256_si128(packed));
+            data_ptr += int16_shuffle_tables.length[low_mask];
+            _mm_storeu_si128((__m128i*)data_ptr, _mm256_extracti128_si256(packed, 1));
+            data_ptr += int16_shuffle_tables.length[high_mask];
+        }
+
+        // Encode any remaining values 8 at a time, as the ssse3 implementation does.
+        while (completed < count)
+        {
+            std::array<std::uint32_t, 8> final_elements;
+            std::int16_t const last_value = completed == 0 ? std::int16_t(seed) : input[completed - 1];
+            auto const converted = scalar_to_zig_zag(input.subspan(completed), final_elements, last_value);
+            data_ptr = streamvbyte_encode_tile(final_elements.data(), converted, key_ptr, data_ptr);
+            key_ptr += (converted + 3) / 4;
+            completed += converted;
+        }
+
+        return vbz_size_t(data_ptr - output_begin);
+    }
+
+    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes, std::int32_t seed)
+    {
+        auto const output = output_bytes.as_span<std::int16_t>();
+        return decompressed_bytes<std::int16_t>(decompress_to(input, output.size(), IntegerOutput<std::int16_t>{ output.data() }, seed));
+    }
+
+    /// \brief Decode [count] values from [input], writing them to [output].
+    /// \param seed The value preceding the first value, which zig zag deltas start from.
+    /// \return The number of values decoded, or an error.
+    template <typename Output>
+    static vbz_size_t decompress_to(gsl::span<char const> input, std::size_t count, Output output, std::int32_t seed)
+    {
+
+        vbz_size_t key_byte_count = vbz_size_t((count + 3) / 4);
+        if (input.size() < key_byte_count)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+
+        auto const key_ptr = input.as_span<std::uint8_t const>().data();
+        auto const data_end = key_ptr + input.size();
+        auto data_ptr = key_ptr + key_byte_count;
+
+        auto const zero = _mm256_setzero_si256();
+        auto const one = _mm256_set1_epi16(1);
+        auto const last_word = _mm256_set1_epi16(0x0F0E);
+
+        auto previous = std::int16_t(seed);
+        std::size_t completed = 0;
+        for (; completed + 16 <= count; completed += 16)
+        {
+            // 16 values read at most 64 bytes, leave the end of the stream to the scalar implementation.
+            if (data_end - data_ptr < 64)
+            {
+                break;
+            }
+
+            std::uint32_t keys = 0;
+            std::memcpy(&keys, key_ptr + completed / 4, sizeof(keys));
+
+            // Streams written by the generic implementation can hold 3 or 4 byte values, decode those in 32 bit lanes.
+            if (keys & 0xAAAAAAAA)
+            {
+                auto data = gsl::make_span((char const*)data_ptr, std::size_t(data_end - data_ptr));
+                for (std::size_t half = 0; half < 2; ++half)
+                {
+                    auto low = decompress_int_registers(key_ptr[completed / 4 + half * 2], data);
+                    auto high = decompress_int_registers(key_ptr[completed / 4 + half * 2 + 1], data);
+
+                    auto const zero_32 = _mm_setzero_si128();
+                    auto const one_32 = _mm_set1_epi32(1);
+                    low = _mm_xor_si128(_mm_srli_epi32(low, 1), _mm_sub_epi32(zero_32, _mm_and_si128(low, one_32)));
+                    high = _mm_xor_si128(_mm_srli_epi32(high, 1), _mm_sub_epi32(zero_32, _mm_and_si128(high, one_32)));
+
+                    low = _mm_add_epi32(low, _mm_slli_si128(low, 4));
+                    low = _mm_add_epi32(low, _mm_slli_si128(low, 8));
+                    low = _mm_add_epi32(low, _mm_set1_epi32(previous));
+                    high = _mm_add_epi32(high, _mm_slli_si128(high, 4));
+                    high = _mm_add_epi32(high, _mm_slli_si128(high, 8));
+                    high = _mm_add_epi32(high, _mm_shuffle_epi32(low, 0xFF));
+
+                    output.store_int32_lanes(completed + half * 8, low, high);
+                    previous = std::int16_t(_mm_extract_epi16(high, 6));
+                }
+                data_ptr = (std::uint8_t const*)data.data();
+                continue;
+            }
+
+            // Gather the key codes back into a bit per value.
+            keys = (keys | (keys >> 1)) & 0x33333333;
+            keys = (keys | (keys >> 2)) & 0x0F0F0F0F;
+            keys = (keys | (keys >> 4)) & 0x00FF00FF;
+            keys = (keys | (keys >> 8)) & 0x0000FFFF;
+
+            auto const low_mask = keys & 0xFF;
+            auto const high_mask = keys >> 8;
+            auto const low_length = int16_shuffle_tables.length[low_mask];
+            auto const data = combine_registers(
+                _mm_loadu_si128((__m128i const*)data_ptr),
+                _mm_loadu_si128((__m128i const*)(data_ptr + low_length))
+            );
+            auto const shuffle = combine_registers(
+                _mm_loadu_si128((__m128i const*)int16_shuffle_tables.decode[low_mask]),
+                _mm_loadu_si128((__m128i const*)int16_shuffle_tables.decode[high_mask])
+            );
+            data_ptr += low_length + int16_shuffle_tables.length[high_mask];
+            auto values = _mm256_shuffle_epi8(data, shuffle);
+
+            // Perform un-zig zag int reorganisation
+            // (n >> 1) ^ - (n & 1)
+            values = _mm256_xor_si256(_mm256_srli_epi16(values, 1), _mm256_sub_epi16(zero, _mm256_and_si256(values, one)));
+
+            // Prefix sum the deltas within each lane, then carry the low lane total into the high lane.
+            values = _mm256_add_epi16(values, _mm256_slli_si256(values, 2));
+            values = _mm256_add_epi16(values, _mm256_slli_si256(values, 4));
+            values = _mm256_add_epi16(values, _mm256_slli_si256(values, 8));
+            auto const lane_totals = _mm256_shuffle_epi8(values, last_word);
+            values = _mm256_add_epi16(values, _mm256_permute2x128_si256(lane_totals, lane_totals, 0x08));
+            values = _mm256_add_epi16(values, _mm256_set1_epi16(previous));
+
+            output.store_lanes(completed, values);
+            previous = std::int16_t(_mm256_extract_epi16(values, 15));
+        }
+
+        // Decode any remaining values using the generic implementation, which checks the stream bounds.
+        std::uint32_t previous_value = std::uint32_t(std::int32_t(previous));
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        for (std::size_t offset = completed; offset < count; offset += tile.size())
+        {
+            auto const tile_count = std::min(tile.size(), count - offset);
+            data_ptr = streamvbyte_decode_tile(key_ptr + offset / 4, data_ptr, data_end, tile.data(), tile_count);
+            if (!data_ptr)
+            {
+                return VBZ_STREAMVBYTE_STREAM_ERROR;
+            }
+            output.template store_tile<true>(offset, tile.data(), tile_count, previous_value);
+        }
+
+        if (data_ptr != data_end)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+        return vbz_size_t(count);
+    }
+};
+
+template <>
+struct StreamVByteWorkerV0<std::int16_t, true> : StreamVByteWorkerV0Int16ZigZagAvx2 {};
+
+} // namespace
@@ -9,6 +9,8 @@
 #include <x86intrin.h>
 #endif
 
+namespace {
+
 // See: https://github.com/lemire/streamvbyte
 static const uint8_t encode_shuf_lut[64*16] = {
     0x00, 0x04, 0x08, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
@@ -371,19 +373,6 @@ inline static std::size_t scalar_to_zig_zag(gsl::span<std::int16_t const> input,
     return size;
 }
 
-template <typename T>
-inline static std::size_t zig_zag_to_scalar(gsl::span<std::uint32_t> const& input, gsl::span<std::int16_t> output, T last_value)
-{
-    auto const size = std::min(output.size(), input.size());
-    for (std::size_t i = 0; i < size; ++i)
-    {
-        std::uint32_t const zig_zag = input[i];
-        output[i] = ((zig_zag >> 1) ^ - (zig_zag & 1)) + last_value;
-        last_value = output[i];
-    }
-    return size;
-}
-
 template <typename IntType, typename RegType, typename PrintType=IntType>
 void dump_reg(std::ostream& str, RegType reg)
 {
@@ -399,11 +388,57 @@ void dump_reg(std::ostream& str, RegType reg)
     }
 }
 
-/// \brief Optimised ssse3 implementation for x64 when performing zig zag deltas.
-template <>
-struct StreamVByteWorkerV0<std::int16_t, true>
+/// \brief Streamvbyte encode the 8 values in [r0] and [r1], advancing [keyPtr] by 2 and [dataPtr] by the bytes used.
+/// \note Up to 16 bytes are stored at each step, so [dataPtr] must have space for the maximum encoded size.
+inline static void compress_int_registers(__m128i r0, __m128i r1, char*& keyPtr, char*& dataPtr)
+{
+    std::size_t keys;
+    __m128i r2, r3;
+
+    const __m128i mask_01 = _mm_set1_epi8(0x01);
+    const __m128i mask_7F00 = _mm_set1_epi16(0x7F00);
+
+    r2 = _mm_min_epu8(mask_01, r0);
+    r3 = _mm_min_epu8(mask_01, r1);
+    r2 = _mm_packus_epi16(r2, r3);
+    r2 = _mm_min_epi16(r2, mask_01); // convert 0x01FF to 0x0101
+    r2 = _mm_adds_epu16(r2, mask_7F00); // convert: 0x0101 to 0x8001, 0xFF01 to 0xFFFF
+    keys = (size_t)_mm_movemask_epi8(r2);
+
+    r2 = _mm_loadu_si128((__m128i*)&encode_shuf_lut[(keys << 4) & 0x03F0]);
+    r3 = _mm_loadu_si128((__m128i*)&encode_shuf_lut[(keys >> 4) & 0x03F0]);
+    r0 = _mm_shuffle_epi8(r0, r2);
+    r1 = _mm_shuffle_epi8(r1, r3);
+
+    _mm_storeu_si128((__m128i *)dataPtr, r0);
+    dataPtr += len_lut[keys & 0xFF];
+    _mm_storeu_si128((__m128i *)dataPtr, r1);
+    dataPtr += len_lut[keys >> 8];
+    
+    *((uint16_t*)keyPtr) = (uint16_t)keys;
+    keyPtr += 2;
+}
+
+/// \brief Streamvbyte decode the 4 values described by [key], consuming their bytes from [data_buffer].
+/// \note 16 bytes are loaded from [data_buffer], regardless of how many are used.
+inline static __m128i decompress_int_registers(uint32_t key, gsl::span<char const>& data_buffer)
 {
-    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output)
+    uint8_t len;
+    __m128i data = _mm_loadu_si128(data_buffer.subspan(0, sizeof(__m128i)).as_span<__m128i const>().data());
+
+    uint8_t *pshuf = (uint8_t *) &decode_shuffleTable[key];
+    __m128i shuf = *(__m128i *)pshuf;
+    len = len_lut[key];
+    
+    data = _mm_shuffle_epi8(data, shuf);
+    data_buffer = data_buffer.subspan(len);
+    return data;
+}
+
+/// \brief Optimised ssse3 implementation for x64 when performing zig zag deltas on int16 data.
+struct StreamVByteWorkerV0Int16ZigZagSse3
+{
+    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output, std::int32_t seed)
     {
         auto const input = input_bytes.as_span<std::int16_t const>();
         std::uint32_t size = input.size();
@@ -421,7 +456,7 @@ struct StreamVByteWorkerV0<std::int16_t, true>
         auto step = 8;
         std::size_t completed = 0;
 
-        auto prev_current = _mm_set1_epi16(0);
+        auto prev_current = _mm_set1_epi16(std::int16_t(seed));
         for (; (completed+step) <= size; completed += step)
         {
             // load data from source short buffer
@@ -447,7 +482,7 @@ struct StreamVByteWorkerV0<std::int16_t, true>
         }
 
         std::array<std::uint32_t, 8> final_elements;
-        std::int16_t last_value = completed == 0 ? 0 : input[completed-1];
+        std::int16_t last_value = completed == 0 ? std::int16_t(seed) : input[completed-1];
         scalar_to_zig_zag(input.subspan(completed), final_elements, last_value);
 
         // do remaining
@@ -465,33 +500,39 @@ struct StreamVByteWorkerV0<std::int16_t, true>
         return dataPtr - output.begin();
     }
     
-    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes)
+    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes, std::int32_t seed)
     {
         auto const output = output_bytes.as_span<std::int16_t>();
+        return decompressed_bytes<std::int16_t>(decompress_to(input, output.size(), IntegerOutput<std::int16_t>{ output.data() }, seed));
+    }
 
-        int count = output.size();
-        if (count == 0)
-        {
-            return 0;
-        }
+    /// \brief Decode [count] values from [input], writing them to [output].
+    /// \param seed The value preceding the first value, which zig zag deltas start from.
+    /// \return The number of values decoded, or an error.
+    template <typename Output>
+    static vbz_size_t decompress_to(gsl::span<char const> input, std::size_t count, Output output, std::int32_t seed)
+    {
 
-        vbz_size_t key_byte_count = (count + 3) / 4;
+        vbz_size_t key_byte_count = vbz_size_t((count + 3) / 4);
         if (input.size() < key_byte_count)
         {
-            return VBZ_STREAMVBYTE_INPUT_SIZE_ERROR;
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
         }
 
         // full list of keys starts
         // 2-bits per key (rounded up)
-        auto keys = input.subspan(0, key_byte_count).as_span<std::uint8_t const>();
+        auto const keys = input.subspan(0, key_byte_count).as_span<std::uint8_t const>();
         // data starts at end of keys
-        gsl::span<char const> data = input.subspan(key_byte_count);
-        std::size_t key_byte_pairs = count / (4*2);    // 2 bits per int - 4 ints per byte, iterate in pairs - 8 ints at once
+        auto data = input.subspan(key_byte_count);
+
+        auto const zero = _mm_setzero_si128();
+        auto const one = _mm_set1_epi32(1);
+        auto const to_16_bit_low = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+        auto const to_16_bit_high = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 4, 5, 8, 9, 12, 13);
 
-        std::size_t key_idx = 0;
-        std::size_t output_index = 0;
-        auto prev = _mm_set1_epi16(0); // previous set to 0 to begin with
-        for (; key_idx < key_byte_pairs; ++key_idx)
+        auto previous = _mm_set1_epi16(std::int16_t(seed)); // previous value in every lane
+        std::size_t completed = 0;
+        for (; completed + 8 <= count; completed += 8)
         {
             // We'll process at max 32 bytes of input from data - if theres < than that left we need to
             // use the scalar impl
@@ -499,161 +540,245 @@ struct StreamVByteWorkerV0<std::int16_t, true>
             {
                 break;
             }
-            
-            auto const key_1 = keys[key_idx*2];
-            auto data_1 = decompress_int_registers(key_1, data);
 
-            auto const key_2 = keys[key_idx*2+1];
-            auto data_2 = decompress_int_registers(key_2, data);
-            
-            // Now unpack the decompressed data to signed integers.
-            auto const to_16_bit_left = _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1, 0,1,  4,5,  8,9,  12, 13);
-            auto const to_16_bit_right = _mm_setr_epi8(0,1,  4,5,  8,9,  12, 13, -1,-1,-1,-1,-1,-1,-1,-1);
-            auto const left = _mm_shuffle_epi8(data_1, to_16_bit_left);
-            auto const right = _mm_shuffle_epi8(data_2, to_16_bit_right);
-            auto const values = _mm_alignr_epi8(right, left, 8);
-            
-            const __m128i mask_1 = _mm_set1_epi16(1);
+            auto low = decompress_int_registers(keys[completed / 4], data);
+            auto high = decompress_int_registers(keys[completed / 4 + 1], data);
+
             // Perform un-zig zag int reorganisation
             // (n >> 1) ^ - (n & 1)
-            auto shr = _mm_srli_epi16(values, 1);
-            auto neg_bit = _mm_sign_epi16(_mm_and_si128(values, mask_1), _mm_set1_epi16(-1));
-            auto xor_res = _mm_xor_si128(shr, neg_bit);
-        
-            // Combine to find previous values
-            auto zero = _mm_set1_epi16(0);
-            auto cum_sum = xor_res;
-            auto cum_sum_adder = xor_res;
-            
-            for (std::size_t i = 0; i < 7; ++i)
-            {
-                auto next_cum_sum_adder = _mm_alignr_epi8(cum_sum_adder, zero, 14);
-                cum_sum = _mm_add_epi16(cum_sum, next_cum_sum_adder);
-                cum_sum_adder = next_cum_sum_adder;
-            }
-
-            cum_sum = _mm_add_epi16(cum_sum, prev);
-            _mm_storeu_si128((__m128i *)output.subspan(output_index).data(), cum_sum);
-
-            prev = _mm_shuffle_epi8(cum_sum, _mm_setr_epi8(14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15));
-            output_index += 8;
+            // Streams written by older generic builds take deltas in 32 bits, and can hold values
+            // wider than 16 bits, so un-zig zag before narrowing.
+            low = _mm_xor_si128(_mm_srli_epi32(low, 1), _mm_sub_epi32(zero, _mm_and_si128(low, one)));
+            high = _mm_xor_si128(_mm_srli_epi32(high, 1), _mm_sub_epi32(zero, _mm_and_si128(high, one)));
+            auto values = _mm_or_si128(_mm_shuffle_epi8(low, to_16_bit_low), _mm_shuffle_epi8(high, to_16_bit_high));
+
+            // Prefix sum the deltas, in log2(8) shift and add steps.
+            values = _mm_add_epi16(values, _mm_slli_si128(values, 2));
+            values = _mm_add_epi16(values, _mm_slli_si128(values, 4));
+            values = _mm_add_epi16(values, _mm_slli_si128(values, 8));
+            values = _mm_add_epi16(values, previous);
+            output.store_lanes(completed, values);
+
+            previous = _mm_shuffle_epi8(values, _mm_set1_epi16(0x0F0E));
         }
 
-        auto scalar_count = count - output_index;
-        if (scalar_count)
+        // Decode any remaining values using the generic implementation, which checks the stream bounds.
+        auto const data_begin = data.as_span<std::uint8_t const>().data();
+        auto const data_end = data_begin + data.size();
+        std::uint32_t previous_value = std::uint32_t(std::int32_t(std::int16_t(_mm_cvtsi128_si32(previous))));
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        auto data_ptr = data_begin;
+        for (std::size_t offset = completed; offset < count; offset += tile.size())
         {
-            auto scalar_keys = keys.subspan(key_idx*2);
-            std::size_t key_index = 0;
-
-            std::array<std::uint32_t, 32> final_elements;
-            uint8_t shift = 0;
-            uint32_t key = scalar_keys[key_index++];
-            
-            vbz_size_t error_value = 0;
-            for (uint32_t c = 0; c < scalar_count; c++) 
+            auto const tile_count = std::min(tile.size(), count - offset);
+            data_ptr = streamvbyte_decode_tile(keys.data() + offset / 4, data_ptr, data_end, tile.data(), tile_count);
+            if (!data_ptr)
             {
-                if (shift == 8) {
-                    shift = 0;
-                    key = scalar_keys[key_index++];
-                }
-                uint32_t val = decompress_int(data, (key >> shift) & 0x3, error_value);
-                if (error_value)
-                {
-                    return error_value;
-                }
-                
-                final_elements[c] = val;
-                shift += 2;
+                return VBZ_STREAMVBYTE_STREAM_ERROR;
             }
-
-            std::int16_t last_value = output_index == 0 ? 0 : output.subspan(output_index - 1)[0];
-            zig_zag_to_scalar(gsl::make_span(final_elements).subspan(0, scalar_count), output.subspan(output_index), last_value);
-
+            output.template store_tile<true>(offset, tile.data(), tile_count, previous_value);
         }
 
-        if (data.size() != 0)
+        if (data_ptr != data_end)
         {
             return VBZ_STREAMVBYTE_STREAM_ERROR;
         }
 
-        return output.size() * sizeof(std::int16_t);
+        return vbz_size_t(count);
     }
+};
+
+/// \brief Sign extend groups of 8 integers to two registers of 4 32 bit lanes.
+template <typename T>
+struct Sse3Int32Lanes;
+
+template <>
+struct Sse3Int32Lanes<std::int8_t>
+{
+    static void load(std::int8_t const* input, __m128i& low, __m128i& high)
+    {
+        auto const bytes = _mm_loadl_epi64((__m128i const*)input);
+        auto const shorts = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+        low = _mm_srai_epi32(_mm_unpacklo_epi16(shorts, shorts), 16);
+        high = _mm_srai_epi32(_mm_unpackhi_epi16(shorts, shorts), 16);
+    }
+};
 
-    inline static void compress_int_registers(__m128i r0, __m128i r1, char*& keyPtr, char*& dataPtr)
+template <>
+struct Sse3Int32Lanes<std::int16_t>
+{
+    static void load(std::int16_t const* input, __m128i& low, __m128i& high)
     {
-        std::size_t keys;
-        __m128i r2, r3;
-
-        const __m128i mask_01 = _mm_set1_epi8(0x01);
-        const __m128i mask_7F00 = _mm_set1_epi16(0x7F00);
-
-        r2 = _mm_min_epu8(mask_01, r0);
-        r3 = _mm_min_epu8(mask_01, r1);
-        r2 = _mm_packus_epi16(r2, r3);
-        r2 = _mm_min_epi16(r2, mask_01); // convert 0x01FF to 0x0101
-        r2 = _mm_adds_epu16(r2, mask_7F00); // convert: 0x0101 to 0x8001, 0xFF01 to 0xFFFF
-        keys = (size_t)_mm_movemask_epi8(r2);
-
-        r2 = _mm_loadu_si128((__m128i*)&encode_shuf_lut[(keys << 4) & 0x03F0]);
-        r3 = _mm_loadu_si128((__m128i*)&encode_shuf_lut[(keys >> 4) & 0x03F0]);
-        r0 = _mm_shuffle_epi8(r0, r2);
-        r1 = _mm_shuffle_epi8(r1, r3);
-
-        _mm_storeu_si128((__m128i *)dataPtr, r0);
-        dataPtr += len_lut[keys & 0xFF];
-        _mm_storeu_si128((__m128i *)dataPtr, r1);
-        dataPtr += len_lut[keys >> 8];
-        
-        *((uint16_t*)keyPtr) = (uint16_t)keys;
-        keyPtr += 2;
+        auto const shorts = _mm_loadu_si128((__m128i const*)input);
+        low = _mm_srai_epi32(_mm_unpacklo_epi16(shorts, shorts), 16);
+        high = _mm_srai_epi32(_mm_unpackhi_epi16(shorts, shorts), 16);
     }
+};
 
-    inline static __m128i decompress_int_registers(uint32_t key, gsl::span<char const>& data_buffer)
+template <>
+struct Sse3Int32Lanes<std::int32_t>
+{
+    static void load(std::int32_t const* input, __m128i& low, __m128i& high)
     {
-        uint8_t len;
-        __m128i data = _mm_loadu_si128(data_buffer.subspan(0, sizeof(__m128i)).as_span<__m128i const>().data());
-
-        uint8_t *pshuf = (uint8_t *) &decode_shuffleTable[key];
-        __m128i shuf = *(__m128i *)pshuf;
-        len = len_lut[key];
-        
-        data = _mm_shuffle_epi8(data, shuf);
-        data_buffer = data_buffer.subspan(len);
-        return data;
+        low = _mm_loadu_si128((__m128i const*)input);
+        high = _mm_loadu_si128((__m128i const*)(input + 4));
     }
+};
 
-    inline static std::uint32_t decompress_int(gsl::span<char const>& data_buffer, int code, vbz_size_t& error_value)
+/// \brief Optimised ssse3 implementation for the remaining integer types and zig zag modes.
+///
+/// Values are widened to 32 bits before any delta is taken, matching the generic implementation byte for byte.
+template <typename T, bool UseZigZag>
+struct StreamVByteWorkerV0Sse3
+{
+    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output, std::int32_t seed)
     {
-        std::size_t copy_size = 0;
-        if (code == 0) { // 1 byte
-            copy_size = 1;
-        } else if (code == 1) { // 2 bytes
-            copy_size = 2;
-        } else if (code == 2) { // 3 bytes
-            copy_size = 3;
-        } else { // code == 3
-            copy_size = 4;
+        auto const input = input_bytes.as_span<T const>();
+        auto const count = input.size();
+        if (output.size() < streamvbyte_max_compressedbytes(std::uint32_t(count)))
+        {
+            return VBZ_DESTINATION_SIZE_ERROR;
         }
-        
-        if (data_buffer.size() < copy_size)
+
+        char* key_ptr = output.data();
+        char* data_ptr = output.data() + (count + 3) / 4;
+
+        auto previous = _mm_set1_epi32(seed);
+        std::size_t completed = 0;
+        for (; completed + 8 <= count; completed += 8)
         {
-            error_value = VBZ_STREAMVBYTE_STREAM_ERROR;
-            return 0;
+            __m128i low, high;
+            Sse3Int32Lanes<T>::load(input.data() + completed, low, high);
+
+            if (UseZigZag)
+            {
+                // Shift each value up a lane, pulling in the last value of the previous register.
+                auto const low_delta = _mm_sub_epi32(low, _mm_alignr_epi8(low, previous, 12));
+                auto const high_delta = _mm_sub_epi32(high, _mm_alignr_epi8(high, low, 12));
+                previous = high;
+
+                low = _mm_xor_si128(_mm_slli_epi32(low_delta, 1), _mm_srai_epi32(low_delta, 31));
+                high = _mm_xor_si128(_mm_slli_epi32(high_delta, 1), _mm_srai_epi32(high_delta, 31));
+            }
+
+            compress_int_registers(low, high, key_ptr, data_ptr);
         }
-        
-        std::uint32_t val = 0;
-        memcpy(&val, data_buffer.data(), copy_size);
-        data_buffer = data_buffer.subspan(copy_size);
 
-        return val;
+        // Encode any remaining values using the generic implementation.
+        std::array<std::uint32_t, 8> final_elements;
+        auto const remaining = count - completed;
+        std::uint32_t previous_value = completed == 0 ? std::uint32_t(seed) : std::uint32_t(input[completed - 1]);
+        to_streamvbyte_values<UseZigZag>(input.data() + completed, final_elements.data(), remaining, previous_value);
+        auto const end = streamvbyte_encode_tile(
+            final_elements.data(),
+            remaining,
+            (std::uint8_t*)key_ptr,
+            (std::uint8_t*)data_ptr
+        );
+
+        return vbz_size_t(end - output.as_span<std::uint8_t>().data());
+    }
+
+    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes, std::int32_t seed)
+    {
+        auto const output = output_bytes.as_span<T>();
+        return decompressed_bytes<T>(decompress_to(input, output.size(), IntegerOutput<T>{ output.data() }, seed));
     }
 
-    template <typename U, typename V>
-    static void cast(gsl::span<U> input, gsl::span<V> output)
+    /// \brief Decode [count] values from [input], writing them to [output].
+    /// \param seed The value preceding the first value, which zig zag deltas start from.
+    /// \return The number of values decoded, or an error.
+    template <typename Output>
+    static vbz_size_t decompress_to(gsl::span<char const> input, std::size_t count, Output output, std::int32_t seed)
     {
-        for (std::size_t i = 0; i < input.size(); ++i)
+
+        vbz_size_t key_byte_count = vbz_size_t((count + 3) / 4);
+        if (input.size() < key_byte_count)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+
+        auto const keys = input.subspan(0, key_byte_count).as_span<std::uint8_t const>();
+        auto data = input.subspan(keys.size());
+
+        auto previous = _mm_set1_epi32(seed);
+        std::size_t completed = 0;
+        for (; completed + 8 <= count; completed += 8)
+        {
+            // Each pair of keys reads at most 32 bytes, leave the end of the stream to the scalar implementation.
+            if (data.size() < 32)
+            {
+                break;
+            }
+
+            auto low = decompress_int_registers(keys[completed / 4], data);
+            auto high = decompress_int_registers(keys[completed / 4 + 1], data);
+
+            if (UseZigZag)
+            {
+                // (n >> 1) ^ - (n & 1)
+                auto const zero = _mm_setzero_si128();
+                low = _mm_xor_si128(_mm_srli_epi32(low, 1), _mm_sub_epi32(zero, _mm_and_si128(low, _mm_set1_epi32(1))));
+                high = _mm_xor_si128(_mm_srli_epi32(high, 1), _mm_sub_epi32(zero, _mm_and_si128(high, _mm_set1_epi32(1))));
+
+                // Prefix sum the deltas within each register, then add the running total.
+                low = _mm_add_epi32(low, _mm_slli_si128(low, 4));
+                low = _mm_add_epi32(low, _mm_slli_si128(low, 8));
+                low = _mm_add_epi32(low, previous);
+                previous = _mm_shuffle_epi32(low, 0xFF);
+
+                high = _mm_add_epi32(high, _mm_slli_si128(high, 4));
+                high = _mm_add_epi32(high, _mm_slli_si128(high, 8));
+                high = _mm_add_epi32(high, previous);
+                previous = _mm_shuffle_epi32(high, 0xFF);
+            }
+
+            output.store_int32_lanes(completed, low, high);
+        }
+
+        // Decode any remaining values using the generic implementation, which checks the stream bounds.
+        auto const data_begin = data.as_span<std::uint8_t const>().data();
+        auto const data_end = data_begin + data.size();
+        std::uint32_t previous_value = std::uint32_t(_mm_cvtsi128_si32(previous));
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        auto data_ptr = data_begin;
+        for (std::size_t offset = completed; offset < count; offset += tile.size())
         {
-            output[i] = input[i];
+            auto const tile_count = std::min(tile.size(), count - offset);
+            data_ptr = streamvbyte_decode_tile(keys.data() + offset / 4, data_ptr, data_end, tile.data(), tile_count);
+            if (!data_ptr)
+            {
+                return VBZ_STREAMVBYTE_STREAM_ERROR;
+            }
+            output.template store_tile<UseZigZag>(offset, tile.data(), tile_count, previous_value);
+        }
+
+        if (data_ptr != data_end)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
         }
+        return vbz_size_t(count);
     }
 };
+
+#ifndef __AVX2__
+template <>
+struct StreamVByteWorkerV0<std::int16_t, true> : StreamVByteWorkerV0Int16ZigZagSse3 {};
+#endif
+
+template <>
+struct StreamVByteWorkerV0<std::int8_t, true> : StreamVByteWorkerV0Sse3<std::int8_t, true> {};
+
+template <>
+struct StreamVByteWorkerV0<std::int8_t, false> : StreamVByteWorkerV0Sse3<std::int8_t, false> {};
+
+template <>
+struct StreamVByteWorkerV0<std::int16_t, false> : StreamVByteWorkerV0Sse3<std::int16_t, false> {};
+
+template <>
+struct StreamVByteWorkerV0<std::int32_t, true> : StreamVByteWorkerV0Sse3<std::int32_t, true> {};
+
+template <>
+struct StreamVByteWorkerV0<std::int32_t, false> : StreamVByteWorkerV0Sse3<std::int32_t, false> {};
+
+} // namespace
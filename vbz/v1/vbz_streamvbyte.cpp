@@ -1,8 +1,9 @@
 #include "vbz_streamvbyte.h"
-#include "vbz_streamvbyte_impl.h"
-#include "../v0/vbz_streamvbyte_impl.h" // for 4 byte case
+#include "../vbz_streamvbyte_kernels.h"
 #include "vbz.h"
 
+#include "streamvbyte.h"
+
 #include <cstdint>
 #include <gsl/gsl-lite.hpp>
 
@@ -26,42 +27,41 @@ vbz_size_t vbz_delta_zig_zag_streamvbyte_compress_v1(
     vbz_size_t destination_capacity,
     int integer_size,
     bool use_delta_zig_zag_encoding)
+{
+    return vbz_delta_zig_zag_streamvbyte_compress_seeded_v1(
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        integer_size,
+        use_delta_zig_zag_encoding,
+        0);
+}
+
+vbz_size_t vbz_delta_zig_zag_streamvbyte_compress_seeded_v1(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    int integer_size,
+    bool use_delta_zig_zag_encoding,
+    std::int32_t seed)
 {
     if (source_size % integer_size != 0)
     {
         return VBZ_INPUT_SIZE_ERROR;
     }
     
+    auto const kernel_index = streamvbyte_kernel_index(integer_size);
+    if (kernel_index < 0)
+    {
+        return VBZ_INTEGER_SIZE_ERROR;
+    }
+
     auto const input_span = gsl::make_span(static_cast<char const*>(source), source_size);
     auto const output_span = gsl::make_span(static_cast<char*>(destination), destination_capacity);
-    switch(integer_size) {
-        case 1: {
-            if (use_delta_zig_zag_encoding) {
-                return StreamVByteWorkerV1<std::int8_t, true>::compress(input_span, output_span);
-            }
-            else {
-                return StreamVByteWorkerV1<std::int8_t, false>::compress(input_span, output_span);
-            }
-        }
-        case 2: {
-            if (use_delta_zig_zag_encoding) {
-                return StreamVByteWorkerV0<std::int16_t, true>::compress(input_span, output_span);
-            }
-            else {
-                return StreamVByteWorkerV0<std::int16_t, false>::compress(input_span, output_span);
-            }
-        }
-        case 4: {
-            if (use_delta_zig_zag_encoding) {
-                return StreamVByteWorkerV0<std::int32_t, true>::compress(input_span, output_span);
-            }
-            else {
-                return StreamVByteWorkerV0<std::int32_t, false>::compress(input_span, output_span);
-            }
-        }
-        default:
-            return VBZ_INTEGER_SIZE_ERROR;
-    }
+    auto const kernel = vbz_streamvbyte_kernels().compress_v1[kernel_index][use_delta_zig_zag_encoding];
+    return kernel(input_span, output_span, seed);
 }
 
 vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_v1(
@@ -71,43 +71,91 @@ vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_v1(
     vbz_size_t destination_size,
     int integer_size,
     bool use_delta_zig_zag_encoding)
+{
+    return vbz_delta_zig_zag_streamvbyte_decompress_seeded_v1(
+        source,
+        source_size,
+        destination,
+        destination_size,
+        integer_size,
+        use_delta_zig_zag_encoding,
+        0);
+}
+
+vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_seeded_v1(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_size,
+    int integer_size,
+    bool use_delta_zig_zag_encoding,
+    std::int32_t seed)
 {
     if (destination_size % integer_size != 0)
     {
         return VBZ_DESTINATION_SIZE_ERROR;
     }
     
+    auto const kernel_index = streamvbyte_kernel_index(integer_size);
+    if (kernel_index < 0)
+    {
+        return VBZ_INTEGER_SIZE_ERROR;
+    }
+
     auto const input_span = gsl::make_span(static_cast<char const*>(source), source_size);
     auto const output_span = gsl::make_span(static_cast<char*>(destination), destination_size);
-    switch(integer_size) {
-        case 1: {
-            if (use_delta_zig_zag_encoding) {
-                return StreamVByteWorkerV1<std::int8_t, true>::decompress(input_span, output_span);
-            }
-            else {
-                return StreamVByteWorkerV1<std::int8_t, false>::decompress(input_span, output_span);
-            }
-        }
-        // Integers larger than 1 byte have been shown to perform better (with zstd) when using version 0 compression
-        // likely the increased noise in the key section reduces compression efficiency negating the benefits of
-        // compressing 1 byte values into halfs.
-        case 2: {
-            if (use_delta_zig_zag_encoding) {
-                return StreamVByteWorkerV0<std::int16_t, true>::decompress(input_span, output_span);
-            }
-            else {
-                return StreamVByteWorkerV0<std::int16_t, false>::decompress(input_span, output_span);
-            }
-        }
-        case 4: {
-            if (use_delta_zig_zag_encoding) {
-                return StreamVByteWorkerV0<std::int32_t, true>::decompress(input_span, output_span);
-            }
-            else {
-                return StreamVByteWorkerV0<std::int32_t, false>::decompress(input_span, output_span);
-            }
-        }
-        default:
-            return VBZ_INTEGER_SIZE_ERROR;
+    auto const kernel = vbz_streamvbyte_kernels().decompress_v1[kernel_index][use_delta_zig_zag_encoding];
+    return kernel(input_span, output_span, seed);
+}
+
+vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_float_v1(
+    void const* source,
+    vbz_size_t source_size,
+    float* destination,
+    vbz_size_t destination_size,
+    int integer_size,
+    bool use_delta_zig_zag_encoding,
+    float offset,
+    float scale)
+{
+    if (destination_size % sizeof(float) != 0)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    auto const kernel_index = streamvbyte_kernel_index(integer_size);
+    if (kernel_index < 0)
+    {
+        return VBZ_INTEGER_SIZE_ERROR;
     }
+
+    auto const input_span = gsl::make_span(static_cast<char const*>(source), source_size);
+    auto const output_span = gsl::make_span(destination, destination_size / sizeof(float));
+    auto const kernel = vbz_streamvbyte_kernels().decompress_float_v1[kernel_index][use_delta_zig_zag_encoding];
+    return kernel(input_span, output_span, StreamVByteCalibration{ offset, scale }, 0);
+}
+
+vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_int32_v1(
+    void const* source,
+    vbz_size_t source_size,
+    std::int32_t* destination,
+    vbz_size_t destination_size,
+    int integer_size,
+    bool use_delta_zig_zag_encoding)
+{
+    if (destination_size % sizeof(std::int32_t) != 0)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    auto const kernel_index = streamvbyte_kernel_index(integer_size);
+    if (kernel_index < 0)
+    {
+        return VBZ_INTEGER_SIZE_ERROR;
+    }
+
+    auto const input_span = gsl::make_span(static_cast<char const*>(source), source_size);
+    auto const output_span = gsl::make_span(destination, destination_size / sizeof(std::int32_t));
+    auto const kernel = vbz_streamvbyte_kernels().decompress_int32_v1[kernel_index][use_delta_zig_zag_encoding];
+    return kernel(input_span, output_span, 0);
 }
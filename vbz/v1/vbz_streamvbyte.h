@@ -4,6 +4,7 @@
 #include "vbz.h"
 
 #include <cstddef>
+#include <cstdint>
 
 // Version 1 of streamvbyte
 //
@@ -51,4 +52,64 @@ VBZ_EXPORT vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_v1(
     void* destination,
     vbz_size_t destination_size,
     int integer_size,
-    bool use_delta_zig_zag_encoding);
\ No newline at end of file
+    bool use_delta_zig_zag_encoding);
+
+/// \brief Encode the source data as #vbz_delta_zig_zag_streamvbyte_compress_v1, taking the first delta from [seed].
+///
+/// Used to split data into blocks which can each be decoded independently, while deltas still
+/// run across block boundaries.
+/// \param seed                         The value preceding the first source integer (0 when unsplit).
+/// \return The number of bytes used to compress data into [destination].
+VBZ_EXPORT vbz_size_t vbz_delta_zig_zag_streamvbyte_compress_seeded_v1(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    int integer_size,
+    bool use_delta_zig_zag_encoding,
+    std::int32_t seed);
+
+/// \brief Decode the source data as #vbz_delta_zig_zag_streamvbyte_decompress_v1, for data compressed with
+///        #vbz_delta_zig_zag_streamvbyte_compress_seeded_v1.
+/// \param seed                         The seed used to compress the data.
+/// \return The number of bytes used to decompress data into [destination].
+VBZ_EXPORT vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_seeded_v1(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_size,
+    int integer_size,
+    bool use_delta_zig_zag_encoding,
+    std::int32_t seed);
+
+/// \brief Decode the source data as #vbz_delta_zig_zag_streamvbyte_decompress_v1, converting each value
+///        to a calibrated float, (value + offset) * scale, as it is decoded.
+/// \param destination_size             Size of the destination buffer to write to in bytes.
+///                                     This must be a multiple of sizeof(float), and hold exactly one float per
+///                                     expected output integer.
+/// \param offset                       Offset added to each decoded value.
+/// \param scale                        Scale each offset value is multiplied by.
+/// \return The number of bytes written to [destination].
+VBZ_EXPORT vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_float_v1(
+    void const* source,
+    vbz_size_t source_size,
+    float* destination,
+    vbz_size_t destination_size,
+    int integer_size,
+    bool use_delta_zig_zag_encoding,
+    float offset,
+    float scale);
+
+/// \brief Decode the source data as #vbz_delta_zig_zag_streamvbyte_decompress_v1, widening each value
+///        to int32 as it is decoded.
+/// \param destination_size             Size of the destination buffer to write to in bytes.
+///                                     This must be a multiple of sizeof(int32_t), and hold exactly one int32 per
+///                                     expected output integer.
+/// \return The number of bytes written to [destination].
+VBZ_EXPORT vbz_size_t vbz_delta_zig_zag_streamvbyte_decompress_int32_v1(
+    void const* source,
+    vbz_size_t source_size,
+    std::int32_t* destination,
+    vbz_size_t destination_size,
+    int integer_size,
+    bool use_delta_zig_zag_encoding);
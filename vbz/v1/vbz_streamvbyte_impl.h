@@ -1,15 +1,18 @@
 #pragma once
 
 #include "vbz.h"
+#include "vbz_streamvbyte_output.h"
+#include "vbz_streamvbyte_tile.h"
 
 #include "streamvbyte.h"
-#include "streamvbyte_zigzag.h"
 
 #include <gsl/gsl-lite.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
-#include <vector>
 #include <cstdint>
+#include <cstring>
 
 #ifdef _MSC_VER
 # define VBZ_RESTRICT __restrict
@@ -17,6 +20,8 @@
 # define VBZ_RESTRICT __restrict__
 #endif
 
+namespace {
+
 static inline uint32_t _decode_data(const uint8_t **dataPtrPtr, uint8_t code, uint8_t *data_shift) {
     uint32_t val;
     
@@ -55,13 +60,14 @@ static inline uint32_t _decode_data(const uint8_t **dataPtrPtr, uint8_t code, ui
 
     return val;
 }
+// [data_shift] holds the position within the current data byte, so a stream can be decoded in several calls.
 static const uint8_t *svb_decode_scalar(uint32_t *outPtr, const uint8_t *keyPtr,
                                         const uint8_t *dataPtr,
+                                        uint8_t *data_shift,
                                         uint32_t count) {
     if (count == 0)
         return dataPtr; // no reads or writes if no data
     
-    uint8_t data_shift = 0;
     uint8_t shift = 0;
     uint32_t key = *keyPtr++;
     for (uint32_t c = 0; c < count; c++) {
@@ -69,17 +75,12 @@ static const uint8_t *svb_decode_scalar(uint32_t *outPtr, const uint8_t *keyPtr,
             shift = 0;
             key = *keyPtr++;
         }
-        uint32_t val = _decode_data(&dataPtr, (key >> shift) & 0x3, &data_shift);
+        uint32_t val = _decode_data(&dataPtr, (key >> shift) & 0x3, data_shift);
         *outPtr++ = val;
         shift += 2;
     }
     
-    if (data_shift != 0)
-    {
-        dataPtr += 1;
-    }
-    
-    return dataPtr; // pointer to first unused byte after end
+    return dataPtr; // pointer to the partially read data byte
 }
 
 static uint8_t _encode_data(uint32_t val, uint8_t *VBZ_RESTRICT *dataPtrPtr, uint8_t* data_shift) {
@@ -125,14 +126,15 @@ static uint8_t _encode_data(uint32_t val, uint8_t *VBZ_RESTRICT *dataPtrPtr, uin
     return code;
 }
 
+// [data_shift] holds the position within the current data byte, so a stream can be encoded in several calls.
 static uint8_t *svb_encode_scalar(const uint32_t *in,
                                   uint8_t *VBZ_RESTRICT keyPtr,
                                   uint8_t *VBZ_RESTRICT dataPtr,
+                                  uint8_t *data_shift,
                                   uint32_t count) {
     if (count == 0)
         return dataPtr; // exit immediately if no data
 
-    uint8_t data_shift = 0;
     uint8_t shift = 0; // cycles 0, 2, 4, 6, 0, 2, 4, 6, ...
     uint8_t key = 0;
     for (uint32_t c = 0; c < count; c++) {
@@ -142,160 +144,102 @@ static uint8_t *svb_encode_scalar(const uint32_t *in,
             key = 0;
         }
         uint32_t val = in[c];
-        uint8_t code = _encode_data(val, &dataPtr, &data_shift);
+        uint8_t code = _encode_data(val, &dataPtr, data_shift);
         key |= code << shift;
         shift += 2;
     }
-    
-    if (data_shift != 0)
-    {
-        dataPtr += 1;
-    }
 
     *keyPtr = key;  // write last key (no increment needed)
-    return dataPtr; // pointer to first unused data byte
-}
-
-static vbz_size_t streamvbyte_encode_half(uint32_t const* input, uint32_t count, uint8_t* output)
-{
-    uint8_t *keyPtr = output;
-    uint32_t keyLen = (count + 3) / 4;  // 2-bits rounded to full byte
-    uint8_t *dataPtr = keyPtr + keyLen; // variable byte data after all keys
-    
-    return vbz_size_t(svb_encode_scalar(input, keyPtr, dataPtr, count) - output);
-}
-
-static vbz_size_t streamvbyte_decode_half(uint8_t const* input, uint32_t* output, uint32_t count)
-{
-    uint8_t *keyPtr = (uint8_t*)input;
-    uint32_t keyLen = (count + 3) / 4;  // 2-bits rounded to full byte
-    uint8_t *dataPtr = keyPtr + keyLen; // variable byte data after all keys
-    
-    return vbz_size_t(svb_decode_scalar(
-        output,
-        keyPtr,
-        dataPtr,
-        count
-        ) - input);
+    return dataPtr; // pointer to the partially written data byte
 }
 
-// Basically a copy of streamvbyte_validate_stream from streamvbyte, but adjusted for our code sizes.
-static bool streamvbyte_validate_stream_half(uint8_t const* in, size_t inCount, uint32_t outCount)
-{
-  if (inCount == 0 || outCount == 0)
-    return inCount == outCount;
-
-  // 2-bits per key (rounded up)
-  // Note that we don't add to outCount in case it overflows
-  uint32_t keyLen = outCount / 4;
-  if (outCount & 3)
-    keyLen++;
-
-  // Check that there's enough space for the keys
-  if (keyLen > inCount)
-    return false;
-
-  // Accumulate the key sizes in a wider type to avoid overflow
-  const uint8_t *keyPtr = in;
-  uint8_t shift = 0;
-  uint32_t key = *keyPtr++;
-  uint64_t encodedSize = 0;
-  for (uint32_t c = 0; c < outCount; c++) {
-    if (shift == 8) {
-      shift = 0;
-      key = *keyPtr++;
-    }
-    const uint8_t code = (key >> shift) & 0x3;
-    encodedSize += (1 << code) >> 1;
-    shift += 2;
-  }
-  // We encode in nibbles so round up
-  encodedSize = (encodedSize + 1) / 2;
-
-  return encodedSize == inCount - keyLen;
-}
-
-
 /// \brief Generic implementation, safe for all integer types, and platforms.
+///
+/// Input is converted and encoded one tile at a time, so no intermediate buffers are allocated.
 template <typename T, bool UseZigZag>
 struct StreamVByteWorkerV1
 {
-    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output)
+    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output, std::int32_t seed)
     {
         auto const input = input_bytes.as_span<T const>();
-        
-        if (!UseZigZag)
+        auto const count = input.size();
+
+        auto const output_begin = output.as_span<std::uint8_t>().data();
+        auto const key_ptr = output_begin;
+        auto data_ptr = key_ptr + (count + 3) / 4;
+        std::uint8_t data_shift = 0;
+
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        std::uint32_t previous = std::uint32_t(seed);
+        for (std::size_t offset = 0; offset < count; offset += tile.size())
         {
-            auto input_buffer = cast<std::uint32_t>(input);
-            return vbz_size_t(streamvbyte_encode_half(
-                input_buffer.data(),
-                std::uint32_t(input_buffer.size()),
-                output.as_span<std::uint8_t>().data()
-            ));
+            auto const tile_count = std::min(tile.size(), count - offset);
+            to_streamvbyte_values<UseZigZag>(input.data() + offset, tile.data(), tile_count, previous);
+            data_ptr = svb_encode_scalar(tile.data(), key_ptr + offset / 4, data_ptr, &data_shift, std::uint32_t(tile_count));
         }
-        
-        std::vector<std::int32_t> input_buffer = cast<std::int32_t>(input);
-        std::vector<std::uint32_t> intermediate_buffer(input.size());
-        zigzag_delta_encode(input_buffer.data(), intermediate_buffer.data(), input_buffer.size(), 0);
 
-        return vbz_size_t(streamvbyte_encode_half(
-            intermediate_buffer.data(),
-            std::uint32_t(intermediate_buffer.size()),
-            output.as_span<std::uint8_t>().data()
-        ));
+        // Include the final partially written byte.
+        if (data_shift != 0)
+        {
+            data_ptr += 1;
+        }
+        return vbz_size_t(data_ptr - output_begin);
     }
     
-    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes)
+    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes, std::int32_t seed)
     {
         auto const output = output_bytes.as_span<T>();
-        auto in_data = input.as_span<std::uint8_t const>().data();
-        auto const out_size = vbz_size_t(output.size());
+        return decompressed_bytes<T>(decompress_to(input, output.size(), IntegerOutput<T>{ output.data() }, seed));
+    }
 
-        if (!streamvbyte_validate_stream_half(in_data, input.size_bytes(), out_size)) {
-            return VBZ_STREAMVBYTE_STREAM_ERROR;
-        }
-        
-        std::vector<std::uint32_t> intermediate_buffer(out_size);
-        auto read_bytes = streamvbyte_decode_half(
-            in_data,
-            intermediate_buffer.data(),
-            out_size
-        );
-        if (read_bytes != input.size())
+    /// \brief Decode [count] values from [input], writing them to [output].
+    /// \param seed The value preceding the first value, which zig zag deltas start from.
+    /// \return The number of values decoded, or an error.
+    template <typename Output>
+    static vbz_size_t decompress_to(gsl::span<char const> input, std::size_t count, Output output, std::int32_t seed)
+    {
+        auto const in_data = input.as_span<std::uint8_t const>().data();
+
+        vbz_size_t key_byte_count = vbz_size_t((count + 3) / 4);
+        if (input.size() < key_byte_count)
         {
             return VBZ_STREAMVBYTE_STREAM_ERROR;
         }
-        
-        if (!UseZigZag)
-        {
-            cast(gsl::make_span(intermediate_buffer), output);
-            return vbz_size_t(output.size() * sizeof(T));
-        }
-        
-        std::vector<std::int32_t> output_buffer(output.size());
-        zigzag_delta_decode(intermediate_buffer.data(), output_buffer.data(), output_buffer.size(), 0);
-        
-        cast(gsl::make_span(output_buffer), output);
-        return vbz_size_t(output.size() * sizeof(T));
-    }
-    
-    template <typename U, typename V>
-    static std::vector<U> cast(gsl::span<V> const& input)
-    {
-        std::vector<U> output(input.size());
-        for (std::size_t i = 0; i < input.size(); ++i)
+
+        auto const key_ptr = in_data;
+        auto data_ptr = key_ptr + key_byte_count;
+        auto const data_nibbles = 2 * std::uint64_t(input.size() - key_byte_count);
+        std::uint64_t nibble = 0;
+        std::uint8_t data_shift = 0;
+
+        std::array<std::uint32_t, STREAMVBYTE_TILE_SIZE> tile;
+        std::uint32_t previous = std::uint32_t(seed);
+        for (std::size_t offset = 0; offset < count; offset += tile.size())
         {
-            output[i] = input[i];
+            auto const tile_count = std::min(tile.size(), count - offset);
+
+            // Check the tile fits in the input before reading any of its data.
+            nibble += streamvbyte_data_units(key_ptr + offset / 4, tile_count, true);
+            if (nibble > data_nibbles)
+            {
+                return VBZ_STREAMVBYTE_STREAM_ERROR;
+            }
+
+            data_ptr = svb_decode_scalar(tile.data(), key_ptr + offset / 4, data_ptr, &data_shift, std::uint32_t(tile_count));
+            output.template store_tile<UseZigZag>(offset, tile.data(), tile_count, previous);
         }
-        return output;
-    }
-    
-    template <typename U, typename V>
-    static void cast(gsl::span<U> input, gsl::span<V> output)
-    {
-        for (std::size_t i = 0; i < input.size(); ++i)
+
+        // The data must end with the final, possibly partially used, byte.
+        if ((nibble + 1) / 2 != data_nibbles / 2)
         {
-            output[i] = input[i];
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
         }
+        return vbz_size_t(count);
     }
 };
+
+} // namespace
+
+#ifdef __SSSE3__
+#include "vbz_streamvbyte_impl_sse3.h"
+#endif
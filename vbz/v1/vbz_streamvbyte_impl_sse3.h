@@ -0,0 +1,330 @@
+#pragma once
+
+#include <cstring>
+
+#if (defined __INTEL_COMPILER) && (defined WIN32)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+/// \brief Shuffles for coding 4 values in the half byte format, one nibble per byte.
+///
+/// Each table is indexed by the key byte for the 4 values. Unpacked, value i uses bytes [4 * i, 4 * i + 4).
+struct StreamVByteNibbleShuffleTables
+{
+    std::uint8_t encode[256][16];
+    std::uint8_t decode[256][16];
+    std::uint8_t length[256];
+};
+
+constexpr StreamVByteNibbleShuffleTables make_nibble_shuffle_tables()
+{
+    StreamVByteNibbleShuffleTables tables{};
+    for (std::size_t key = 0; key < 256; ++key)
+    {
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            auto const code = (key >> (i * 2)) & 0x3;
+            auto const nibbles = code == 3 ? 4 : code;
+            for (std::size_t nibble = 0; nibble < 4; ++nibble)
+            {
+                if (nibble < nibbles)
+                {
+                    tables.encode[key][position] = std::uint8_t(i * 4 + nibble);
+                    tables.decode[key][i * 4 + nibble] = std::uint8_t(position);
+                    position += 1;
+                }
+                else
+                {
+                    tables.decode[key][i * 4 + nibble] = 0x80;
+                }
+            }
+        }
+
+        tables.length[key] = std::uint8_t(position);
+        for (; position < 16; ++position)
+        {
+            tables.encode[key][position] = 0x80;
+        }
+    }
+    return tables;
+}
+
+static constexpr StreamVByteNibbleShuffleTables nibble_shuffle_tables = make_nibble_shuffle_tables();
+
+/// \brief Find the key code for each 16 bit value.
+inline static __m128i nibble_codes(__m128i values)
+{
+    // 3, less one for each of the value, its top 12 bits and its top 8 bits being zero.
+    auto const zero = _mm_setzero_si128();
+    auto codes = _mm_add_epi16(_mm_set1_epi16(3), _mm_cmpeq_epi16(values, zero));
+    codes = _mm_add_epi16(codes, _mm_cmpeq_epi16(_mm_srli_epi16(values, 4), zero));
+    return _mm_add_epi16(codes, _mm_cmpeq_epi16(_mm_srli_epi16(values, 8), zero));
+}
+
+/// \brief Pair up bytes holding one nibble each, into the bytes of the half byte format.
+inline static __m128i pack_nibbles(__m128i nibbles)
+{
+    return _mm_packus_epi16(_mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x1001)), _mm_setzero_si128());
+}
+
+/// \brief Writes groups of 4 values to the data section, a nibble at a time.
+struct NibbleWriter
+{
+    std::uint8_t* data_ptr;
+
+    // Nibbles not yet written, and the number of bits of [pending] they use.
+    std::uint64_t pending = 0;
+    unsigned pending_bits = 0;
+
+    /// \param nibbles Each byte holds a nibble, 4 per 16 bit value.
+    void write(__m128i nibbles, std::uint8_t key)
+    {
+        auto const shuffle = _mm_loadu_si128((__m128i const*)nibble_shuffle_tables.encode[key]);
+        std::uint64_t bits = 0;
+        _mm_storel_epi64((__m128i*)&bits, pack_nibbles(_mm_shuffle_epi8(nibbles, shuffle)));
+
+        auto const bit_count = 4u * nibble_shuffle_tables.length[key];
+        pending |= bits << pending_bits;
+        pending_bits += bit_count;
+        if (pending_bits >= 64)
+        {
+            std::memcpy(data_ptr, &pending, sizeof(pending));
+            data_ptr += sizeof(pending);
+            pending_bits -= 64;
+            pending = pending_bits ? bits >> (bit_count - pending_bits) : 0;
+        }
+    }
+
+    /// \brief Write the remaining nibbles, leaving data_ptr and [data_shift] as svb_encode_scalar expects them.
+    void finish(std::uint8_t& data_shift)
+    {
+        auto const byte_count = (pending_bits + 7) / 8;
+        if (byte_count != 0)
+        {
+            std::memcpy(data_ptr, &pending, byte_count);
+        }
+        data_ptr += pending_bits / 8;
+        data_shift = std::uint8_t(pending_bits % 8);
+    }
+};
+
+/// \brief Read the values for one key from [data], starting at nibble [nibble], and move past them.
+/// \return 4 16 bit values, in the low half of the register.
+inline static __m128i read_nibble_values(std::uint8_t const* data, std::size_t& nibble, std::uint8_t key)
+{
+    auto const raw = _mm_loadu_si128((__m128i const*)(data + nibble / 2));
+
+    // Starting half way through a byte, shift the whole low 64 bits down a nibble.
+    auto const shift = int(nibble & 1) * 4;
+    auto const aligned = _mm_or_si128(
+        _mm_srl_epi64(raw, _mm_cvtsi32_si128(shift)),
+        _mm_sll_epi64(_mm_srli_si128(raw, 8), _mm_cvtsi32_si128(64 - shift))
+    );
+
+    auto const mask = _mm_set1_epi8(0x0F);
+    auto const nibbles = _mm_unpacklo_epi8(_mm_and_si128(aligned, mask), _mm_and_si128(_mm_srli_epi16(aligned, 4), mask));
+    auto const shuffle = _mm_loadu_si128((__m128i const*)nibble_shuffle_tables.decode[key]);
+
+    nibble += nibble_shuffle_tables.length[key];
+    return pack_nibbles(_mm_shuffle_epi8(nibbles, shuffle));
+}
+
+/// \brief Optimised ssse3 implementation of the half byte format for int8 data, 16 values at a time.
+///
+/// Nibbles are gathered and scattered with table driven shuffles, producing the same bytes as
+/// StreamVByteWorkerV1. 8 bit values and their deltas fit in 16 bits, so never need more than 4 nibbles.
+template <bool UseZigZag>
+struct StreamVByteWorkerV1Int8Sse3
+{
+    static vbz_size_t compress(gsl::span<char const> input_bytes, gsl::span<char> output, std::int32_t seed)
+    {
+        auto const input = input_bytes.as_span<std::int8_t const>();
+        auto const count = input.size();
+        if (output.size() < streamvbyte_max_compressedbytes(std::uint32_t(count)))
+        {
+            return VBZ_DESTINATION_SIZE_ERROR;
+        }
+
+        auto const output_begin = output.as_span<std::uint8_t>().data();
+        auto key_ptr = output_begin;
+        NibbleWriter writer{ key_ptr + (count + 3) / 4 };
+
+        auto const mask = _mm_set1_epi8(0x0F);
+        auto previous = _mm_set1_epi16(std::int8_t(seed));
+        std::size_t completed = 0;
+        for (; completed + 16 <= count; completed += 16)
+        {
+            auto const bytes = _mm_loadu_si128((__m128i const*)(input.data() + completed));
+            auto low = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+            auto high = _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8);
+
+            if (UseZigZag)
+            {
+                // Shift each value up a lane, pulling in the last value of the previous register.
+                auto const low_delta = _mm_sub_epi16(low, _mm_alignr_epi8(low, previous, 14));
+                auto const high_delta = _mm_sub_epi16(high, _mm_alignr_epi8(high, low, 14));
+                previous = high;
+
+                low = _mm_xor_si128(_mm_slli_epi16(low_delta, 1), _mm_srai_epi16(low_delta, 15));
+                high = _mm_xor_si128(_mm_slli_epi16(high_delta, 1), _mm_srai_epi16(high_delta, 15));
+            }
+
+            // Combine the 16 codes into 4 key bytes: c0 + 4 * c1, then + 16 * (c2 + 4 * c3).
+            auto const codes = _mm_packus_epi16(nibble_codes(low), nibble_codes(high));
+            auto const key_pairs = _mm_maddubs_epi16(codes, _mm_set1_epi16(0x0401));
+            auto const key_words = _mm_madd_epi16(key_pairs, _mm_set1_epi32(0x00100001));
+            auto const to_key_bytes = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            auto const keys = std::uint32_t(_mm_cvtsi128_si32(_mm_shuffle_epi8(key_words, to_key_bytes)));
+            std::memcpy(key_ptr, &keys, sizeof(keys));
+            key_ptr += sizeof(keys);
+
+            auto const low_nibbles = _mm_and_si128(low, mask);
+            auto const low_high_nibbles = _mm_and_si128(_mm_srli_epi16(low, 4), mask);
+            writer.write(_mm_unpacklo_epi8(low_nibbles, low_high_nibbles), std::uint8_t(keys));
+            writer.write(_mm_unpackhi_epi8(low_nibbles, low_high_nibbles), std::uint8_t(keys >> 8));
+
+            auto const high_nibbles = _mm_and_si128(high, mask);
+            auto const high_high_nibbles = _mm_and_si128(_mm_srli_epi16(high, 4), mask);
+            writer.write(_mm_unpacklo_epi8(high_nibbles, high_high_nibbles), std::uint8_t(keys >> 16));
+            writer.write(_mm_unpackhi_epi8(high_nibbles, high_high_nibbles), std::uint8_t(keys >> 24));
+        }
+
+        std::uint8_t data_shift = 0;
+        writer.finish(data_shift);
+
+        // Encode any remaining values using the generic implementation.
+        std::array<std::uint32_t, 16> final_elements;
+        auto const remaining = count - completed;
+        std::uint32_t previous_value = completed == 0 ? std::uint32_t(seed) : std::uint32_t(input[completed - 1]);
+        to_streamvbyte_values<UseZigZag>(input.data() + completed, final_elements.data(), remaining, previous_value);
+        auto data_ptr = svb_encode_scalar(final_elements.data(), key_ptr, writer.data_ptr, &data_shift, std::uint32_t(remaining));
+
+        // Include the final partially written byte.
+        if (data_shift != 0)
+        {
+            data_ptr += 1;
+        }
+        return vbz_size_t(data_ptr - output_begin);
+    }
+
+    static vbz_size_t decompress(gsl::span<char const> input, gsl::span<char> output_bytes, std::int32_t seed)
+    {
+        auto const output = output_bytes.as_span<std::int8_t>();
+        return decompressed_bytes<std::int8_t>(decompress_to(input, output.size(), IntegerOutput<std::int8_t>{ output.data() }, seed));
+    }
+
+    /// \brief Decode [count] values from [input], writing them to [output].
+    /// \param seed The value preceding the first value, which zig zag deltas start from.
+    /// \return The number of values decoded, or an error.
+    template <typename Output>
+    static vbz_size_t decompress_to(gsl::span<char const> input, std::size_t count, Output output, std::int32_t seed)
+    {
+        auto const in_data = input.as_span<std::uint8_t const>().data();
+
+        vbz_size_t key_byte_count = vbz_size_t((count + 3) / 4);
+        if (input.size() < key_byte_count)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+
+        auto const key_ptr = in_data;
+        auto const data_nibbles = 2 * std::uint64_t(input.size() - key_byte_count);
+
+        // Data is read 16 bytes at a time, so the end of the stream is copied into a padded buffer first.
+        std::array<std::uint8_t, 96> end_buffer{};
+        auto data = key_ptr + key_byte_count;
+        auto data_size = std::size_t(input.size() - key_byte_count);
+        std::uint64_t data_offset = 0;
+
+        auto const low_bytes = _mm_set1_epi16(0x00FF);
+        auto previous = _mm_set1_epi8(std::int8_t(seed));
+        std::size_t nibble = 0;
+        std::size_t completed = 0;
+        for (; completed + 16 <= count; completed += 16)
+        {
+            std::uint32_t keys = 0;
+            std::memcpy(&keys, key_ptr + completed / 4, sizeof(keys));
+
+            // Check the values fit in the input before reading any of their data.
+            if (data_offset + nibble + streamvbyte_code_units(keys, true) > data_nibbles)
+            {
+                return VBZ_STREAMVBYTE_STREAM_ERROR;
+            }
+
+            // 16 values use at most 32 bytes, and each key loads 16.
+            if (data_size - nibble / 2 < 48 && data != end_buffer.data())
+            {
+                std::memcpy(end_buffer.data(), data + nibble / 2, data_size - nibble / 2);
+                data_size -= nibble / 2;
+                data_offset += nibble & ~std::size_t(1);
+                nibble &= 1;
+                data = end_buffer.data();
+            }
+
+            auto const first = read_nibble_values(data, nibble, std::uint8_t(keys));
+            auto const second = read_nibble_values(data, nibble, std::uint8_t(keys >> 8));
+            auto const third = read_nibble_values(data, nibble, std::uint8_t(keys >> 16));
+            auto const fourth = read_nibble_values(data, nibble, std::uint8_t(keys >> 24));
+            auto low = _mm_unpacklo_epi64(first, second);
+            auto high = _mm_unpacklo_epi64(third, fourth);
+
+            if (UseZigZag)
+            {
+                // (n >> 1) ^ - (n & 1)
+                auto const zero = _mm_setzero_si128();
+                auto const one = _mm_set1_epi16(1);
+                low = _mm_xor_si128(_mm_srli_epi16(low, 1), _mm_sub_epi16(zero, _mm_and_si128(low, one)));
+                high = _mm_xor_si128(_mm_srli_epi16(high, 1), _mm_sub_epi16(zero, _mm_and_si128(high, one)));
+            }
+
+            auto values = _mm_packus_epi16(_mm_and_si128(low, low_bytes), _mm_and_si128(high, low_bytes));
+
+            if (UseZigZag)
+            {
+                // Only the low 8 bits of the running total are kept, so prefix sum in 8 bit lanes.
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 1));
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 2));
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 4));
+                values = _mm_add_epi8(values, _mm_slli_si128(values, 8));
+                values = _mm_add_epi8(values, previous);
+                previous = _mm_shuffle_epi8(values, _mm_set1_epi8(15));
+            }
+
+            output.store_lanes(completed, values);
+        }
+
+        // Decode any remaining values using the generic implementation.
+        auto const remaining = count - completed;
+        auto const total_nibbles = data_offset + nibble + streamvbyte_data_units(key_ptr + completed / 4, remaining, true);
+        if (total_nibbles > data_nibbles)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+
+        std::array<std::uint32_t, 16> final_elements;
+        std::uint8_t data_shift = std::uint8_t((nibble & 1) * 4);
+        std::uint32_t previous_value = std::uint32_t(std::int32_t(std::int8_t(_mm_cvtsi128_si32(previous))));
+        svb_decode_scalar(final_elements.data(), key_ptr + completed / 4, data + nibble / 2, &data_shift, std::uint32_t(remaining));
+        output.template store_tile<UseZigZag>(completed, final_elements.data(), remaining, previous_value);
+
+        // The data must end with the final, possibly partially used, byte.
+        if ((total_nibbles + 1) / 2 != data_nibbles / 2)
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+        return vbz_size_t(count);
+    }
+};
+
+template <>
+struct StreamVByteWorkerV1<std::int8_t, true> : StreamVByteWorkerV1Int8Sse3<true> {};
+
+template <>
+struct StreamVByteWorkerV1<std::int8_t, false> : StreamVByteWorkerV1Int8Sse3<false> {};
+
+} // namespace
@@ -1,25 +1,24 @@
 #include "v0/vbz_streamvbyte.h"
 #include "v1/vbz_streamvbyte.h"
+#include "vbz_context.h"
+#include "vbz_sized64.h"
+#include "vbz_stages.h"
 
 #include <gsl/gsl-lite.hpp>
 #include <zstd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <new>
 
 // include last - it uses c headers which can mess things up.
 #include "vbz.h"
 
 namespace {
-// util for using malloc with unique_ptr.
-// This is required since a vector would throw if the size was too big.
-struct free_delete
-{
-    void operator()(void* x) { free(x); }
-};
-    
 gsl::span<char> make_data_buffer(void* data, vbz_size_t size)
 {
     return gsl::make_span(static_cast<char*>(data), size);
@@ -49,101 +48,271 @@ bool is_valid_integer_size(CompressionOptions const* options) {
         ;
 }
 
-struct VbzSizedHeader
+/// \brief Compress [source] as a zstd frame in [destination], applying [zstd_parameters] if set,
+///        and the context's prefix or dictionary if it has one.
+/// \return The size of the frame in bytes, or an error.
+vbz_size_t compress_zstd_frame(
+    vbz_context* context,
+    gsl::span<char const> source,
+    gsl::span<char> destination,
+    int compression_level,
+    VbzZstdParameters const* zstd_parameters)
 {
-    vbz_size_t original_size;
-};
+    auto const prefix = context->take_zstd_prefix();
+    auto zstd_context = context->zstd_compression_context();
+    if (!zstd_context)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
 
-}
+    ZSTD_CDict const* dictionary = nullptr;
+    if (prefix.empty() && context->has_zstd_dictionary())
+    {
+        dictionary = context->zstd_compression_dictionary(compression_level);
+        if (!dictionary)
+        {
+            return VBZ_OUT_OF_MEMORY_ERROR;
+        }
+    }
 
-extern "C" {
+    // The context is shared between calls, and the simple compression functions keep any advanced
+    // parameters an earlier call set, so always start from the defaults.
+    ZSTD_CCtx_reset(zstd_context, ZSTD_reset_session_and_parameters);
 
-bool vbz_is_error(vbz_size_t result_value)
-{
-    return result_value >= VBZ_FIRST_ERROR;
-}
+    std::size_t compressed_size = 0;
+    if (!zstd_parameters && prefix.empty() && dictionary)
+    {
+        compressed_size = ZSTD_compress_usingCDict(
+            zstd_context,
+            destination.data(),
+            destination.size(),
+            source.data(),
+            source.size(),
+            dictionary
+        );
+    }
+    else if (!zstd_parameters && prefix.empty())
+    {
+        compressed_size = ZSTD_compressCCtx(
+            zstd_context,
+            destination.data(),
+            destination.size(),
+            source.data(),
+            source.size(),
+            compression_level
+        );
+    }
+    else
+    {
+        auto const set_advanced_parameters = [&]
+        {
+            auto const worker_bounds = ZSTD_cParam_getBounds(ZSTD_c_nbWorkers);
+            auto const worker_count = ZSTD_isError(worker_bounds.error) ? 0
+                : std::min(std::max(zstd_parameters->worker_count, 0), worker_bounds.upperBound);
 
-char const* vbz_error_string(vbz_size_t error_value)
-{
-    if (VBZ_ZSTD_ERROR == error_value) return "VBZ_ZSTD_ERROR";
-    if (VBZ_INPUT_SIZE_ERROR == error_value) return "VBZ_INPUT_SIZE_ERROR";
-    if (VBZ_INTEGER_SIZE_ERROR == error_value) return "VBZ_INTEGER_SIZE_ERROR";
-    if (VBZ_DESTINATION_SIZE_ERROR == error_value) return "VBZ_DESTINATION_SIZE_ERROR";
-    if (VBZ_STREAMVBYTE_STREAM_ERROR == error_value) return "VBZ_STREAMVBYTE_STREAM_ERROR";
-    if (VBZ_VERSION_ERROR == error_value) return "VBZ_VERSION_ERROR";
-    if (VBZ_OUT_OF_MEMORY_ERROR == error_value) return "VBZ_OUT_OF_MEMORY_ERROR";
+            return !ZSTD_isError(ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_windowLog, zstd_parameters->window_log))
+                && !ZSTD_isError(ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_strategy, zstd_parameters->strategy))
+                && !ZSTD_isError(ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_enableLongDistanceMatching, zstd_parameters->enable_long_distance_matching != 0))
+                && (worker_count == 0 || !ZSTD_isError(ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_nbWorkers, worker_count)));
+        };
 
-    return "VBZ_UNKNOWN_ERROR";
+        auto const set_parameters = [&]
+        {
+            return !ZSTD_isError(ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_compressionLevel, compression_level))
+                && (!zstd_parameters || set_advanced_parameters())
+                && (!dictionary || !ZSTD_isError(ZSTD_CCtx_refCDict(zstd_context, dictionary)))
+                && (prefix.empty() || !ZSTD_isError(ZSTD_CCtx_refPrefix(zstd_context, prefix.data(), prefix.size())));
+        };
+        if (!set_parameters())
+        {
+            return VBZ_ZSTD_ERROR;
+        }
+
+        compressed_size = ZSTD_compress2(
+            zstd_context,
+            destination.data(),
+            destination.size(),
+            source.data(),
+            source.size()
+        );
+    }
+
+    if (ZSTD_isError(compressed_size))
+    {
+        return VBZ_ZSTD_ERROR;
+    }
+    return vbz_size_t(compressed_size);
 }
 
-vbz_size_t vbz_max_compressed_size(
-    vbz_size_t source_size,
-    CompressionOptions const* options)
+struct VbzSizedHeader
 {
-    if (!is_valid_integer_size(options)) {
-        return VBZ_INTEGER_SIZE_ERROR;
+    vbz_size_t original_size;
+};
+
+/// \brief Decompress the zstd frame in [source], replacing [source] with the decompressed data.
+/// \param destination Buffer to decompress into, or null to decompress into the context's intermediate buffer.
+/// \return The decompressed size in bytes, or an error.
+vbz_size_t decompress_zstd_frame(
+    vbz_context* context,
+    gsl::span<char const>& source,
+    gsl::span<char> const* destination)
+{
+    auto max_zstd_decompressed_size = ZSTD_getFrameContentSize(source.data(), source.size());
+    if (ZSTD_isError(max_zstd_decompressed_size))
+    {
+        return VBZ_ZSTD_ERROR;
     }
 
-    vbz_size_t max_size = source_size;
-    if (options->integer_size != 0)
+    gsl::span<char> zstd_dest;
+    if (!destination)
     {
-        auto size_fn = vbz_max_streamvbyte_compressed_size_v0;
-        if (options->vbz_version == 1)
-        {
-            size_fn = vbz_max_streamvbyte_compressed_size_v1;
-        }
-        else if (options->vbz_version != 0)
-        {
-            return VBZ_VERSION_ERROR;
+#ifdef SANITIZE_FUZZER
+        // Skip big allocations since the fuzzer will easily go over its own RSS limit,
+        // leading to a spurious OoM crash.
+        if (max_zstd_decompressed_size > 10 * 1024 * 1024) {
+            return VBZ_ZSTD_ERROR;
         }
-        
-        max_size = vbz_size_t(size_fn(options->integer_size, max_size));
-        if (vbz_is_error(max_size))
-        {
-            return max_size;
+#endif
+        auto intermediate_storage = context->intermediate.reserve(max_zstd_decompressed_size);
+        if (!intermediate_storage) {
+            return VBZ_OUT_OF_MEMORY_ERROR;
         }
+        zstd_dest = make_data_buffer(intermediate_storage, (vbz_size_t)max_zstd_decompressed_size);
+    }
+    else if (max_zstd_decompressed_size > destination->size())
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+    else
+    {
+        zstd_dest = *destination;
     }
 
-    if (options->zstd_compression_level != 0)
+    auto const prefix = context->take_zstd_prefix();
+    auto zstd_context = context->zstd_decompression_context();
+    if (!zstd_context)
     {
-        max_size = vbz_size_t(ZSTD_compressBound(max_size));
+        return VBZ_OUT_OF_MEMORY_ERROR;
     }
 
-    // Always include sized header for simplicity.
-    return max_size + sizeof(VbzSizedHeader);
+    std::size_t decompressed_size = 0;
+    if (!prefix.empty())
+    {
+        ZSTD_DCtx_reset(zstd_context, ZSTD_reset_session_only);
+        if (ZSTD_isError(ZSTD_DCtx_refPrefix(zstd_context, prefix.data(), prefix.size())))
+        {
+            return VBZ_ZSTD_ERROR;
+        }
+        decompressed_size = ZSTD_decompressDCtx(
+            zstd_context,
+            zstd_dest.data(),
+            zstd_dest.size(),
+            source.data(),
+            source.size()
+        );
+    }
+    else
+    {
+        // A frame compressed without the dictionary never refers to it, so it is safe to always pass.
+        decompressed_size = ZSTD_decompress_usingDDict(
+            zstd_context,
+            zstd_dest.data(),
+            zstd_dest.size(),
+            source.data(),
+            source.size(),
+            context->zstd_decompression_dictionary()
+        );
+    }
+    if (ZSTD_isError(decompressed_size))
+    {
+        return VBZ_ZSTD_ERROR;
+    }
+    source = make_data_buffer(zstd_dest.data(), vbz_size_t(decompressed_size));
+    return vbz_size_t(decompressed_size);
 }
 
-vbz_size_t vbz_compress(
+/// \brief Decompress data stored with #vbz_compress_sized, with [decode] converting the streamvbyte
+///        data as it is decoded into [destination], one OutputType per original integer.
+template <typename OutputType, typename DecodeFn>
+vbz_size_t decompress_sized_converted(
+    vbz_context* context,
     void const* source,
     vbz_size_t source_size,
-    void* destination,
+    OutputType* destination,
     vbz_size_t destination_capacity,
-    CompressionOptions const* options)
+    CompressionOptions const* options,
+    DecodeFn decode)
 {
-    if (!is_valid_integer_size(options)) {
+    // Values can only be converted if the integer type is known.
+    if (!is_valid_integer_size(options) || options->integer_size == 0) {
         return VBZ_INTEGER_SIZE_ERROR;
     }
+    if (options->vbz_version != 0 && options->vbz_version != 1)
+    {
+        return VBZ_VERSION_ERROR;
+    }
 
     auto current_source = make_data_buffer(source, source_size);
-    auto dest_buffer = make_data_buffer(destination, destination_capacity);
+    if (current_source.size() < sizeof(VbzSizedHeader))
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto source_header = current_source.subspan(0, sizeof(VbzSizedHeader)).as_span<VbzSizedHeader const>().begin();
+    if (source_header->original_size % options->integer_size != 0)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto const output_size = std::uint64_t(source_header->original_size / options->integer_size) * sizeof(OutputType);
+    if (destination_capacity < output_size)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    current_source = current_source.subspan(sizeof(VbzSizedHeader));
+    if (options->zstd_compression_level != 0)
+    {
+        auto zstd_result = decompress_zstd_frame(context, current_source, nullptr);
+        if (vbz_is_error(zstd_result))
+        {
+            return zstd_result;
+        }
+    }
+
+    return decode(current_source, destination, vbz_size_t(output_size));
+}
+
+}
+
+vbz_size_t vbz_compress_stages(
+    vbz_context* context,
+    gsl::span<char const> source,
+    gsl::span<char> destination,
+    CompressionOptions const* options,
+    std::int32_t seed,
+    VbzZstdParameters const* zstd_parameters)
+{
+    if (!is_valid_integer_size(options)) {
+        return VBZ_INTEGER_SIZE_ERROR;
+    }
+
+    auto current_source = source;
+    auto dest_buffer = destination;
 
     if (options->zstd_compression_level == 0 && options->integer_size == 0)
     {
         return copy_buffer(current_source, dest_buffer);
     }
 
-    // optional intermediate buffer - allocated if needed later, but stored for
-    // duration of call.
-    std::unique_ptr<void, free_delete> intermediate_storage;
-    
     if (options->integer_size != 0)
     {
         auto size_fn = vbz_max_streamvbyte_compressed_size_v0;
-        auto compress_fn = vbz_delta_zig_zag_streamvbyte_compress_v0;
+        auto compress_fn = vbz_delta_zig_zag_streamvbyte_compress_seeded_v0;
         if (options->vbz_version == 1)
         {
             size_fn = vbz_max_streamvbyte_compressed_size_v1;
-            compress_fn = vbz_delta_zig_zag_streamvbyte_compress_v1;
+            compress_fn = vbz_delta_zig_zag_streamvbyte_compress_seeded_v1;
         }
         else if (options->vbz_version != 0)
         {
@@ -162,13 +331,13 @@ vbz_size_t vbz_compress(
         auto streamvbyte_dest = dest_buffer;
         if (options->zstd_compression_level != 0)
         {
-            intermediate_storage.reset(malloc(max_stream_v_byte_size));
+            auto intermediate_storage = context->intermediate.reserve(max_stream_v_byte_size);
             if (!intermediate_storage) {
                 return VBZ_OUT_OF_MEMORY_ERROR;
             }
-            streamvbyte_dest = make_data_buffer(intermediate_storage.get(), max_stream_v_byte_size);
+            streamvbyte_dest = make_data_buffer(intermediate_storage, max_stream_v_byte_size);
         }
-        else if (max_stream_v_byte_size > destination_capacity)
+        else if (max_stream_v_byte_size > dest_buffer.size())
         {
             return VBZ_DESTINATION_SIZE_ERROR;
         }
@@ -179,8 +348,13 @@ vbz_size_t vbz_compress(
             streamvbyte_dest.data(),
             vbz_size_t(streamvbyte_dest.size()),
             options->integer_size,
-            options->perform_delta_zig_zag
+            options->perform_delta_zig_zag,
+            seed
         );
+        if (vbz_is_error(compressed_size))
+        {
+            return compressed_size;
+        }
 
         current_source = make_data_buffer(streamvbyte_dest.data(), compressed_size);
     }
@@ -191,35 +365,28 @@ vbz_size_t vbz_compress(
         return vbz_size_t(current_source.size());
     }
     
-    auto compressed_size = ZSTD_compress(
-        dest_buffer.data(),
-        vbz_size_t(dest_buffer.size()),
-        current_source.data(),
-        vbz_size_t(current_source.size()),
-        options->zstd_compression_level
+    return compress_zstd_frame(
+        context,
+        current_source,
+        dest_buffer,
+        int(options->zstd_compression_level),
+        zstd_parameters
     );
-    if (ZSTD_isError(compressed_size))
-    {
-        return VBZ_ZSTD_ERROR;
-    }
-
-    
-    return vbz_size_t(compressed_size);
 }
 
-vbz_size_t vbz_decompress(
-    const void* source,
-    vbz_size_t source_size,
-    void* destination,
-    vbz_size_t destination_size,
-    CompressionOptions const* options)
+vbz_size_t vbz_decompress_stages(
+    vbz_context* context,
+    gsl::span<char const> source,
+    gsl::span<char> destination,
+    CompressionOptions const* options,
+    std::int32_t seed)
 {
     if (!is_valid_integer_size(options)) {
         return VBZ_INTEGER_SIZE_ERROR;
     }
 
-    auto current_source = make_data_buffer(source, source_size);
-    auto dest_buffer = make_data_buffer(destination, destination_size);
+    auto current_source = source;
+    auto dest_buffer = destination;
 
     // If nothing is enabled, just do a copy between buffers and return.
     if (options->zstd_compression_level == 0 && options->integer_size == 0)
@@ -227,50 +394,18 @@ vbz_size_t vbz_decompress(
         return copy_buffer(current_source, dest_buffer);
     }
 
-    // optional intermediate buffer - allocated if needed later, but stored for
-    // duration of call.
-    std::unique_ptr<void, free_delete> intermediate_storage;
-    
     if (options->zstd_compression_level != 0)
     {
-        auto max_zstd_decompressed_size = ZSTD_getFrameContentSize(source, source_size);
-        if (ZSTD_isError(max_zstd_decompressed_size))
-        {
-            return VBZ_ZSTD_ERROR;
-        }
-
-        auto zstd_dest = dest_buffer;
-        if (options->integer_size != 0)
-        {
-#ifdef SANITIZE_FUZZER
-            // Skip big allocations since the fuzzer will easily go over its own RSS limit,
-            // leading to a spurious OoM crash.
-            if (max_zstd_decompressed_size > 10 * 1024 * 1024) {
-                return VBZ_ZSTD_ERROR;
-            }
-#endif
-            intermediate_storage.reset(malloc(max_zstd_decompressed_size));
-            if (!intermediate_storage) {
-                return VBZ_OUT_OF_MEMORY_ERROR;
-            }
-            zstd_dest = make_data_buffer(intermediate_storage.get(), (vbz_size_t)max_zstd_decompressed_size);
-        }
-        else if (max_zstd_decompressed_size > destination_size)
-        {
-            return VBZ_DESTINATION_SIZE_ERROR;
-        }
-
-        auto compressed_size = ZSTD_decompress(
-            zstd_dest.data(),
-            zstd_dest.size(),
-            current_source.data(),
-            current_source.size()
+        // Streamvbyte data is decoded from the intermediate buffer into the destination.
+        auto zstd_result = decompress_zstd_frame(
+            context,
+            current_source,
+            options->integer_size != 0 ? nullptr : &dest_buffer
         );
-        if (ZSTD_isError(compressed_size))
+        if (vbz_is_error(zstd_result))
         {
-            return VBZ_ZSTD_ERROR;
+            return zstd_result;
         }
-        current_source = make_data_buffer(zstd_dest.data(), vbz_size_t(compressed_size));
     }
 
     // if streamvbyte is disabled, return early.
@@ -279,10 +414,10 @@ vbz_size_t vbz_decompress(
         return vbz_size_t(current_source.size());
     }
 
-    auto decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_v0;
+    auto decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_seeded_v0;
     if (options->vbz_version == 1)
     {
-        decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_v1;
+        decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_seeded_v1;
     }
     else if (options->vbz_version != 0)
     {
@@ -295,7 +430,146 @@ vbz_size_t vbz_decompress(
         dest_buffer.data(),
         vbz_size_t(dest_buffer.size()),
         options->integer_size,
-        options->perform_delta_zig_zag
+        options->perform_delta_zig_zag,
+        seed
+    );
+}
+
+extern "C" {
+
+bool vbz_is_error(vbz_size_t result_value)
+{
+    return result_value >= VBZ_FIRST_ERROR;
+}
+
+char const* vbz_error_string(vbz_size_t error_value)
+{
+    if (VBZ_ZSTD_ERROR == error_value) return "VBZ_ZSTD_ERROR";
+    if (VBZ_INPUT_SIZE_ERROR == error_value) return "VBZ_INPUT_SIZE_ERROR";
+    if (VBZ_INTEGER_SIZE_ERROR == error_value) return "VBZ_INTEGER_SIZE_ERROR";
+    if (VBZ_DESTINATION_SIZE_ERROR == error_value) return "VBZ_DESTINATION_SIZE_ERROR";
+    if (VBZ_STREAMVBYTE_STREAM_ERROR == error_value) return "VBZ_STREAMVBYTE_STREAM_ERROR";
+    if (VBZ_VERSION_ERROR == error_value) return "VBZ_VERSION_ERROR";
+    if (VBZ_OUT_OF_MEMORY_ERROR == error_value) return "VBZ_OUT_OF_MEMORY_ERROR";
+    if (VBZ_FRAME_HEADER_ERROR == error_value) return "VBZ_FRAME_HEADER_ERROR";
+
+    return "VBZ_UNKNOWN_ERROR";
+}
+
+vbz_context* vbz_create_context(void)
+{
+    return new (std::nothrow) vbz_context();
+}
+
+void vbz_free_context(vbz_context* context)
+{
+    delete context;
+}
+
+vbz_size_t vbz_max_compressed_size(
+    vbz_size_t source_size,
+    CompressionOptions const* options)
+{
+    if (!is_valid_integer_size(options)) {
+        return VBZ_INTEGER_SIZE_ERROR;
+    }
+
+    vbz_size_t max_size = source_size;
+    if (options->integer_size != 0)
+    {
+        auto size_fn = vbz_max_streamvbyte_compressed_size_v0;
+        if (options->vbz_version == 1)
+        {
+            size_fn = vbz_max_streamvbyte_compressed_size_v1;
+        }
+        else if (options->vbz_version != 0)
+        {
+            return VBZ_VERSION_ERROR;
+        }
+        
+        max_size = vbz_size_t(size_fn(options->integer_size, max_size));
+        if (vbz_is_error(max_size))
+        {
+            return max_size;
+        }
+    }
+
+    if (options->zstd_compression_level != 0)
+    {
+        max_size = vbz_size_t(ZSTD_compressBound(max_size));
+    }
+
+    // Always include sized header for simplicity.
+    return max_size + sizeof(VbzSizedHeader);
+}
+
+vbz_size_t vbz_compress(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_compress_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_compress_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    return vbz_compress_stages(
+        context,
+        make_data_buffer(source, source_size),
+        make_data_buffer(destination, destination_capacity),
+        options,
+        0
+    );
+}
+
+vbz_size_t vbz_decompress(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_size,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_decompress_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_size,
+        options
+    );
+}
+
+vbz_size_t vbz_decompress_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_size,
+    CompressionOptions const* options)
+{
+    return vbz_decompress_stages(
+        context,
+        make_data_buffer(source, source_size),
+        make_data_buffer(destination, destination_size),
+        options,
+        0
     );
 }
 
@@ -305,12 +579,80 @@ vbz_size_t vbz_compress_sized(
     void* destination,
     vbz_size_t destination_capacity,
     CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_compress_sized_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_compress_sized_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    return vbz_compress_sized_advanced_ctx(
+        context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        nullptr
+    );
+}
+
+vbz_size_t vbz_compress_sized_advanced(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzZstdParameters const* zstd_parameters)
+{
+    vbz_context context;
+    return vbz_compress_sized_advanced_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        zstd_parameters
+    );
+}
+
+vbz_size_t vbz_compress_sized_advanced_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzZstdParameters const* zstd_parameters)
 {
     if (!is_valid_integer_size(options)) {
         return VBZ_INTEGER_SIZE_ERROR;
     }
 
+    // Reserved to mark 64 bit sized frames (see vbz_sized64.h).
+    if (source_size == VBZ_SIZED64_MARKER) {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
     auto dest_buffer = make_data_buffer(destination, destination_capacity);
+    if (dest_buffer.size() < sizeof(VbzSizedHeader))
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
 
     // Extract header information
     auto header_span = dest_buffer.subspan(0, sizeof(VbzSizedHeader)).as_span<VbzSizedHeader>();
@@ -318,13 +660,18 @@ vbz_size_t vbz_compress_sized(
 
     // Compress data info remaining dest buffer
     auto dest_compressed_data = dest_buffer.subspan(sizeof(VbzSizedHeader));
-    auto compressed_size = vbz_compress(
-        source,
-        source_size,
-        dest_compressed_data.data(),
-        vbz_size_t(dest_compressed_data.size()),
-        options
+    auto compressed_size = vbz_compress_stages(
+        context,
+        make_data_buffer(source, source_size),
+        dest_compressed_data,
+        options,
+        0,
+        zstd_parameters
     );
+    if (vbz_is_error(compressed_size))
+    {
+        return compressed_size;
+    }
     
     return compressed_size + sizeof(VbzSizedHeader);
 }
@@ -335,6 +682,25 @@ vbz_size_t vbz_decompress_sized(
     void* destination,
     vbz_size_t destination_capacity,
     CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_decompress_sized_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_decompress_sized_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
 {
     if (!is_valid_integer_size(options)) {
         return VBZ_INTEGER_SIZE_ERROR;
@@ -357,7 +723,8 @@ vbz_size_t vbz_decompress_sized(
 
     // Compress data info remaining dest buffer
     auto src_compressed_data = source_buffer.subspan(sizeof(VbzSizedHeader));
-    return vbz_decompress(
+    return vbz_decompress_ctx(
+        context,
         src_compressed_data.data(),
         vbz_size_t(src_compressed_data.size()),
         destination,
@@ -366,6 +733,119 @@ vbz_size_t vbz_decompress_sized(
     );
 }
 
+vbz_size_t vbz_decompress_sized_calibrated(
+    void const* source,
+    vbz_size_t source_size,
+    float* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzCalibration const* calibration)
+{
+    vbz_context context;
+    return vbz_decompress_sized_calibrated_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        calibration
+    );
+}
+
+vbz_size_t vbz_decompress_sized_calibrated_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    float* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzCalibration const* calibration)
+{
+    auto decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_float_v0;
+    if (options->vbz_version == 1)
+    {
+        decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_float_v1;
+    }
+
+    auto const offset = calibration->offset;
+    auto const scale = calibration->range / calibration->digitisation;
+    return decompress_sized_converted(
+        context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        [&](gsl::span<char const> stream, float* output, vbz_size_t output_size)
+        {
+            return decompress_fn(
+                stream.data(),
+                vbz_size_t(stream.size()),
+                output,
+                output_size,
+                options->integer_size,
+                options->perform_delta_zig_zag,
+                offset,
+                scale
+            );
+        }
+    );
+}
+
+vbz_size_t vbz_decompress_sized_int32(
+    void const* source,
+    vbz_size_t source_size,
+    int32_t* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_decompress_sized_int32_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_decompress_sized_int32_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    int32_t* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    auto decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_int32_v0;
+    if (options->vbz_version == 1)
+    {
+        decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_int32_v1;
+    }
+
+    return decompress_sized_converted(
+        context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        [&](gsl::span<char const> stream, int32_t* output, vbz_size_t output_size)
+        {
+            return decompress_fn(
+                stream.data(),
+                vbz_size_t(stream.size()),
+                output,
+                output_size,
+                options->integer_size,
+                options->perform_delta_zig_zag
+            );
+        }
+    );
+}
+
 vbz_size_t vbz_decompressed_size(
     void const* source,
     vbz_size_t source_size,
@@ -10,8 +10,21 @@ extern "C" {
 
 #define VBZ_DEFAULT_VERSION 0
 
+// Size of the header #vbz_compress_described writes before the compressed data.
+#define VBZ_DESCRIBED_HEADER_SIZE 16
+
+// Data this size or smaller is stored raw by #vbz_compress_adaptive.
+#define VBZ_ADAPTIVE_RAW_SIZE 64
+
+// Number of integers in each block of a blocked frame, see #vbz_compress_blocked.
+#define VBZ_DEFAULT_BLOCK_SIZE (256 * 1024)
+
 typedef uint32_t vbz_size_t;
 
+// Size type for the *64 functions, which can process data larger than 4 GiB.
+// Errors are the vbz_size_t error values, sign extended, so vbz_size_t(error) is the 32 bit error.
+typedef uint64_t vbz_size64_t;
+
 #define VBZ_ZSTD_ERROR ((vbz_size_t)-1)
 #define VBZ_INPUT_SIZE_ERROR ((vbz_size_t)-2)
 #define VBZ_INTEGER_SIZE_ERROR ((vbz_size_t)-3)
@@ -19,7 +32,8 @@ typedef uint32_t vbz_size_t;
 #define VBZ_STREAMVBYTE_STREAM_ERROR ((vbz_size_t)-5)
 #define VBZ_VERSION_ERROR ((vbz_size_t)-6)
 #define VBZ_OUT_OF_MEMORY_ERROR ((vbz_size_t)-7)
-#define VBZ_FIRST_ERROR VBZ_OUT_OF_MEMORY_ERROR
+#define VBZ_FRAME_HEADER_ERROR ((vbz_size_t)-8)
+#define VBZ_FIRST_ERROR VBZ_FRAME_HEADER_ERROR
 
 // Deprecated aliases.
 #define VBZ_STREAMVBYTE_INPUT_SIZE_ERROR VBZ_INPUT_SIZE_ERROR
@@ -43,6 +57,8 @@ struct CompressionOptions
     // Should be in the range "ZSTD_minCLevel" to "ZSTD_maxCLevel".
     // 1 gives the best performance and still provides a sensible compression
     // higher numbers use more CPU time for higher compression ratios.
+    // The level is passed to zstd as an int, so zstd's negative "fast" levels
+    // can be selected by casting them, eg. (unsigned int)-5.
     // Passing 0 will cause zstd to not be applied to data.
     unsigned int zstd_compression_level;
 
@@ -52,6 +68,60 @@ struct CompressionOptions
     unsigned int vbz_version;
 };
 
+/// \brief Advanced zstd settings, see #vbz_compress_sized_advanced.
+///
+/// Each field maps onto a ZSTD_CCtx_setParameter parameter. Fields left at 0 keep the default chosen
+/// by the compression level. None of them are needed to decompress the data.
+struct VbzZstdParameters
+{
+    // Log2 of the largest distance back a match can refer to (ZSTD_c_windowLog).
+    // Windows larger than 2^27 can not be decompressed by #vbz_dstream.
+    int window_log;
+    // zstd strategy, from 1 (ZSTD_fast) to 9 (ZSTD_btultra2) (ZSTD_c_strategy).
+    int strategy;
+    // Non-zero to find long matches across the whole window (ZSTD_c_enableLongDistanceMatching).
+    int enable_long_distance_matching;
+    // Number of threads zstd compresses with (ZSTD_c_nbWorkers). Limited to the number zstd was
+    // built to support, so a zstd built without threads compresses on the calling thread.
+    int worker_count;
+};
+
+/// \brief Calibration converting raw signal values to picoamps, as (raw + offset) * range / digitisation.
+struct VbzCalibration
+{
+    float offset;
+    float range;
+    float digitisation;
+};
+
+/// \brief Details of a frame written by #vbz_compress_described, see #vbz_frame_info.
+struct VbzFrameInfo
+{
+    // The options the frame was compressed with.
+    CompressionOptions options;
+    // Size of the data before compression, in bytes.
+    vbz_size_t original_size;
+};
+
+/// \brief Opaque state which can be reused between calls to avoid repeated setup costs.
+///
+/// A context caches zstd compression/decompression state and grow-only intermediate buffers.
+/// Once buffers have grown to fit the data being processed, calls using a context make no allocations.
+/// \note A context must not be used by more than one thread at a time.
+typedef struct vbz_context vbz_context;
+
+/// \brief Opaque state for compressing a frame from samples pushed a few at a time, see #vbz_cstream_begin.
+///
+/// Samples are held streamvbyte encoded between pushes, so a stream holds less than the raw samples would.
+/// \note A stream must not be used by more than one thread at a time.
+typedef struct vbz_cstream vbz_cstream;
+
+/// \brief Opaque state for decompressing a frame into samples a window at a time, see #vbz_dstream_begin.
+///
+/// Only a small tile of the frame is decoded at once, so memory use does not grow with the frame size.
+/// \note A stream must not be used by more than one thread at a time.
+typedef struct vbz_dstream vbz_dstream;
+
 /// \brief Find if a return value from a function is an error value.
 VBZ_EXPORT bool vbz_is_error(vbz_size_t result_value);
 
@@ -113,6 +183,19 @@ VBZ_EXPORT vbz_size_t vbz_compress_sized(
     vbz_size_t destination_capacity,
     CompressionOptions const* options);
 
+/// \brief Compress data as #vbz_compress_sized, applying advanced zstd settings.
+/// \note The output can be decompressed with #vbz_decompress_sized, like any other sized data.
+/// \param zstd_parameters      zstd settings to apply on top of options->zstd_compression_level,
+///                             which must be non-zero for zstd to be applied.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_compress_sized_advanced(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzZstdParameters const* zstd_parameters);
+
 /// \brief Decompress data into a provided output buffer, using size information stored with the compressed data.
 /// \note Must decompress data stored with #vbz_compress_sized.
 /// \param source               Source compressed data for decompression.
@@ -129,6 +212,41 @@ VBZ_EXPORT vbz_size_t vbz_decompress_sized(
     vbz_size_t destination_capacity,
     CompressionOptions const* options);
 
+/// \brief Decompress data stored with #vbz_compress_sized, converting each value to float32 picoamps as it is decoded.
+///
+/// Equivalent to #vbz_decompress_sized followed by computing (raw + offset) * range / digitisation for every
+/// value, without writing the integer values to memory. range / digitisation is computed once, in float, so
+/// results may differ from evaluating the expression left to right in the last bit.
+/// \note Must decompress data stored with #vbz_compress_sized, with streamvbyte enabled (integer_size != 0).
+/// \param source               Source compressed data for decompression.
+/// \param source_size          Compressed Source data size (in bytes)
+/// \param destination          Destination buffer for calibrated output.
+/// \param destination_capacity Capacity of the destination buffer in bytes, should be at least
+///                             (#vbz_decompressed_size / integer_size) * sizeof(float) bytes.
+/// \param options              Options controlling decompression to
+///                             apply (must be the same as the arguments passed to #vbz_compress_sized).
+/// \param calibration          Calibration to apply to each value.
+/// \return The size of the calibrated output in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_calibrated(
+    void const* source,
+    vbz_size_t source_size,
+    float* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzCalibration const* calibration);
+
+/// \brief Decompress data stored with #vbz_compress_sized, widening each value to int32 as it is decoded.
+/// \note Must decompress data stored with #vbz_compress_sized, with streamvbyte enabled (integer_size != 0).
+/// \param destination_capacity Capacity of the destination buffer in bytes, should be at least
+///                             (#vbz_decompressed_size / integer_size) * sizeof(int32_t) bytes.
+/// \return The size of the int32 output in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_int32(
+    void const* source,
+    vbz_size_t source_size,
+    int32_t* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
 /// \brief Find the size for a decompressed block.
 ///        should be used to find the size of the destination buffer to allocate for decompression.
 /// \note This is only valid for use with data from #vbz_compress_sized.
@@ -140,6 +258,561 @@ VBZ_EXPORT vbz_size_t vbz_decompressed_size(
     vbz_size_t source_size,
     CompressionOptions const* options);
 
+/// \brief Compress data into a provided output buffer, storing the options used and the original size with it.
+///
+/// The data is written as #vbz_compress_sized would write it, after a VBZ_DESCRIBED_HEADER_SIZE byte header
+/// holding a magic number, a format version and [options]. The frame can be decompressed without knowing
+/// the options, see #vbz_decompress_auto.
+/// \param source               Source data for compression.
+/// \param source_size          Source data size (in bytes)
+/// \param destination          Destination buffer for compressed output.
+/// \param destination_capacity Size of the destination buffer to write to, should be at least
+///                             #vbz_max_compressed_size + VBZ_DESCRIBED_HEADER_SIZE bytes.
+/// \param options              Options controlling compression to apply.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_compress_described(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Compress data as #vbz_compress_described, skipping stages which do not pay for themselves.
+///
+/// Each stage is skipped, and recorded as skipped in the header, when it would not shrink the data:
+/// - data of VBZ_ADAPTIVE_RAW_SIZE bytes or less is stored raw.
+/// - one integer repeated is stored as that integer, and decompresses to a fill.
+/// - streamvbyte is skipped if its output is not smaller than its input.
+/// - zstd is skipped if a sample of its input looks too noisy to compress, or if it does not shrink it.
+/// Decompressing skipped stages costs nothing, so a frame of raw data decompresses as a copy.
+/// \note The frame must be decompressed with #vbz_decompress_auto.
+/// \param destination_capacity Size of the destination buffer to write to, should be at least
+///                             #vbz_max_compressed_size + VBZ_DESCRIBED_HEADER_SIZE bytes.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_compress_adaptive(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Read the header of a frame written by #vbz_compress_described, without decompressing any data.
+/// \param source               Source compressed data.
+/// \param source_size          Compressed Source data size (in bytes), must be at least VBZ_DESCRIBED_HEADER_SIZE.
+/// \param info                 Set to the frame's options and original size.
+/// \return 0, or VBZ_FRAME_HEADER_ERROR if [source] is not a described frame, or another error code if its
+///         header is not valid.
+VBZ_EXPORT vbz_size_t vbz_frame_info(
+    void const* source,
+    vbz_size_t source_size,
+    VbzFrameInfo* info);
+
+/// \brief Decompress a frame written by #vbz_compress_described, using the options stored in it.
+/// \param source               Source compressed data for decompression.
+/// \param source_size          Compressed Source data size (in bytes)
+/// \param destination          Destination buffer for decompressed output.
+/// \param destination_capacity Capacity of the destination buffer, should be at least the original_size
+///                             found by #vbz_frame_info.
+/// \return The size of the decompressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_decompress_auto(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity);
+
+/// \brief Create a context for use with the *_ctx functions.
+/// \return The new context, or null if it could not be allocated. Must be released with #vbz_free_context.
+VBZ_EXPORT vbz_context* vbz_create_context(void);
+
+/// \brief Release a context created with #vbz_create_context.
+VBZ_EXPORT void vbz_free_context(vbz_context* context);
+
+/// \brief As #vbz_compress, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_compress_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_decompress, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_size,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_compress_sized, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_compress_sized_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_compress_sized_advanced, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_compress_sized_advanced_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzZstdParameters const* zstd_parameters);
+
+/// \brief As #vbz_decompress_sized, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_compress_described, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_compress_described_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_compress_adaptive, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_compress_adaptive_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_decompress_auto, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_auto_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity);
+
+/// \brief As #vbz_decompress_sized_calibrated, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_calibrated_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    float* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    VbzCalibration const* calibration);
+
+/// \brief As #vbz_decompress_sized_int32, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_int32_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    int32_t* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Train a zstd dictionary from a sample of reads, to improve compression of short reads.
+///
+/// Each read is encoded with the streamvbyte stage of [options], as zstd sees it during compression,
+/// then passed to ZDICT_trainFromBuffer. Use the dictionary with #vbz_context_set_dictionary.
+/// \param samples              Source data for each sample read.
+/// \param sample_sizes         Size of each sample read's source data (in bytes).
+/// \param sample_count         Number of sample reads. zstd needs at least a few hundred to train well.
+/// \param dictionary           Destination buffer for the dictionary.
+/// \param dictionary_capacity  Size of the dictionary buffer, which limits the size of the dictionary.
+///                             zstd suggests around 100KB.
+/// \param options              Options data will be compressed with.
+/// \return The size of the dictionary in bytes, or an error code if it could not be trained.
+VBZ_EXPORT vbz_size_t vbz_train_dictionary(
+    void const* const* samples,
+    vbz_size_t const* sample_sizes,
+    vbz_size_t sample_count,
+    void* dictionary,
+    vbz_size_t dictionary_capacity,
+    CompressionOptions const* options);
+
+/// \brief Find the id of a dictionary trained by #vbz_train_dictionary.
+/// \return The id, or 0 if [dictionary] is not a zstd dictionary.
+VBZ_EXPORT vbz_size_t vbz_dictionary_id(
+    void const* dictionary,
+    vbz_size_t dictionary_size);
+
+/// \brief Use a dictionary for all zstd compression and decompression with [context].
+///
+/// The dictionary is copied, and digested for each compression level it is used with. Its id is recorded
+/// in every zstd frame compressed with it, see #vbz_frame_dictionary_id, and those frames can only be
+/// decompressed by a context using the same dictionary. Frames compressed without a dictionary can still
+/// be decompressed.
+/// \param dictionary           Dictionary to use, or null to stop using a dictionary.
+/// \param dictionary_size      Size of the dictionary (in bytes), or 0 to stop using a dictionary.
+/// \return 0, or an error code if the dictionary could not be loaded.
+VBZ_EXPORT vbz_size_t vbz_context_set_dictionary(
+    vbz_context* context,
+    void const* dictionary,
+    vbz_size_t dictionary_size);
+
+/// \brief Find the id of the dictionary data stored with #vbz_compress_sized was compressed with.
+/// \return The id, or 0 if no dictionary was used, or an error code if [source] is too small.
+VBZ_EXPORT vbz_size_t vbz_frame_dictionary_id(
+    void const* source,
+    vbz_size_t source_size,
+    CompressionOptions const* options);
+
+/// \brief Compress data as #vbz_compress_sized, letting zstd refer back to a reference read.
+///
+/// Consecutive reads from one channel share much of their structure, which zstd can only use if it sees
+/// both. The reference, typically the channel's previous read, is streamvbyte encoded with [options] and
+/// used as a zstd prefix. The data can then only be decompressed with #vbz_decompress_sized_prefix, given
+/// the same reference, so every read in a chain depends on the one before it.
+/// \note A prefix replaces any dictionary set on the context, and is ignored if zstd is disabled.
+/// \param reference            Original data of the reference read, or null for no reference.
+/// \param reference_size       Size of the reference read (in bytes), or 0 for no reference.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_compress_sized_prefix(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size);
+
+/// \brief As #vbz_compress_sized_prefix, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_compress_sized_prefix_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size);
+
+/// \brief Decompress data stored with #vbz_compress_sized_prefix.
+/// \param reference            Original data of the reference read the data was compressed with.
+/// \param reference_size       Size of the reference read (in bytes).
+/// \return The size of the decompressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_prefix(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size);
+
+/// \brief As #vbz_decompress_sized_prefix, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_sized_prefix_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size);
+
+/// \brief Find a theoretical max size for the output of #vbz_compress_blocked.
+/// \param source_size      The size of the source buffer for compression in bytes.
+/// \param options          The options which will be used to compress data.
+/// \param block_size       The number of integers in each block, or 0 for VBZ_DEFAULT_BLOCK_SIZE.
+VBZ_EXPORT vbz_size_t vbz_max_compressed_size_blocked(
+    vbz_size_t source_size,
+    CompressionOptions const* options,
+    vbz_size_t block_size);
+
+/// \brief Compress data as a blocked frame, compressing blocks of the input in parallel.
+///
+/// The input is split into blocks of [block_size] integers, which are compressed independently, with
+/// zig zag deltas continuing from the last integer of the previous block. The frame stores the original
+/// size first, so #vbz_decompressed_size also works on blocked frames. The output does not depend on
+/// [thread_count]. Ranges of samples can be read without decompressing the whole frame, see #vbz_decompress_range.
+/// \note Must decompress data with #vbz_decompress_blocked.
+/// \param source               Source data for compression.
+/// \param source_size          Source data size (in bytes)
+/// \param destination          Destination buffer for compressed output.
+/// \param destination_capacity Size of the destination buffer to write to, must be at least
+///                             #vbz_max_compressed_size_blocked bytes, as blocks are compressed in place.
+/// \param options              Options controlling compression to apply.
+/// \param block_size           The number of integers in each block, or 0 for VBZ_DEFAULT_BLOCK_SIZE.
+/// \param thread_count         The maximum number of threads to use, or 0 for one per hardware thread.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_compress_blocked(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    vbz_size_t block_size,
+    unsigned int thread_count);
+
+/// \brief Decompress a frame from #vbz_compress_blocked, decompressing blocks in parallel.
+/// \param source               Source compressed data for decompression.
+/// \param source_size          Compressed Source data size (in bytes)
+/// \param destination          Destination buffer for decompressed output.
+/// \param destination_capacity Capacity of the destination buffer, should be at least #vbz_decompressed_size bytes.
+/// \param options              Options controlling decompression to
+///                             apply (must be the same as the arguments passed to #vbz_compress_blocked).
+/// \param thread_count         The maximum number of threads to use, or 0 for one per hardware thread.
+/// \return The size of the decompressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_decompress_blocked(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    unsigned int thread_count);
+
+/// \brief Decompress [sample_count] integers, starting at [first_sample], from a frame compressed with #vbz_compress_blocked.
+///
+/// Only the blocks holding the requested integers are decompressed, so small ranges of long frames are
+/// cheap to read.
+/// \param source               Source compressed data for decompression.
+/// \param source_size          Compressed Source data size (in bytes)
+/// \param first_sample         Index of the first integer to decompress (in bytes if integer_size is 0).
+/// \param sample_count         Number of integers to decompress (in bytes if integer_size is 0).
+/// \param destination          Destination buffer for decompressed output.
+/// \param destination_capacity Capacity of the destination buffer in bytes, should be at least
+///                             sample_count * integer_size bytes.
+/// \param options              Options controlling decompression to
+///                             apply (must be the same as the arguments passed to #vbz_compress_blocked).
+/// \return The size of the decompressed range in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_decompress_range(
+    void const* source,
+    vbz_size_t source_size,
+    vbz_size_t first_sample,
+    vbz_size_t sample_count,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_decompress_range, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size_t vbz_decompress_range_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    vbz_size_t first_sample,
+    vbz_size_t sample_count,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Find if a return value from a *64 function is an error value.
+VBZ_EXPORT bool vbz_is_error64(vbz_size64_t result_value);
+
+/// \brief Find a theoretical max size for the output of #vbz_compress64.
+/// \param source_size      The size of the source buffer for compression in bytes.
+/// \param options          The options which will be used to compress data.
+VBZ_EXPORT vbz_size64_t vbz_max_compressed_size64(
+    vbz_size64_t source_size,
+    CompressionOptions const* options);
+
+/// \brief Compress data of any size into a provided output buffer, with the original size information stored.
+///
+/// Data which fits in a #vbz_compress_sized frame is stored as one, so it can be read by #vbz_decompress_sized.
+/// Larger data is stored in a 64 bit sized frame, as a sequence of pieces each compressed as #vbz_compress
+/// would, directly from [source].
+/// \note Must decompress data with #vbz_decompress64.
+/// \param source               Source data for compression.
+/// \param source_size          Source data size (in bytes)
+/// \param destination          Destination buffer for compressed output.
+/// \param destination_capacity Size of the destination buffer to write to (see #vbz_max_compressed_size64)
+/// \param options              Options controlling compression to apply.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size64_t vbz_compress64(
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Decompress data stored with #vbz_compress64 or #vbz_compress_sized into a provided output buffer.
+/// \param source               Source compressed data for decompression.
+/// \param source_size          Compressed Source data size (in bytes)
+/// \param destination          Destination buffer for decompressed output.
+/// \param destination_capacity Capacity of the destination buffer, should be at least #vbz_decompressed_size64 bytes.
+/// \param options              Options controlling decompression to
+///                             apply (must be the same as the arguments passed to #vbz_compress64).
+/// \return The size of the decompressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size64_t vbz_decompress64(
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Find the size of data stored with #vbz_compress64 or #vbz_compress_sized once decompressed.
+/// \param source           Source compressed data for decompression.
+/// \param source_size      The size of the compressed source buffer in bytes.
+/// \param options          The options which will be used to decompress data.
+VBZ_EXPORT vbz_size64_t vbz_decompressed_size64(
+    void const* source,
+    vbz_size64_t source_size,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_compress64, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size64_t vbz_compress64_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief As #vbz_decompress64, reusing zstd state and buffers from [context].
+VBZ_EXPORT vbz_size64_t vbz_decompress64_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options);
+
+/// \brief Find a theoretical max size for the output of #vbz_compress_batch.
+/// \param source_sizes     The size of each source buffer in bytes.
+/// \param item_count       The number of source buffers.
+/// \param options          The options which will be used to compress data.
+VBZ_EXPORT vbz_size64_t vbz_max_compressed_size_batch(
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    CompressionOptions const* options);
+
+/// \brief Compress a batch of items, such as the reads of a file, each as #vbz_compress_sized would.
+///
+/// Items are shared out between threads largest first, each thread reusing one context for all the
+/// items it compresses. The compressed items are written one after another into [destination], in
+/// the order given. The output does not depend on [thread_count].
+/// \param sources              Source data for each item.
+/// \param source_sizes         Size of each item's source data (in bytes).
+/// \param item_count           Number of items to compress.
+/// \param destination          Destination buffer for compressed output.
+/// \param destination_capacity Size of the destination buffer to write to, must be at least
+///                             #vbz_max_compressed_size_batch bytes, as items are compressed in place.
+/// \param destination_offsets  Array of [item_count] + 1 entries, set to the offset of each compressed item
+///                             in [destination], followed by the total size.
+/// \param options              Options controlling compression to apply.
+/// \param thread_count         The maximum number of threads to use, or 0 for one per hardware thread.
+/// \return The total size of the compressed items in bytes, or an error code if any item failed.
+VBZ_EXPORT vbz_size64_t vbz_compress_batch(
+    void const* const* sources,
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    vbz_size64_t* destination_offsets,
+    CompressionOptions const* options,
+    unsigned int thread_count);
+
+/// \brief Find the total size of a batch of items compressed by #vbz_compress_sized, once decompressed.
+VBZ_EXPORT vbz_size64_t vbz_decompressed_size_batch(
+    void const* const* sources,
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    CompressionOptions const* options);
+
+/// \brief Decompress a batch of items compressed by #vbz_compress_sized or #vbz_compress_batch.
+///
+/// The decompressed items are written one after another into [destination], in the order given.
+/// \param sources              Compressed data for each item.
+/// \param source_sizes         Size of each item's compressed data (in bytes).
+/// \param item_count           Number of items to decompress.
+/// \param destination          Destination buffer for decompressed output.
+/// \param destination_capacity Size of the destination buffer, should be at least #vbz_decompressed_size_batch bytes.
+/// \param destination_offsets  Array of [item_count] + 1 entries, set to the offset of each decompressed item
+///                             in [destination], followed by the total size.
+/// \param options              Options controlling decompression to
+///                             apply (must be the same as the arguments passed to #vbz_compress_batch).
+/// \param thread_count         The maximum number of threads to use, or 0 for one per hardware thread.
+/// \return The total size of the decompressed items in bytes, or an error code if any item failed.
+VBZ_EXPORT vbz_size64_t vbz_decompress_batch(
+    void const* const* sources,
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    vbz_size64_t* destination_offsets,
+    CompressionOptions const* options,
+    unsigned int thread_count);
+
+/// \brief Create a stream for use with the vbz_cstream_* functions.
+/// \return The new stream, or null if it could not be allocated. Must be released with #vbz_free_cstream.
+VBZ_EXPORT vbz_cstream* vbz_create_cstream(void);
+
+/// \brief Release a stream created with #vbz_create_cstream.
+VBZ_EXPORT void vbz_free_cstream(vbz_cstream* stream);
+
+/// \brief Start compressing a new frame with [stream], discarding any frame in progress.
+/// \param options              Options controlling compression to apply.
+/// \return 0, or an error code if the options are not valid.
+VBZ_EXPORT vbz_size_t vbz_cstream_begin(
+    vbz_cstream* stream,
+    CompressionOptions const* options);
+
+/// \brief Add samples to the end of the frame being compressed.
+/// \param samples              Samples to add, each integer_size bytes (or bytes if integer_size is 0).
+/// \param sample_count         Number of samples to add.
+/// \return [sample_count], or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_cstream_push_samples(
+    vbz_cstream* stream,
+    void const* samples,
+    vbz_size_t sample_count);
+
+/// \brief Find a theoretical max size for the output of #vbz_cstream_end, given the samples pushed so far.
+VBZ_EXPORT vbz_size_t vbz_cstream_max_compressed_size(vbz_cstream const* stream);
+
+/// \brief Finish the frame being compressed, writing it to a provided output buffer.
+///
+/// The frame is written as #vbz_compress_sized would write it, so must be decompressed with #vbz_decompress_sized.
+/// Once a frame ends, #vbz_cstream_begin must be called to start another. Buffers are kept for the next frame.
+/// \param context              Context to reuse zstd state from, or null to use a temporary context.
+/// \param destination          Destination buffer for compressed output.
+/// \param destination_capacity Size of the destination buffer to write to (see #vbz_cstream_max_compressed_size).
+///                             If it is too small, the frame is left in progress so can be ended again.
+/// \return The size of the compressed object in bytes, or an error code if something went wrong.
+VBZ_EXPORT vbz_size_t vbz_cstream_end(
+    vbz_cstream* stream,
+    vbz_context* context,
+    void* destination,
+    vbz_size_t destination_capacity);
+
+/// \brief Create a stream for use with the vbz_dstream_* functions.
+/// \return The new stream, or null if it could not be allocated. Must be released with #vbz_free_dstream.
+VBZ_EXPORT vbz_dstream* vbz_create_dstream(void);
+
+/// \brief Release a stream created with #vbz_create_dstream.
+VBZ_EXPORT void vbz_free_dstream(vbz_dstream* stream);
+
+/// \brief Start decompressing a frame written by #vbz_compress_sized, discarding any frame in progress.
+///
+/// The keys and data sections of a zstd compressed frame are each decoded by their own zstd stream,
+/// so memory use is two zstd windows (set by the compression level) plus under 256KB of buffers.
+/// \param source               Frame to decompress, which must stay valid until it is fully read or restarted.
+/// \param source_size          Size of the frame in bytes.
+/// \param options              Options the frame was compressed with.
+/// \return The number of samples in the frame, or an error code if it could not be started.
+VBZ_EXPORT vbz_size_t vbz_dstream_begin(
+    vbz_dstream* stream,
+    void const* source,
+    vbz_size_t source_size,
+    CompressionOptions const* options);
+
+/// \brief Decompress the next samples of the frame into a provided window.
+/// \param destination          Window for decompressed samples, each integer_size bytes (or bytes if integer_size is 0).
+/// \param sample_capacity      Number of samples the window holds.
+/// \return The number of samples written, which is less than [sample_capacity] only once the frame ends,
+///         or an error code if the frame is corrupt. After an error, #vbz_dstream_begin must be called again.
+VBZ_EXPORT vbz_size_t vbz_dstream_read_samples(
+    vbz_dstream* stream,
+    void* destination,
+    vbz_size_t sample_capacity);
+
 #if defined(__cplusplus)
 }
 #endif
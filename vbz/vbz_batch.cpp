@@ -0,0 +1,256 @@
+#include "vbz_context.h"
+#include "vbz_parallel.h"
+#include "vbz_sized64.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <numeric>
+#include <vector>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+/// \brief Find the largest possible #vbz_compress_sized output for each item, and their total.
+vbz_size64_t max_item_sizes(
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    CompressionOptions const* options,
+    std::vector<vbz_size64_t>* item_sizes)
+{
+    vbz_size64_t total = 0;
+    for (vbz_size_t item = 0; item < item_count; ++item)
+    {
+        auto const max_size = vbz_max_compressed_size(source_sizes[item], options);
+        if (vbz_is_error(max_size))
+        {
+            return vbz_to_size64(max_size);
+        }
+
+        // The bound already includes the size written by vbz_compress_sized.
+        if (item_sizes)
+        {
+            (*item_sizes)[item] = max_size;
+        }
+        total += max_size;
+    }
+    return total;
+}
+
+/// \brief Order items largest first, so the longest items are not left until the end of the batch.
+std::vector<std::size_t> largest_first(vbz_size_t const* sizes, vbz_size_t item_count)
+{
+    std::vector<std::size_t> order(item_count);
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sizes[a] > sizes[b]; });
+    return order;
+}
+
+/// \brief Run fn(context, item_index) for every item, largest first, on up to [thread_count] threads.
+/// \return 0, or an error if the per worker state could not be allocated.
+template <typename Fn>
+vbz_size_t for_each_item(vbz_size_t const* sizes, vbz_size_t item_count, unsigned int thread_count, Fn fn)
+{
+    std::vector<std::size_t> order;
+    std::vector<vbz_context> contexts;
+    try
+    {
+        order = largest_first(sizes, item_count);
+        contexts.resize(std::min<std::size_t>(vbz_resolve_thread_count(thread_count), item_count));
+    }
+    catch (std::bad_alloc const&)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    vbz_parallel_for(order.size(), contexts.size(), [&](std::size_t worker_index, std::size_t order_index)
+    {
+        fn(&contexts[worker_index], order[order_index]);
+    });
+    return 0;
+}
+
+}
+
+extern "C" {
+
+vbz_size64_t vbz_max_compressed_size_batch(
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    CompressionOptions const* options)
+{
+    return max_item_sizes(source_sizes, item_count, options, nullptr);
+}
+
+vbz_size64_t vbz_compress_batch(
+    void const* const* sources,
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    vbz_size64_t* destination_offsets,
+    CompressionOptions const* options,
+    unsigned int thread_count)
+{
+    std::vector<vbz_size64_t> slot_sizes;
+    std::vector<vbz_size_t> item_results;
+    try
+    {
+        slot_sizes.resize(item_count);
+        item_results.resize(item_count);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return vbz_to_size64(VBZ_OUT_OF_MEMORY_ERROR);
+    }
+
+    auto const max_size = max_item_sizes(source_sizes, item_count, options, &slot_sizes);
+    if (vbz_is_error64(max_size))
+    {
+        return max_size;
+    }
+    if (destination_capacity < max_size)
+    {
+        return vbz_to_size64(VBZ_DESTINATION_SIZE_ERROR);
+    }
+
+    // Compress each item into its own slot, sized for its largest possible output, so items can
+    // be written in any order. Slots are packed together once all are written. The slot offsets
+    // are kept in [destination_offsets] until then.
+    auto const dest_data = static_cast<char*>(destination);
+    vbz_size64_t slot_offset = 0;
+    for (vbz_size_t item = 0; item < item_count; ++item)
+    {
+        destination_offsets[item] = slot_offset;
+        slot_offset += slot_sizes[item];
+    }
+
+    auto const error = for_each_item(source_sizes, item_count, thread_count, [&](vbz_context* context, std::size_t item)
+    {
+        item_results[item] = vbz_compress_sized_ctx(
+            context,
+            sources[item],
+            source_sizes[item],
+            dest_data + destination_offsets[item],
+            vbz_size_t(slot_sizes[item]),
+            options
+        );
+    });
+    if (vbz_is_error(error))
+    {
+        return vbz_to_size64(error);
+    }
+
+    vbz_size64_t compressed_offset = 0;
+    for (vbz_size_t item = 0; item < item_count; ++item)
+    {
+        auto const compressed_size = item_results[item];
+        if (vbz_is_error(compressed_size))
+        {
+            return vbz_to_size64(compressed_size);
+        }
+
+        // No item is larger than its slot, so packing never overwrites a slot which is still to be moved.
+        std::memmove(dest_data + compressed_offset, dest_data + destination_offsets[item], compressed_size);
+        destination_offsets[item] = compressed_offset;
+        compressed_offset += compressed_size;
+    }
+    destination_offsets[item_count] = compressed_offset;
+    return compressed_offset;
+}
+
+vbz_size64_t vbz_decompressed_size_batch(
+    void const* const* sources,
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    CompressionOptions const* options)
+{
+    vbz_size64_t total = 0;
+    for (vbz_size_t item = 0; item < item_count; ++item)
+    {
+        auto const item_size = vbz_decompressed_size(sources[item], source_sizes[item], options);
+        if (vbz_is_error(item_size))
+        {
+            return vbz_to_size64(item_size);
+        }
+        total += item_size;
+    }
+    return total;
+}
+
+vbz_size64_t vbz_decompress_batch(
+    void const* const* sources,
+    vbz_size_t const* source_sizes,
+    vbz_size_t item_count,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    vbz_size64_t* destination_offsets,
+    CompressionOptions const* options,
+    unsigned int thread_count)
+{
+    std::vector<vbz_size_t> item_sizes;
+    std::vector<vbz_size_t> item_results;
+    try
+    {
+        item_sizes.resize(item_count);
+        item_results.resize(item_count);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return vbz_to_size64(VBZ_OUT_OF_MEMORY_ERROR);
+    }
+
+    // Every item's decompressed size is in its header, so items are decompressed straight to their place.
+    vbz_size64_t decompressed_offset = 0;
+    for (vbz_size_t item = 0; item < item_count; ++item)
+    {
+        auto const item_size = vbz_decompressed_size(sources[item], source_sizes[item], options);
+        if (vbz_is_error(item_size))
+        {
+            return vbz_to_size64(item_size);
+        }
+        item_sizes[item] = item_size;
+        destination_offsets[item] = decompressed_offset;
+        decompressed_offset += item_size;
+    }
+    destination_offsets[item_count] = decompressed_offset;
+    if (destination_capacity < decompressed_offset)
+    {
+        return vbz_to_size64(VBZ_DESTINATION_SIZE_ERROR);
+    }
+
+    auto const dest_data = static_cast<char*>(destination);
+    auto const error = for_each_item(item_sizes.data(), item_count, thread_count, [&](vbz_context* context, std::size_t item)
+    {
+        item_results[item] = vbz_decompress_sized_ctx(
+            context,
+            sources[item],
+            source_sizes[item],
+            dest_data + destination_offsets[item],
+            item_sizes[item],
+            options
+        );
+    });
+    if (vbz_is_error(error))
+    {
+        return vbz_to_size64(error);
+    }
+
+    for (vbz_size_t item = 0; item < item_count; ++item)
+    {
+        if (vbz_is_error(item_results[item]))
+        {
+            return vbz_to_size64(item_results[item]);
+        }
+        if (item_results[item] != item_sizes[item])
+        {
+            return vbz_to_size64(VBZ_STREAMVBYTE_STREAM_ERROR);
+        }
+    }
+    return decompressed_offset;
+}
+
+}
@@ -0,0 +1,443 @@
+#include "vbz_context.h"
+#include "vbz_parallel.h"
+#include "vbz_stages.h"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+// A blocked frame is a header, an index with one entry per block, then the compressed blocks in order.
+// Each block is compressed as #vbz_compress_ctx would compress it, starting from the entry's seed, so
+// any block can be decompressed alone. Blocks hold a fixed number of integers, so the block holding
+// any sample is found without searching the index.
+struct VbzBlockedHeader
+{
+    // Kept first, so #vbz_decompressed_size reads blocked frames as sized frames.
+    vbz_size_t original_size;
+    vbz_size_t block_size;
+    vbz_size_t block_count;
+};
+
+struct VbzBlockIndexEntry
+{
+    // Offset of the compressed block from the start of the frame.
+    vbz_size_t compressed_offset;
+    vbz_size_t compressed_size;
+    // The integer preceding the block, which its zig zag deltas start from.
+    std::int32_t seed;
+};
+
+/// \brief Splits data of [original_size] bytes into blocks of [block_size] integers.
+struct BlockLayout
+{
+    std::uint64_t original_size = 0;
+    std::uint64_t element_size = 1;
+    std::uint64_t block_size = VBZ_DEFAULT_BLOCK_SIZE;
+    std::uint64_t block_count = 0;
+
+    BlockLayout() = default;
+    BlockLayout(CompressionOptions const* options, std::uint64_t original_size_, std::uint64_t block_size_)
+    : original_size(original_size_)
+    , element_size(std::max<std::uint64_t>(options->integer_size, 1))
+    , block_size(block_size_ != 0 ? block_size_ : VBZ_DEFAULT_BLOCK_SIZE)
+    , block_count((original_size + block_bytes() - 1) / block_bytes())
+    {
+    }
+
+    std::uint64_t block_bytes() const
+    {
+        return block_size * element_size;
+    }
+
+    std::uint64_t block_offset(std::uint64_t block_index) const
+    {
+        return block_index * block_bytes();
+    }
+
+    std::uint64_t block_length(std::uint64_t block_index) const
+    {
+        return std::min(block_bytes(), original_size - block_offset(block_index));
+    }
+
+    std::uint64_t index_end() const
+    {
+        return sizeof(VbzBlockedHeader) + block_count * sizeof(VbzBlockIndexEntry);
+    }
+};
+
+/// \brief Find the size of the frame #vbz_compress_blocked compresses into, with each block given its max size.
+std::uint64_t max_blocked_size(CompressionOptions const* options, BlockLayout const& layout, std::uint64_t& max_block_size)
+{
+    max_block_size = 0;
+    if (layout.block_count == 0)
+    {
+        return layout.index_end();
+    }
+
+    max_block_size = vbz_max_compressed_size(vbz_size_t(layout.block_length(0)), options);
+    if (vbz_is_error(vbz_size_t(max_block_size)))
+    {
+        return max_block_size;
+    }
+
+    auto const last_block_size = vbz_max_compressed_size(vbz_size_t(layout.block_length(layout.block_count - 1)), options);
+    return layout.index_end() + (layout.block_count - 1) * max_block_size + last_block_size;
+}
+
+/// \brief Check the header and index of the blocked frame in [source], and find where its blocks are.
+/// \return 0, or an error if the frame is not valid.
+vbz_size_t read_blocked_frame(
+    gsl::span<char const> source,
+    CompressionOptions const* options,
+    BlockLayout& layout,
+    gsl::span<VbzBlockIndexEntry const>& index)
+{
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    if (source.size() < std::ptrdiff_t(sizeof(VbzBlockedHeader)))
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto const header = *source.subspan(0, sizeof(VbzBlockedHeader)).as_span<VbzBlockedHeader const>().begin();
+    if (header.block_size == 0)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    layout = BlockLayout(options, header.original_size, header.block_size);
+    if (layout.block_count != header.block_count
+        || layout.original_size % layout.element_size != 0
+        || layout.index_end() > std::uint64_t(source.size()))
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    index = source.subspan(sizeof(VbzBlockedHeader), std::ptrdiff_t(layout.index_end() - sizeof(VbzBlockedHeader)))
+        .as_span<VbzBlockIndexEntry const>();
+    for (auto const& entry : index)
+    {
+        if (entry.compressed_offset < layout.index_end()
+            || std::uint64_t(entry.compressed_offset) + entry.compressed_size > std::uint64_t(source.size()))
+        {
+            return VBZ_INPUT_SIZE_ERROR;
+        }
+    }
+    return 0;
+}
+
+/// \brief Decompress block [block_index] of a blocked frame into [destination], which must be exactly the block's length.
+/// \return The size of the block in bytes, or an error.
+vbz_size_t decompress_block(
+    vbz_context* context,
+    gsl::span<char const> source,
+    CompressionOptions const* options,
+    BlockLayout const& layout,
+    gsl::span<VbzBlockIndexEntry const> index,
+    std::uint64_t block_index,
+    gsl::span<char> destination)
+{
+    auto const& entry = index[std::ptrdiff_t(block_index)];
+    auto const decompressed_size = vbz_decompress_stages(
+        context,
+        source.subspan(std::ptrdiff_t(entry.compressed_offset), std::ptrdiff_t(entry.compressed_size)),
+        destination,
+        options,
+        entry.seed
+    );
+    if (!vbz_is_error(decompressed_size) && decompressed_size != layout.block_length(block_index))
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+    return decompressed_size;
+}
+
+}
+
+extern "C" {
+
+vbz_size_t vbz_max_compressed_size_blocked(
+    vbz_size_t source_size,
+    CompressionOptions const* options,
+    vbz_size_t block_size)
+{
+    // Checks the options are valid.
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    BlockLayout const layout(options, source_size, block_size);
+    std::uint64_t max_block_size = 0;
+    auto const max_size = max_blocked_size(options, layout, max_block_size);
+    if (max_size >= VBZ_FIRST_ERROR)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+    return vbz_size_t(max_size);
+}
+
+vbz_size_t vbz_compress_blocked(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    vbz_size_t block_size,
+    unsigned int thread_count)
+{
+    auto const max_size = vbz_max_compressed_size_blocked(source_size, options, block_size);
+    if (vbz_is_error(max_size))
+    {
+        return max_size;
+    }
+    if (destination_capacity < max_size)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    BlockLayout const layout(options, source_size, block_size);
+    if (layout.original_size % layout.element_size != 0)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto const source_buffer = gsl::make_span(static_cast<char const*>(source), source_size);
+    auto const dest_buffer = gsl::make_span(static_cast<char*>(destination), destination_capacity);
+
+    std::uint64_t max_block_size = 0;
+    max_blocked_size(options, layout, max_block_size);
+
+    // Compress each block into its own slot, sized for the largest possible block, so
+    // blocks can be written in any order. Slots are packed together once all are written.
+    std::vector<vbz_size_t> block_results;
+    std::vector<vbz_context> contexts;
+    try
+    {
+        block_results.resize(std::size_t(layout.block_count));
+        contexts.resize(std::min<std::size_t>(vbz_resolve_thread_count(thread_count), std::size_t(layout.block_count)));
+    }
+    catch (std::bad_alloc const&)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    auto const slot_offset = [&](std::uint64_t block_index) { return layout.index_end() + block_index * max_block_size; };
+    vbz_parallel_for(std::size_t(layout.block_count), contexts.size(), [&](std::size_t worker_index, std::size_t block_index)
+    {
+        auto const slot_end = block_index + 1 < layout.block_count ? slot_offset(block_index + 1) : max_size;
+        block_results[block_index] = vbz_compress_stages(
+            &contexts[worker_index],
+            source_buffer.subspan(std::ptrdiff_t(layout.block_offset(block_index)), std::ptrdiff_t(layout.block_length(block_index))),
+            dest_buffer.subspan(std::ptrdiff_t(slot_offset(block_index)), std::ptrdiff_t(slot_end - slot_offset(block_index))),
+            options,
+            vbz_seed_before(source_buffer, layout.block_offset(block_index), options)
+        );
+    });
+
+    auto index = dest_buffer.subspan(sizeof(VbzBlockedHeader), std::ptrdiff_t(layout.index_end() - sizeof(VbzBlockedHeader)))
+        .as_span<VbzBlockIndexEntry>();
+    std::uint64_t compressed_offset = layout.index_end();
+    for (std::size_t block_index = 0; block_index < layout.block_count; ++block_index)
+    {
+        auto const compressed_size = block_results[block_index];
+        if (vbz_is_error(compressed_size))
+        {
+            return compressed_size;
+        }
+
+        // No block is larger than a slot, so packing never overwrites a slot which is still to be moved.
+        std::memmove(dest_buffer.data() + compressed_offset, dest_buffer.data() + slot_offset(block_index), compressed_size);
+        index[block_index].compressed_offset = vbz_size_t(compressed_offset);
+        index[block_index].compressed_size = compressed_size;
+        index[block_index].seed = vbz_seed_before(source_buffer, layout.block_offset(block_index), options);
+        compressed_offset += compressed_size;
+    }
+
+    auto header = dest_buffer.subspan(0, sizeof(VbzBlockedHeader)).as_span<VbzBlockedHeader>().begin();
+    header->original_size = source_size;
+    header->block_size = vbz_size_t(layout.block_size);
+    header->block_count = vbz_size_t(layout.block_count);
+    return vbz_size_t(compressed_offset);
+}
+
+vbz_size_t vbz_decompress_blocked(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    unsigned int thread_count)
+{
+    auto const source_buffer = gsl::make_span(static_cast<char const*>(source), source_size);
+    BlockLayout layout;
+    gsl::span<VbzBlockIndexEntry const> index;
+    auto const error = read_blocked_frame(source_buffer, options, layout, index);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+    if (destination_capacity < layout.original_size)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    auto const dest_buffer = gsl::make_span(static_cast<char*>(destination), std::ptrdiff_t(layout.original_size));
+    std::vector<vbz_size_t> block_results;
+    std::vector<vbz_context> contexts;
+    try
+    {
+        block_results.resize(std::size_t(layout.block_count));
+        contexts.resize(std::min<std::size_t>(vbz_resolve_thread_count(thread_count), std::size_t(layout.block_count)));
+    }
+    catch (std::bad_alloc const&)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    vbz_parallel_for(std::size_t(layout.block_count), contexts.size(), [&](std::size_t worker_index, std::size_t block_index)
+    {
+        block_results[block_index] = decompress_block(
+            &contexts[worker_index],
+            source_buffer,
+            options,
+            layout,
+            index,
+            block_index,
+            dest_buffer.subspan(std::ptrdiff_t(layout.block_offset(block_index)), std::ptrdiff_t(layout.block_length(block_index)))
+        );
+    });
+
+    for (auto const result : block_results)
+    {
+        if (vbz_is_error(result))
+        {
+            return result;
+        }
+    }
+    return vbz_size_t(layout.original_size);
+}
+
+vbz_size_t vbz_decompress_range(
+    void const* source,
+    vbz_size_t source_size,
+    vbz_size_t first_sample,
+    vbz_size_t sample_count,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_decompress_range_ctx(
+        &context,
+        source,
+        source_size,
+        first_sample,
+        sample_count,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_decompress_range_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    vbz_size_t first_sample,
+    vbz_size_t sample_count,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    auto const source_buffer = gsl::make_span(static_cast<char const*>(source), source_size);
+    BlockLayout layout;
+    gsl::span<VbzBlockIndexEntry const> index;
+    auto const error = read_blocked_frame(source_buffer, options, layout, index);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    auto const range_begin = std::uint64_t(first_sample) * layout.element_size;
+    auto const range_end = range_begin + std::uint64_t(sample_count) * layout.element_size;
+    if (range_end > layout.original_size)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+    if (destination_capacity < range_end - range_begin)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+    if (sample_count == 0)
+    {
+        return 0;
+    }
+
+    auto const dest_buffer = static_cast<char*>(destination);
+    for (auto block_index = range_begin / layout.block_bytes(); block_index * layout.block_bytes() < range_end; ++block_index)
+    {
+        auto const block_begin = layout.block_offset(block_index);
+        auto const block_length = layout.block_length(block_index);
+        auto const copy_begin = std::max(range_begin, block_begin);
+        auto const copy_end = std::min(range_end, block_begin + block_length);
+
+        // Blocks wholly inside the range are decompressed in place, others are decompressed
+        // to scratch space and only the requested samples copied out.
+        if (copy_begin == block_begin && copy_end == block_begin + block_length)
+        {
+            auto const result = decompress_block(
+                context,
+                source_buffer,
+                options,
+                layout,
+                index,
+                block_index,
+                gsl::make_span(dest_buffer + (block_begin - range_begin), std::ptrdiff_t(block_length))
+            );
+            if (vbz_is_error(result))
+            {
+                return result;
+            }
+            continue;
+        }
+
+        auto const block_storage = context->block.get<char>(std::size_t(block_length));
+        if (!block_storage)
+        {
+            return VBZ_OUT_OF_MEMORY_ERROR;
+        }
+        auto const result = decompress_block(
+            context,
+            source_buffer,
+            options,
+            layout,
+            index,
+            block_index,
+            gsl::make_span(block_storage, std::ptrdiff_t(block_length))
+        );
+        if (vbz_is_error(result))
+        {
+            return result;
+        }
+        std::memcpy(dest_buffer + (copy_begin - range_begin), block_storage + (copy_begin - block_begin), std::size_t(copy_end - copy_begin));
+    }
+
+    return vbz_size_t(range_end - range_begin);
+}
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "vbz_scratch_buffer.h"
+
+#include <gsl/gsl-lite.hpp>
+#include <zstd.h>
+
+#include <memory>
+#include <vector>
+
+struct zstd_cctx_delete
+{
+    void operator()(ZSTD_CCtx* x) { ZSTD_freeCCtx(x); }
+};
+
+struct zstd_dctx_delete
+{
+    void operator()(ZSTD_DCtx* x) { ZSTD_freeDCtx(x); }
+};
+
+struct zstd_cdict_delete
+{
+    void operator()(ZSTD_CDict* x) { ZSTD_freeCDict(x); }
+};
+
+struct zstd_ddict_delete
+{
+    void operator()(ZSTD_DDict* x) { ZSTD_freeDDict(x); }
+};
+
+/// \brief State reused between calls to the *_ctx functions (see #vbz_create_context).
+///
+/// zstd contexts are created on first use, and all buffers only ever grow, so repeated calls
+/// on similarly sized data make no allocations.
+struct vbz_context
+{
+    /// \brief Find the zstd compression context, creating it if required.
+    /// \return The context, or nullptr if it could not be allocated.
+    ZSTD_CCtx* zstd_compression_context()
+    {
+        if (!m_zstd_compression_context)
+        {
+            m_zstd_compression_context.reset(ZSTD_createCCtx());
+        }
+        return m_zstd_compression_context.get();
+    }
+
+    /// \brief Find the zstd decompression context, creating it if required.
+    /// \return The context, or nullptr if it could not be allocated.
+    ZSTD_DCtx* zstd_decompression_context()
+    {
+        if (!m_zstd_decompression_context)
+        {
+            m_zstd_decompression_context.reset(ZSTD_createDCtx());
+        }
+        return m_zstd_decompression_context.get();
+    }
+
+    /// \brief Use [dictionary] for all zstd compression and decompression, or no dictionary if it is empty.
+    /// \return false if the dictionary could not be digested.
+    bool set_zstd_dictionary(char const* dictionary, std::size_t size)
+    {
+        m_zstd_compression_dictionary.reset();
+        m_zstd_decompression_dictionary.reset();
+        m_zstd_dictionary.clear();
+        if (size == 0)
+        {
+            return true;
+        }
+
+        m_zstd_dictionary.assign(dictionary, dictionary + size);
+        m_zstd_decompression_dictionary.reset(ZSTD_createDDict(dictionary, size));
+        if (!m_zstd_decompression_dictionary)
+        {
+            m_zstd_dictionary.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool has_zstd_dictionary() const
+    {
+        return !m_zstd_dictionary.empty();
+    }
+
+    /// \brief Find the dictionary digested for compressing at [compression_level], digesting it if required.
+    /// \return The dictionary, or nullptr if it could not be digested. Must only be called when a dictionary is set.
+    ZSTD_CDict const* zstd_compression_dictionary(int compression_level)
+    {
+        // Dictionaries are digested for one level, so are digested again when the level changes.
+        if (!m_zstd_compression_dictionary || m_zstd_compression_dictionary_level != compression_level)
+        {
+            m_zstd_compression_dictionary.reset(ZSTD_createCDict(
+                m_zstd_dictionary.data(),
+                m_zstd_dictionary.size(),
+                compression_level
+            ));
+            m_zstd_compression_dictionary_level = compression_level;
+        }
+        return m_zstd_compression_dictionary.get();
+    }
+
+    /// \brief Find the dictionary digested for decompression, or nullptr if no dictionary is set.
+    ZSTD_DDict const* zstd_decompression_dictionary() const
+    {
+        return m_zstd_decompression_dictionary.get();
+    }
+
+    /// \brief Reference [prefix] from the next zstd frame compressed or decompressed, in place of the dictionary.
+    /// \note zstd only uses a prefix for one frame, so it is cleared by #take_zstd_prefix.
+    void use_zstd_prefix(gsl::span<char const> prefix)
+    {
+        m_zstd_prefix = prefix;
+    }
+
+    /// \brief Find the prefix set by #use_zstd_prefix for this frame, clearing it for the next.
+    gsl::span<char const> take_zstd_prefix()
+    {
+        auto const prefix = m_zstd_prefix;
+        m_zstd_prefix = {};
+        return prefix;
+    }
+
+    // Streamvbyte output waiting to be passed to zstd, or zstd output waiting to be
+    // streamvbyte decoded.
+    ScratchBuffer intermediate;
+
+    // A decompressed block, when only some of its samples were requested.
+    ScratchBuffer block;
+
+    // A reference read, encoded as zstd sees it, to use as a zstd prefix.
+    ScratchBuffer reference;
+
+private:
+    std::unique_ptr<ZSTD_CCtx, zstd_cctx_delete> m_zstd_compression_context;
+    std::unique_ptr<ZSTD_DCtx, zstd_dctx_delete> m_zstd_decompression_context;
+
+    std::vector<char> m_zstd_dictionary;
+    std::unique_ptr<ZSTD_CDict, zstd_cdict_delete> m_zstd_compression_dictionary;
+    int m_zstd_compression_dictionary_level = 0;
+    std::unique_ptr<ZSTD_DDict, zstd_ddict_delete> m_zstd_decompression_dictionary;
+
+    gsl::span<char const> m_zstd_prefix;
+};
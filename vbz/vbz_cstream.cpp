@@ -0,0 +1,464 @@
+#include "v0/vbz_streamvbyte.h"
+#include "v1/vbz_streamvbyte.h"
+#include "vbz_context.h"
+#include "vbz_scratch_buffer.h"
+#include "vbz_sized64.h"
+#include "vbz_stages.h"
+#include "vbz_streamvbyte_tile.h"
+
+#include <gsl/gsl-lite.hpp>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <vector>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+// Samples are staged until this many are pushed, then encoded together, so the
+// streamvbyte kernels see full tiles however few samples are pushed at once.
+static constexpr std::size_t stage_sample_count = 1024;
+
+// Encoded sections are stored in blocks of this many bytes. Small enough that the unused end
+// of the last block costs little per channel, large enough to hold several stages of data.
+static constexpr std::size_t section_block_size = 16 * 1024;
+
+/// \brief Bytes appended to the end of a section of a frame, stored in fixed size blocks.
+///
+/// Growing never moves the bytes already stored, or holds more than one partly used block.
+/// Blocks are kept when the section is cleared, ready for the next frame.
+class SectionBuffer
+{
+public:
+    void clear() { m_size = 0; }
+
+    std::size_t size() const { return m_size; }
+
+    /// \brief Append [bytes] to the end of the section.
+    /// \throws std::bad_alloc if a new block could not be allocated.
+    void append(gsl::span<std::uint8_t const> bytes)
+    {
+        auto input = bytes.data();
+        auto remaining = std::size_t(bytes.size());
+        while (remaining != 0)
+        {
+            auto const offset = m_size % section_block_size;
+            if (m_size / section_block_size == m_blocks.size())
+            {
+                m_blocks.emplace_back(new std::uint8_t[section_block_size]);
+            }
+
+            auto const count = std::min(remaining, section_block_size - offset);
+            std::memcpy(m_blocks[m_size / section_block_size].get() + offset, input, count);
+            m_size += count;
+            input += count;
+            remaining -= count;
+        }
+    }
+
+    /// \brief Find the last byte in the section, which must not be empty.
+    std::uint8_t& back() { return m_blocks[(m_size - 1) / section_block_size][(m_size - 1) % section_block_size]; }
+
+    std::size_t block_count() const { return (m_size + section_block_size - 1) / section_block_size; }
+
+    /// \brief Find the bytes stored in block [index], of #block_count.
+    gsl::span<std::uint8_t const> block(std::size_t index) const
+    {
+        auto const size = std::min(section_block_size, m_size - index * section_block_size);
+        return gsl::make_span<std::uint8_t const>(m_blocks[index].get(), std::ptrdiff_t(size));
+    }
+
+private:
+    std::vector<std::unique_ptr<std::uint8_t[]>> m_blocks;
+    std::size_t m_size = 0;
+};
+
+}
+
+/// \brief State for one frame being compressed by the vbz_cstream_* functions.
+///
+/// A streamvbyte stream stores the keys for every value before any of the data, so the
+/// zstd frame cannot be started until the last sample is known. Pushed samples are kept
+/// streamvbyte encoded instead, as separate key and data sections, and streamed through zstd
+/// once the frame ends.
+struct vbz_cstream
+{
+    CompressionOptions options{};
+    bool begun = false;
+
+    // The last sample encoded, which the next stage's zig zag deltas start from.
+    std::int32_t seed = 0;
+    std::uint64_t sample_count = 0;
+
+    std::array<char, stage_sample_count * sizeof(std::int32_t)> stage;
+    std::size_t stage_count = 0;
+
+    // Keys and data for the samples encoded so far. Without streamvbyte, data holds the raw samples.
+    SectionBuffer keys;
+    SectionBuffer data;
+    // Whether the last data byte holds a single nibble, for the v1 int8 format.
+    bool data_half_byte = false;
+
+    ScratchBuffer encoded;
+};
+
+namespace {
+
+std::size_t sample_size(CompressionOptions const& options)
+{
+    return std::max<std::size_t>(options.integer_size, 1);
+}
+
+/// \brief Append nibble packed [new_data] to the data already in [stream], which may end with a single nibble.
+void append_nibbles(vbz_cstream* stream, gsl::span<std::uint8_t> new_data, bool new_half_byte)
+{
+    if (!stream->data_half_byte)
+    {
+        stream->data.append(new_data);
+        stream->data_half_byte = new_half_byte;
+        return;
+    }
+    if (new_data.empty())
+    {
+        return;
+    }
+
+    // Nibbles fill the low half of each byte first, so shift the new data up one nibble in place,
+    // completing the last byte stored with the first.
+    auto carry = std::uint8_t(stream->data.back() & 0x0F);
+    for (auto& byte : new_data)
+    {
+        auto const next_carry = std::uint8_t(byte >> 4);
+        byte = std::uint8_t(carry | (byte << 4));
+        carry = next_carry;
+    }
+    stream->data.back() = new_data[0];
+    stream->data.append(new_data.subspan(1));
+    if (!new_half_byte)
+    {
+        stream->data.append(gsl::make_span(&carry, 1));
+    }
+    stream->data_half_byte = !new_half_byte;
+}
+
+/// \brief Encode the staged samples, appending them to the stream's keys and data.
+vbz_size_t encode_stage(vbz_cstream* stream)
+{
+    auto const& options = stream->options;
+    auto const staged = gsl::make_span(stream->stage.data(), std::ptrdiff_t(stream->stage_count * sample_size(options)));
+    if (options.integer_size == 0)
+    {
+        stream->data.append(gsl::make_span<std::uint8_t const>(
+            reinterpret_cast<std::uint8_t const*>(staged.data()), staged.size()));
+        stream->stage_count = 0;
+        return 0;
+    }
+
+    auto size_fn = vbz_max_streamvbyte_compressed_size_v0;
+    auto compress_fn = vbz_delta_zig_zag_streamvbyte_compress_seeded_v0;
+    if (options.vbz_version == 1)
+    {
+        size_fn = vbz_max_streamvbyte_compressed_size_v1;
+        compress_fn = vbz_delta_zig_zag_streamvbyte_compress_seeded_v1;
+    }
+
+    auto const max_size = size_fn(options.integer_size, vbz_size_t(staged.size()));
+    auto const encoded = stream->encoded.get<std::uint8_t>(max_size);
+    if (!encoded)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    auto const encoded_size = compress_fn(
+        staged.data(),
+        vbz_size_t(staged.size()),
+        encoded,
+        max_size,
+        options.integer_size,
+        options.perform_delta_zig_zag,
+        stream->seed
+    );
+    if (vbz_is_error(encoded_size))
+    {
+        return encoded_size;
+    }
+
+    // Stages hold a multiple of 4 samples until the last, so their keys never share a byte.
+    auto const key_count = (stream->stage_count + 3) / 4;
+    stream->keys.append(gsl::make_span<std::uint8_t const>(encoded, std::ptrdiff_t(key_count)));
+    auto const new_data = gsl::make_span(encoded + key_count, encoded + encoded_size);
+    if (options.vbz_version == 1 && options.integer_size == 1)
+    {
+        auto const new_half_byte = (streamvbyte_data_units(encoded, stream->stage_count, true) & 1) != 0;
+        append_nibbles(stream, new_data, new_half_byte);
+    }
+    else
+    {
+        stream->data.append(new_data);
+    }
+
+    stream->seed = vbz_seed_before(staged, std::uint64_t(staged.size()), &options);
+    stream->stage_count = 0;
+    return 0;
+}
+
+/// \brief Write [sections] one after another into a zstd frame in [destination].
+vbz_size_t compress_zstd_frame(
+    vbz_context* context,
+    std::initializer_list<SectionBuffer const*> sections,
+    gsl::span<char> destination,
+    int compression_level)
+{
+    auto zstd_context = context->zstd_compression_context();
+    if (!zstd_context)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    std::uint64_t total_size = 0;
+    for (auto const section : sections)
+    {
+        total_size += section->size();
+    }
+
+    ZSTD_CDict const* dictionary = nullptr;
+    if (context->has_zstd_dictionary())
+    {
+        dictionary = context->zstd_compression_dictionary(compression_level);
+        if (!dictionary)
+        {
+            return VBZ_OUT_OF_MEMORY_ERROR;
+        }
+    }
+
+    // The decompressor sizes its output from the frame header, so the content size must be pledged.
+    ZSTD_CCtx_reset(zstd_context, ZSTD_reset_session_and_parameters);
+    if (ZSTD_isError(ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_compressionLevel, compression_level))
+        || ZSTD_isError(ZSTD_CCtx_setPledgedSrcSize(zstd_context, total_size))
+        || (dictionary && ZSTD_isError(ZSTD_CCtx_refCDict(zstd_context, dictionary))))
+    {
+        return VBZ_ZSTD_ERROR;
+    }
+
+    // Blocks are streamed through the context's own window, so the read is never joined into one buffer.
+    // The frame always ends with more output, so filling the destination before then means it is too small.
+    ZSTD_outBuffer output{ destination.data(), std::size_t(destination.size()), 0 };
+    for (auto const section : sections)
+    {
+        for (std::size_t index = 0; index < section->block_count(); ++index)
+        {
+            auto const block = section->block(index);
+            ZSTD_inBuffer input{ block.data(), std::size_t(block.size()), 0 };
+            while (input.pos < input.size)
+            {
+                if (ZSTD_isError(ZSTD_compressStream2(zstd_context, &output, &input, ZSTD_e_continue)))
+                {
+                    return VBZ_ZSTD_ERROR;
+                }
+                if (output.pos == output.size)
+                {
+                    return VBZ_DESTINATION_SIZE_ERROR;
+                }
+            }
+        }
+    }
+
+    ZSTD_inBuffer input{ nullptr, 0, 0 };
+    std::size_t remaining = 0;
+    do
+    {
+        remaining = ZSTD_compressStream2(zstd_context, &output, &input, ZSTD_e_end);
+        if (ZSTD_isError(remaining))
+        {
+            return VBZ_ZSTD_ERROR;
+        }
+        if (remaining != 0 && output.pos == output.size)
+        {
+            return VBZ_DESTINATION_SIZE_ERROR;
+        }
+    } while (remaining != 0);
+    return vbz_size_t(output.pos);
+}
+
+vbz_size_t copy_sections(
+    std::initializer_list<SectionBuffer const*> sections,
+    gsl::span<char> destination)
+{
+    std::uint64_t total_size = 0;
+    for (auto const section : sections)
+    {
+        total_size += section->size();
+    }
+    if (total_size > std::uint64_t(destination.size()))
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    auto position = destination.data();
+    for (auto const section : sections)
+    {
+        for (std::size_t index = 0; index < section->block_count(); ++index)
+        {
+            auto const block = section->block(index);
+            position = std::copy(block.begin(), block.end(), position);
+        }
+    }
+    return vbz_size_t(total_size);
+}
+
+}
+
+extern "C" {
+
+vbz_cstream* vbz_create_cstream(void)
+{
+    return new (std::nothrow) vbz_cstream();
+}
+
+void vbz_free_cstream(vbz_cstream* stream)
+{
+    delete stream;
+}
+
+vbz_size_t vbz_cstream_begin(vbz_cstream* stream, CompressionOptions const* options)
+{
+    // Checks the options are valid.
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    stream->options = *options;
+    stream->begun = true;
+    stream->seed = 0;
+    stream->sample_count = 0;
+    stream->stage_count = 0;
+    stream->keys.clear();
+    stream->data.clear();
+    stream->data_half_byte = false;
+    return 0;
+}
+
+vbz_size_t vbz_cstream_push_samples(vbz_cstream* stream, void const* samples, vbz_size_t sample_count)
+{
+    if (!stream->begun)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    // The frame's sized header holds the original size in a vbz_size_t, which must not be the 64 bit marker.
+    auto const element_size = sample_size(stream->options);
+    if ((stream->sample_count + sample_count) * element_size >= VBZ_SIZED64_MARKER)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto input = static_cast<char const*>(samples);
+    auto remaining = std::size_t(sample_count);
+    try
+    {
+        while (remaining != 0)
+        {
+            auto const count = std::min(remaining, stage_sample_count - stream->stage_count);
+            std::memcpy(stream->stage.data() + stream->stage_count * element_size, input, count * element_size);
+            stream->stage_count += count;
+            stream->sample_count += count;
+            input += count * element_size;
+            remaining -= count;
+
+            if (stream->stage_count == stage_sample_count)
+            {
+                auto const result = encode_stage(stream);
+                if (vbz_is_error(result))
+                {
+                    return result;
+                }
+            }
+        }
+    }
+    catch (std::bad_alloc const&)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+    return sample_count;
+}
+
+vbz_size_t vbz_cstream_max_compressed_size(vbz_cstream const* stream)
+{
+    auto const original_size = stream->sample_count * sample_size(stream->options);
+    return vbz_max_compressed_size(vbz_size_t(original_size), &stream->options);
+}
+
+vbz_size_t vbz_cstream_end(
+    vbz_cstream* stream,
+    vbz_context* context,
+    void* destination,
+    vbz_size_t destination_capacity)
+{
+    if (!stream->begun)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    if (stream->stage_count != 0)
+    {
+        try
+        {
+            auto const result = encode_stage(stream);
+            if (vbz_is_error(result))
+            {
+                return result;
+            }
+        }
+        catch (std::bad_alloc const&)
+        {
+            return VBZ_OUT_OF_MEMORY_ERROR;
+        }
+    }
+
+    auto const dest_buffer = gsl::make_span(static_cast<char*>(destination), destination_capacity);
+    if (dest_buffer.size() < std::ptrdiff_t(sizeof(vbz_size_t)))
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    // Written as #vbz_compress_sized would write it.
+    auto const original_size = vbz_size_t(stream->sample_count * sample_size(stream->options));
+    std::memcpy(dest_buffer.data(), &original_size, sizeof(original_size));
+
+    std::initializer_list<SectionBuffer const*> const sections = { &stream->keys, &stream->data };
+    auto const frame_buffer = dest_buffer.subspan(sizeof(vbz_size_t));
+    vbz_size_t frame_size = 0;
+    if (stream->options.zstd_compression_level == 0)
+    {
+        frame_size = copy_sections(sections, frame_buffer);
+    }
+    else
+    {
+        vbz_context local_context;
+        frame_size = compress_zstd_frame(
+            context ? context : &local_context,
+            sections,
+            frame_buffer,
+            int(stream->options.zstd_compression_level)
+        );
+    }
+    if (vbz_is_error(frame_size))
+    {
+        return frame_size;
+    }
+
+    stream->begun = false;
+    return vbz_size_t(frame_size + sizeof(vbz_size_t));
+}
+
+}
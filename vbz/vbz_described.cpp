@@ -0,0 +1,453 @@
+#include "vbz_context.h"
+#include "vbz_stages.h"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+// A described frame is this header, then the data as #vbz_compress_sized writes it, with the
+// stages skipped by #vbz_compress_adaptive removed from the options. A constant frame holds the
+// original size then the single repeated integer.
+struct VbzDescribedHeader
+{
+    char magic[4];
+    std::uint8_t format_version;
+    std::uint8_t vbz_version;
+    std::uint8_t integer_size;
+    std::uint8_t flags;
+    std::uint32_t zstd_compression_level;
+};
+
+static_assert(sizeof(VbzDescribedHeader) + sizeof(vbz_size_t) == VBZ_DESCRIBED_HEADER_SIZE, "Unexpected header size");
+
+char const described_magic[4] = { 'V', 'B', 'Z', 'F' };
+std::uint8_t const described_format_version = 1;
+std::uint8_t const zig_zag_flag = 0x1;
+std::uint8_t const streamvbyte_skipped_flag = 0x2;
+std::uint8_t const zstd_skipped_flag = 0x4;
+std::uint8_t const constant_flag = 0x8;
+std::uint8_t const known_flags = zig_zag_flag | streamvbyte_skipped_flag | zstd_skipped_flag | constant_flag;
+
+// zstd is skipped for data with more bits of entropy per byte than this, estimated from a sample.
+// Huffman coding gains almost nothing that close to 8 bits, and matches are rare in such noisy data.
+double const adaptive_max_entropy = 7.9;
+std::size_t const adaptive_entropy_sample_size = 4096;
+
+/// \brief Estimate the order 0 entropy of [data], in bits per byte, from an even sample of it.
+double estimate_entropy(gsl::span<char const> data)
+{
+    std::array<std::uint32_t, 256> counts{};
+    auto const stride = std::max<std::size_t>(1, data.size() / adaptive_entropy_sample_size);
+    std::size_t sampled = 0;
+    for (std::size_t i = 0; i < std::size_t(data.size()); i += stride)
+    {
+        ++counts[std::uint8_t(data[i])];
+        ++sampled;
+    }
+
+    double entropy = 0;
+    for (auto const count : counts)
+    {
+        if (count != 0)
+        {
+            auto const probability = double(count) / double(sampled);
+            entropy -= probability * std::log2(probability);
+        }
+    }
+    return entropy;
+}
+
+/// \brief Find if [data] is one integer of [unit_size] bytes repeated, with at least one integer.
+bool is_constant(gsl::span<char const> data, std::size_t unit_size)
+{
+    if (std::size_t(data.size()) < unit_size || data.size() % unit_size != 0)
+    {
+        return false;
+    }
+    // Data repeats with period unit_size exactly when it matches itself shifted by one unit.
+    return std::memcmp(data.data(), data.data() + unit_size, data.size() - unit_size) == 0;
+}
+
+/// \brief Fill [destination] with copies of the [unit_size] byte integer at [value].
+void fill_constant(char* destination, std::size_t size, char const* value, std::size_t unit_size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    if (unit_size == 1)
+    {
+        std::memset(destination, *value, size);
+        return;
+    }
+
+    // Copy the filled part over the rest, doubling it each time.
+    std::memcpy(destination, value, unit_size);
+    std::size_t filled = unit_size;
+    while (filled < size)
+    {
+        auto const copy_size = std::min(filled, size - filled);
+        std::memcpy(destination + filled, destination, copy_size);
+        filled += copy_size;
+    }
+}
+
+/// \brief Write the header of a described frame for [options] to the start of [destination].
+/// \return The size of the header, or an error.
+vbz_size_t write_header(gsl::span<char> destination, CompressionOptions const* options, std::uint8_t flags)
+{
+    // Checks the options are valid, and fit in the header.
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+    if (options->vbz_version > UINT8_MAX)
+    {
+        return VBZ_VERSION_ERROR;
+    }
+    if (destination.size() < std::ptrdiff_t(sizeof(VbzDescribedHeader)))
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    VbzDescribedHeader header;
+    std::memcpy(header.magic, described_magic, sizeof(header.magic));
+    header.format_version = described_format_version;
+    header.vbz_version = std::uint8_t(options->vbz_version);
+    header.integer_size = std::uint8_t(options->integer_size);
+    header.flags = flags | (options->perform_delta_zig_zag ? zig_zag_flag : 0);
+    header.zstd_compression_level = options->zstd_compression_level;
+    std::memcpy(destination.data(), &header, sizeof(header));
+    return vbz_size_t(sizeof(header));
+}
+
+}
+
+extern "C" {
+
+vbz_size_t vbz_compress_described(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_compress_described_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_compress_described_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    auto const dest_buffer = gsl::make_span(static_cast<char*>(destination), destination_capacity);
+    auto const header_size = write_header(dest_buffer, options, 0);
+    if (vbz_is_error(header_size))
+    {
+        return header_size;
+    }
+
+    auto const sized_buffer = dest_buffer.subspan(header_size);
+    auto const sized_size = vbz_compress_sized_ctx(
+        context,
+        source,
+        source_size,
+        sized_buffer.data(),
+        vbz_size_t(sized_buffer.size()),
+        options
+    );
+    if (vbz_is_error(sized_size))
+    {
+        return sized_size;
+    }
+    return sized_size + header_size;
+}
+
+vbz_size_t vbz_compress_adaptive(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_compress_adaptive_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size_t vbz_compress_adaptive_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options)
+{
+    auto const source_buffer = gsl::make_span(static_cast<char const*>(source), source_size);
+    auto const dest_buffer = gsl::make_span(static_cast<char*>(destination), destination_capacity);
+    auto const unit_size = std::max<std::size_t>(options->integer_size, 1);
+
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+    if (source_size % unit_size != 0)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    // Store the original size, then the data as the chosen stages leave it.
+    auto const write_payload = [&](std::uint8_t flags, gsl::span<char const> payload) -> vbz_size_t
+    {
+        auto const header_size = write_header(dest_buffer, options, flags);
+        if (vbz_is_error(header_size))
+        {
+            return header_size;
+        }
+        auto const payload_offset = header_size + sizeof(source_size);
+        if (std::size_t(dest_buffer.size()) < payload_offset + payload.size())
+        {
+            return VBZ_DESTINATION_SIZE_ERROR;
+        }
+        std::memcpy(dest_buffer.data() + header_size, &source_size, sizeof(source_size));
+        if (!payload.empty())
+        {
+            std::memmove(dest_buffer.data() + payload_offset, payload.data(), payload.size());
+        }
+        return vbz_size_t(payload_offset + payload.size());
+    };
+
+    if (is_constant(source_buffer, unit_size))
+    {
+        return write_payload(constant_flag, source_buffer.first(unit_size));
+    }
+    // Data this small is not worth starting either stage for.
+    if (source_size <= VBZ_ADAPTIVE_RAW_SIZE)
+    {
+        return write_payload(streamvbyte_skipped_flag | zstd_skipped_flag, source_buffer);
+    }
+
+    std::uint8_t flags = 0;
+    auto zstd_source = source_buffer;
+    if (options->integer_size != 0)
+    {
+        auto streamvbyte_options = *options;
+        streamvbyte_options.zstd_compression_level = 0;
+        auto const max_size = vbz_max_compressed_size(source_size, &streamvbyte_options);
+        if (vbz_is_error(max_size))
+        {
+            return max_size;
+        }
+        auto const storage = static_cast<char*>(context->intermediate.reserve(max_size));
+        if (!storage)
+        {
+            return VBZ_OUT_OF_MEMORY_ERROR;
+        }
+
+        auto const encoded_size = vbz_compress_stages(
+            context,
+            source_buffer,
+            gsl::make_span(storage, max_size),
+            &streamvbyte_options,
+            0
+        );
+        if (vbz_is_error(encoded_size))
+        {
+            return encoded_size;
+        }
+
+        // Keys cost a quarter byte per integer, more than is saved when most integers need every byte.
+        if (encoded_size < source_size)
+        {
+            zstd_source = gsl::make_span<char const>(storage, encoded_size);
+        }
+        else
+        {
+            flags |= streamvbyte_skipped_flag;
+        }
+    }
+
+    if (options->zstd_compression_level == 0)
+    {
+        return write_payload(flags, zstd_source);
+    }
+    if (estimate_entropy(zstd_source) > adaptive_max_entropy)
+    {
+        return write_payload(flags | zstd_skipped_flag, zstd_source);
+    }
+
+    auto const header_size = write_header(dest_buffer, options, flags);
+    if (vbz_is_error(header_size))
+    {
+        return header_size;
+    }
+    auto const payload_offset = header_size + sizeof(source_size);
+    if (std::size_t(dest_buffer.size()) < payload_offset)
+    {
+        return VBZ_DESTINATION_SIZE_ERROR;
+    }
+
+    CompressionOptions zstd_options{ false, 0, options->zstd_compression_level, options->vbz_version };
+    auto const zstd_size = vbz_compress_stages(
+        context,
+        zstd_source,
+        dest_buffer.subspan(payload_offset),
+        &zstd_options,
+        0
+    );
+    if (vbz_is_error(zstd_size) && zstd_size != VBZ_DESTINATION_SIZE_ERROR && zstd_size != VBZ_ZSTD_ERROR)
+    {
+        return zstd_size;
+    }
+
+    // zstd can still grow data the estimate let through, it is then stored without it.
+    if (vbz_is_error(zstd_size) || zstd_size >= std::size_t(zstd_source.size()))
+    {
+        return write_payload(flags | zstd_skipped_flag, zstd_source);
+    }
+    std::memcpy(dest_buffer.data() + header_size, &source_size, sizeof(source_size));
+    return vbz_size_t(payload_offset + zstd_size);
+}
+
+vbz_size_t vbz_frame_info(
+    void const* source,
+    vbz_size_t source_size,
+    VbzFrameInfo* info)
+{
+    if (source_size < VBZ_DESCRIBED_HEADER_SIZE)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    VbzDescribedHeader header;
+    std::memcpy(&header, source, sizeof(header));
+    if (std::memcmp(header.magic, described_magic, sizeof(header.magic)) != 0)
+    {
+        return VBZ_FRAME_HEADER_ERROR;
+    }
+    if (header.format_version != described_format_version)
+    {
+        return VBZ_VERSION_ERROR;
+    }
+    if ((header.flags & ~known_flags) != 0
+        || ((header.flags & constant_flag) && (header.flags & (streamvbyte_skipped_flag | zstd_skipped_flag))))
+    {
+        return VBZ_FRAME_HEADER_ERROR;
+    }
+
+    info->options.perform_delta_zig_zag = (header.flags & zig_zag_flag) != 0;
+    info->options.integer_size = header.integer_size;
+    info->options.zstd_compression_level = header.zstd_compression_level;
+    info->options.vbz_version = header.vbz_version;
+    std::memcpy(&info->original_size, static_cast<char const*>(source) + sizeof(header), sizeof(info->original_size));
+
+    auto const error = vbz_max_compressed_size(0, &info->options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+    return 0;
+}
+
+vbz_size_t vbz_decompress_auto(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity)
+{
+    vbz_context context;
+    return vbz_decompress_auto_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity
+    );
+}
+
+vbz_size_t vbz_decompress_auto_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity)
+{
+    VbzFrameInfo info;
+    auto const error = vbz_frame_info(source, source_size, &info);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    std::uint8_t flags = 0;
+    std::memcpy(&flags, static_cast<char const*>(source) + offsetof(VbzDescribedHeader, flags), sizeof(flags));
+
+    auto const payload = static_cast<char const*>(source) + VBZ_DESCRIBED_HEADER_SIZE;
+    auto const payload_size = source_size - VBZ_DESCRIBED_HEADER_SIZE;
+    if (flags & constant_flag)
+    {
+        auto const unit_size = std::max<std::size_t>(info.options.integer_size, 1);
+        // Constant frames are only written for data holding at least one integer.
+        if (payload_size != unit_size || info.original_size < unit_size || info.original_size % unit_size != 0)
+        {
+            return VBZ_INPUT_SIZE_ERROR;
+        }
+        if (destination_capacity < info.original_size)
+        {
+            return VBZ_DESTINATION_SIZE_ERROR;
+        }
+        fill_constant(static_cast<char*>(destination), info.original_size, payload, unit_size);
+        return info.original_size;
+    }
+
+    // Skipped stages were not applied, so the data is decompressed as if they were disabled.
+    auto options = info.options;
+    if (flags & streamvbyte_skipped_flag)
+    {
+        options.integer_size = 0;
+    }
+    if (flags & zstd_skipped_flag)
+    {
+        options.zstd_compression_level = 0;
+    }
+
+    return vbz_decompress_sized_ctx(
+        context,
+        static_cast<char const*>(source) + sizeof(VbzDescribedHeader),
+        vbz_size_t(source_size - sizeof(VbzDescribedHeader)),
+        destination,
+        destination_capacity,
+        &options
+    );
+}
+
+}
@@ -0,0 +1,132 @@
+#include "vbz_context.h"
+#include "vbz_stages.h"
+
+#include <gsl/gsl-lite.hpp>
+#include <zdict.h>
+#include <zstd.h>
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+extern "C" {
+
+vbz_size_t vbz_train_dictionary(
+    void const* const* samples,
+    vbz_size_t const* sample_sizes,
+    vbz_size_t sample_count,
+    void* dictionary,
+    vbz_size_t dictionary_capacity,
+    CompressionOptions const* options)
+{
+    // zstd sees the streamvbyte encoded data, so the dictionary is trained on that.
+    auto streamvbyte_options = *options;
+    streamvbyte_options.zstd_compression_level = 0;
+
+    std::vector<char> encoded;
+    std::vector<std::size_t> encoded_sizes;
+    vbz_context context;
+    try
+    {
+        std::uint64_t max_size = 0;
+        for (vbz_size_t sample = 0; sample < sample_count; ++sample)
+        {
+            auto const sample_max_size = vbz_max_compressed_size(sample_sizes[sample], &streamvbyte_options);
+            if (vbz_is_error(sample_max_size))
+            {
+                return sample_max_size;
+            }
+            max_size += sample_max_size;
+        }
+        encoded.resize(std::size_t(max_size));
+        encoded_sizes.resize(sample_count);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    std::size_t encoded_offset = 0;
+    for (vbz_size_t sample = 0; sample < sample_count; ++sample)
+    {
+        auto const encoded_size = vbz_compress_stages(
+            &context,
+            gsl::make_span(static_cast<char const*>(samples[sample]), sample_sizes[sample]),
+            gsl::make_span(encoded.data() + encoded_offset, encoded.size() - encoded_offset),
+            &streamvbyte_options,
+            0
+        );
+        if (vbz_is_error(encoded_size))
+        {
+            return encoded_size;
+        }
+        encoded_sizes[sample] = encoded_size;
+        encoded_offset += encoded_size;
+    }
+
+    auto const dictionary_size = ZDICT_trainFromBuffer(
+        dictionary,
+        dictionary_capacity,
+        encoded.data(),
+        encoded_sizes.data(),
+        unsigned(sample_count)
+    );
+    if (ZDICT_isError(dictionary_size))
+    {
+        return VBZ_ZSTD_ERROR;
+    }
+    return vbz_size_t(dictionary_size);
+}
+
+vbz_size_t vbz_dictionary_id(
+    void const* dictionary,
+    vbz_size_t dictionary_size)
+{
+    return vbz_size_t(ZDICT_getDictID(dictionary, dictionary_size));
+}
+
+vbz_size_t vbz_context_set_dictionary(
+    vbz_context* context,
+    void const* dictionary,
+    vbz_size_t dictionary_size)
+{
+    try
+    {
+        if (!context->set_zstd_dictionary(static_cast<char const*>(dictionary), dictionary_size))
+        {
+            return VBZ_OUT_OF_MEMORY_ERROR;
+        }
+    }
+    catch (std::bad_alloc const&)
+    {
+        context->set_zstd_dictionary(nullptr, 0);
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+    return 0;
+}
+
+vbz_size_t vbz_frame_dictionary_id(
+    void const* source,
+    vbz_size_t source_size,
+    CompressionOptions const* options)
+{
+    if (source_size < sizeof(vbz_size_t))
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+    if (options->zstd_compression_level == 0)
+    {
+        return 0;
+    }
+
+    // Skip the size written by vbz_compress_sized.
+    return vbz_size_t(ZSTD_getDictID_fromFrame(
+        static_cast<char const*>(source) + sizeof(vbz_size_t),
+        source_size - sizeof(vbz_size_t)
+    ));
+}
+
+}
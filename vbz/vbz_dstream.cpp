@@ -0,0 +1,454 @@
+#include "v0/vbz_streamvbyte.h"
+#include "v1/vbz_streamvbyte.h"
+#include "vbz_context.h"
+#include "vbz_stages.h"
+#include "vbz_streamvbyte_tile.h"
+
+#include <gsl/gsl-lite.hpp>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+// Samples are decoded this many at a time, into the caller's window when it has room for them all.
+static constexpr std::size_t tile_sample_count = 4096;
+
+// Decoded bytes buffered from each section of the frame. Fits a full tile of keys or data.
+static constexpr std::size_t section_buffer_size = 64 * 1024;
+
+/// \brief Bytes read in order from one section of a frame's content.
+///
+/// When the frame is zstd compressed, the section has its own zstd stream over the frame, which
+/// decodes into a fixed buffer as bytes are needed. Otherwise bytes are read straight from the frame.
+class FrameSection
+{
+public:
+    /// \brief Start reading [content], which is zstd compressed if [zstd] is set.
+    /// \return 0, or an error.
+    vbz_size_t begin(gsl::span<std::uint8_t const> content, bool zstd)
+    {
+        m_input = ZSTD_inBuffer{ content.data(), std::size_t(content.size()), 0 };
+        m_zstd = zstd;
+        m_frame_ended = !zstd;
+        m_begin = 0;
+        m_end = 0;
+        if (!zstd)
+        {
+            return 0;
+        }
+
+        if (!m_context)
+        {
+            m_context.reset(ZSTD_createDCtx());
+            if (!m_context)
+            {
+                return VBZ_OUT_OF_MEMORY_ERROR;
+            }
+        }
+        ZSTD_DCtx_reset(m_context.get(), ZSTD_reset_session_only);
+        return 0;
+    }
+
+    /// \brief Find the next [count] bytes of the section, decoding them if required.
+    /// \note [count] must not exceed section_buffer_size.
+    /// \return The bytes, or nullptr if the section ends first. [error] is set if it could not be decoded.
+    std::uint8_t const* peek(std::size_t count, vbz_size_t& error)
+    {
+        if (!m_zstd)
+        {
+            if (m_input.size - m_input.pos < count)
+            {
+                error = VBZ_STREAMVBYTE_STREAM_ERROR;
+                return nullptr;
+            }
+            return static_cast<std::uint8_t const*>(m_input.src) + m_input.pos;
+        }
+
+        if (m_end - m_begin < count)
+        {
+            std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+        }
+        while (m_end - m_begin < count)
+        {
+            if (m_frame_ended)
+            {
+                error = VBZ_STREAMVBYTE_STREAM_ERROR;
+                return nullptr;
+            }
+
+            ZSTD_outBuffer output{ m_buffer.data(), m_buffer.size(), m_end };
+            auto const input_position = m_input.pos;
+            auto const result = ZSTD_decompressStream(m_context.get(), &output, &m_input);
+            if (ZSTD_isError(result))
+            {
+                error = VBZ_ZSTD_ERROR;
+                return nullptr;
+            }
+            m_frame_ended = result == 0;
+            if (!m_frame_ended && output.pos == m_end && m_input.pos == input_position)
+            {
+                // The frame is truncated.
+                error = VBZ_ZSTD_ERROR;
+                return nullptr;
+            }
+            m_end = output.pos;
+        }
+        return m_buffer.data() + m_begin;
+    }
+
+    /// \brief Move past [count] bytes returned by #peek.
+    void consume(std::size_t count)
+    {
+        if (m_zstd)
+        {
+            m_begin += count;
+        }
+        else
+        {
+            m_input.pos += count;
+        }
+    }
+
+    /// \brief Move past [count] bytes, decoding them if required.
+    /// \return 0, or an error.
+    vbz_size_t skip(std::uint64_t count)
+    {
+        vbz_size_t error = 0;
+        while (count != 0)
+        {
+            auto const step = std::size_t(std::min<std::uint64_t>(count, m_buffer.size()));
+            if (!peek(step, error))
+            {
+                return error;
+            }
+            consume(step);
+            count -= step;
+        }
+        return 0;
+    }
+
+    /// \brief Check that every byte of the section has been consumed, and nothing follows it.
+    bool at_end()
+    {
+        vbz_size_t error = 0;
+        return !peek(1, error) && error == VBZ_STREAMVBYTE_STREAM_ERROR && m_input.pos == m_input.size;
+    }
+
+private:
+    std::unique_ptr<ZSTD_DCtx, zstd_dctx_delete> m_context;
+    ZSTD_inBuffer m_input{};
+    bool m_zstd = false;
+    bool m_frame_ended = false;
+
+    std::array<std::uint8_t, section_buffer_size> m_buffer;
+    std::size_t m_begin = 0;
+    std::size_t m_end = 0;
+};
+
+}
+
+/// \brief State for one frame being decompressed by the vbz_dstream_* functions.
+///
+/// A streamvbyte stream stores the keys for every value before any of the data, so the keys
+/// and data sections are read by separate FrameSections, each positioned within the frame.
+/// Only a tile of samples is decoded at once, so memory use does not depend on the frame size.
+struct vbz_dstream
+{
+    CompressionOptions options{};
+    bool begun = false;
+
+    std::uint64_t sample_count = 0;
+    std::uint64_t decoded_count = 0;
+    // The last sample decoded, which the next tile's zig zag deltas start from.
+    std::int32_t seed = 0;
+    // Whether the next data byte's low nibble has already been decoded, for the v1 int8 format.
+    bool data_half_byte = false;
+
+    FrameSection keys;
+    FrameSection data;
+
+    // Keys and data for one tile, joined as the streamvbyte decoders expect.
+    std::array<std::uint8_t, tile_sample_count / 4 + tile_sample_count * sizeof(std::int32_t)> encoded;
+
+    std::array<char, tile_sample_count * sizeof(std::int32_t)> decoded;
+    std::size_t decoded_begin = 0;
+    std::size_t decoded_end = 0;
+};
+
+namespace {
+
+std::size_t sample_size(CompressionOptions const& options)
+{
+    return std::max<std::size_t>(options.integer_size, 1);
+}
+
+bool uses_nibbles(CompressionOptions const& options)
+{
+    return options.vbz_version == 1 && options.integer_size == 1;
+}
+
+/// \brief Find the size in bytes of the next tile of samples in [stream].
+std::size_t next_tile_size(vbz_dstream const* stream)
+{
+    auto const count = std::min<std::uint64_t>(tile_sample_count, stream->sample_count - stream->decoded_count);
+    return std::size_t(count * sample_size(stream->options));
+}
+
+/// \brief Decode the next tile of samples in [stream] into [destination], which holds #next_tile_size bytes.
+/// \return 0, or an error.
+vbz_size_t decode_tile(vbz_dstream* stream, char* destination)
+{
+    auto const& options = stream->options;
+    auto const tile_bytes = next_tile_size(stream);
+    auto const count = tile_bytes / sample_size(options);
+    vbz_size_t error = 0;
+
+    if (options.integer_size == 0)
+    {
+        auto const bytes = stream->data.peek(tile_bytes, error);
+        if (!bytes)
+        {
+            return error;
+        }
+        std::memcpy(destination, bytes, tile_bytes);
+        stream->data.consume(tile_bytes);
+    }
+    else
+    {
+        // Tiles hold a multiple of 4 samples until the last, so their keys never share a byte.
+        auto const key_count = (count + 3) / 4;
+        auto const keys = stream->keys.peek(key_count, error);
+        if (!keys)
+        {
+            return error;
+        }
+        std::memcpy(stream->encoded.data(), keys, key_count);
+
+        auto const nibbles = uses_nibbles(options);
+        auto const units = streamvbyte_data_units(keys, count, nibbles);
+        auto const encoded_data = stream->encoded.data() + key_count;
+        std::size_t data_size = units;
+        std::size_t data_consumed = units;
+        if (nibbles)
+        {
+            // Shift the data down a nibble if the previous tile ended part way through a byte.
+            auto const start_nibble = std::size_t(stream->data_half_byte);
+            auto const available = (start_nibble + units + 1) / 2;
+            auto const data = stream->data.peek(available, error);
+            if (!data)
+            {
+                return error;
+            }
+            data_size = (units + 1) / 2;
+            data_consumed = (start_nibble + units) / 2;
+            for (std::size_t i = 0; i < data_size; ++i)
+            {
+                auto const next = i + 1 < available ? data[i + 1] : 0;
+                encoded_data[i] = start_nibble ? std::uint8_t((data[i] >> 4) | (next << 4)) : data[i];
+            }
+            if (units & 1)
+            {
+                // The high nibble belongs to the next tile.
+                encoded_data[data_size - 1] &= 0x0F;
+            }
+            stream->data_half_byte = ((start_nibble + units) & 1) != 0;
+        }
+        else
+        {
+            auto const data = stream->data.peek(data_size, error);
+            if (!data)
+            {
+                return error;
+            }
+            std::memcpy(encoded_data, data, data_size);
+        }
+
+        auto decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_seeded_v0;
+        if (options.vbz_version == 1)
+        {
+            decompress_fn = vbz_delta_zig_zag_streamvbyte_decompress_seeded_v1;
+        }
+        auto const decoded_size = decompress_fn(
+            stream->encoded.data(),
+            vbz_size_t(key_count + data_size),
+            destination,
+            vbz_size_t(tile_bytes),
+            options.integer_size,
+            options.perform_delta_zig_zag,
+            stream->seed
+        );
+        if (vbz_is_error(decoded_size))
+        {
+            return decoded_size;
+        }
+
+        stream->keys.consume(key_count);
+        stream->data.consume(data_consumed);
+
+        stream->seed = vbz_seed_before(
+            gsl::make_span<char const>(destination, std::ptrdiff_t(tile_bytes)),
+            tile_bytes,
+            &options
+        );
+    }
+
+    stream->decoded_count += count;
+
+    if (stream->decoded_count == stream->sample_count)
+    {
+        if (stream->data_half_byte)
+        {
+            // The final byte's unused high nibble is part of the last tile.
+            stream->data.consume(1);
+            stream->data_half_byte = false;
+        }
+        if (!stream->data.at_end())
+        {
+            return VBZ_STREAMVBYTE_STREAM_ERROR;
+        }
+    }
+    return 0;
+}
+
+}
+
+extern "C" {
+
+vbz_dstream* vbz_create_dstream(void)
+{
+    return new (std::nothrow) vbz_dstream();
+}
+
+void vbz_free_dstream(vbz_dstream* stream)
+{
+    delete stream;
+}
+
+vbz_size_t vbz_dstream_begin(
+    vbz_dstream* stream,
+    void const* source,
+    vbz_size_t source_size,
+    CompressionOptions const* options)
+{
+    // Checks the options are valid.
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+    stream->begun = false;
+
+    vbz_size_t original_size = 0;
+    if (source_size < sizeof(original_size))
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+    std::memcpy(&original_size, source, sizeof(original_size));
+
+    auto const element_size = sample_size(*options);
+    if (original_size % element_size != 0)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto const content = gsl::make_span(
+        static_cast<std::uint8_t const*>(source) + sizeof(original_size),
+        std::ptrdiff_t(source_size - sizeof(original_size))
+    );
+    auto const zstd = options->zstd_compression_level != 0;
+
+    stream->options = *options;
+    stream->sample_count = original_size / element_size;
+    stream->decoded_count = 0;
+    stream->seed = 0;
+    stream->data_half_byte = false;
+    stream->decoded_begin = 0;
+    stream->decoded_end = 0;
+
+    // Without streamvbyte, the data section is the whole frame.
+    std::uint64_t key_size = 0;
+    if (options->integer_size != 0)
+    {
+        key_size = (stream->sample_count + 3) / 4;
+        auto const keys_error = stream->keys.begin(content, zstd);
+        if (vbz_is_error(keys_error))
+        {
+            return keys_error;
+        }
+    }
+
+    auto data_error = stream->data.begin(content, zstd);
+    if (!vbz_is_error(data_error))
+    {
+        data_error = stream->data.skip(key_size);
+    }
+    if (vbz_is_error(data_error))
+    {
+        return data_error;
+    }
+
+    stream->begun = true;
+    return vbz_size_t(stream->sample_count);
+}
+
+vbz_size_t vbz_dstream_read_samples(
+    vbz_dstream* stream,
+    void* destination,
+    vbz_size_t sample_capacity)
+{
+    if (!stream->begun)
+    {
+        return VBZ_INPUT_SIZE_ERROR;
+    }
+
+    auto const element_size = sample_size(stream->options);
+    auto output = static_cast<char*>(destination);
+    auto remaining = std::size_t(sample_capacity) * element_size;
+    while (remaining != 0)
+    {
+        if (stream->decoded_begin == stream->decoded_end)
+        {
+            if (stream->decoded_count == stream->sample_count)
+            {
+                break;
+            }
+
+            // Whole tiles are decoded straight into the window, only a tile split between windows is buffered.
+            auto const tile_size = next_tile_size(stream);
+            auto const direct = remaining >= tile_size;
+            auto const result = decode_tile(stream, direct ? output : stream->decoded.data());
+            if (vbz_is_error(result))
+            {
+                stream->begun = false;
+                return result;
+            }
+            if (direct)
+            {
+                output += tile_size;
+                remaining -= tile_size;
+                continue;
+            }
+            stream->decoded_begin = 0;
+            stream->decoded_end = tile_size;
+        }
+
+        auto const count = std::min(remaining, stream->decoded_end - stream->decoded_begin);
+        std::memcpy(output, stream->decoded.data() + stream->decoded_begin, count);
+        stream->decoded_begin += count;
+        output += count;
+        remaining -= count;
+    }
+    return vbz_size_t((output - static_cast<char*>(destination)) / element_size);
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/// \brief Find the number of threads to use for a [thread_count] argument, where 0 means one per hardware thread.
+inline std::size_t vbz_resolve_thread_count(unsigned int thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    return thread_count;
+}
+
+/// \brief Call fn(worker_index, item_index) for each item in [0, item_count), using up to [thread_count] threads.
+///
+/// Items are handed out in order from a shared counter, so a worker which finishes early takes
+/// the next item rather than waiting. The calling thread is worker 0, and worker indexes are below
+/// [thread_count], so per worker state can be kept in an array. If threads cannot be started the
+/// remaining work runs on the workers that did start.
+/// \note [fn] must not throw.
+template <typename Fn>
+void vbz_parallel_for(std::size_t item_count, std::size_t thread_count, Fn fn)
+{
+    if (thread_count > item_count)
+    {
+        thread_count = item_count;
+    }
+
+    std::atomic<std::size_t> next_item{ 0 };
+    auto run_worker = [&](std::size_t worker_index)
+    {
+        for (auto item = next_item++; item < item_count; item = next_item++)
+        {
+            fn(worker_index, item);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t worker_index = 1; worker_index < thread_count; ++worker_index)
+    {
+        try
+        {
+            threads.emplace_back(run_worker, worker_index);
+        }
+        catch (std::exception const&)
+        {
+            break;
+        }
+    }
+
+    run_worker(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
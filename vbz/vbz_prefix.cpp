@@ -0,0 +1,162 @@
+#include "vbz_context.h"
+#include "vbz_stages.h"
+
+#include <gsl/gsl-lite.hpp>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+/// \brief Encode [reference] as zstd sees it when compressing with [options], and use it as the zstd
+///        prefix of the context's next frame.
+/// \return 0, or an error.
+vbz_size_t use_reference(
+    vbz_context* context,
+    void const* reference,
+    vbz_size_t reference_size,
+    CompressionOptions const* options)
+{
+    if (reference_size == 0 || options->zstd_compression_level == 0)
+    {
+        return 0;
+    }
+
+    auto streamvbyte_options = *options;
+    streamvbyte_options.zstd_compression_level = 0;
+    auto const max_size = vbz_max_compressed_size(reference_size, &streamvbyte_options);
+    if (vbz_is_error(max_size))
+    {
+        return max_size;
+    }
+
+    auto const storage = static_cast<char*>(context->reference.reserve(max_size));
+    if (!storage)
+    {
+        return VBZ_OUT_OF_MEMORY_ERROR;
+    }
+
+    auto const encoded_size = vbz_compress_stages(
+        context,
+        gsl::make_span(static_cast<char const*>(reference), reference_size),
+        gsl::make_span(storage, max_size),
+        &streamvbyte_options,
+        0
+    );
+    if (vbz_is_error(encoded_size))
+    {
+        return encoded_size;
+    }
+
+    context->use_zstd_prefix(gsl::make_span(storage, encoded_size));
+    return 0;
+}
+
+}
+
+extern "C" {
+
+vbz_size_t vbz_compress_sized_prefix(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size)
+{
+    vbz_context context;
+    return vbz_compress_sized_prefix_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        reference,
+        reference_size
+    );
+}
+
+vbz_size_t vbz_compress_sized_prefix_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size)
+{
+    auto const error = use_reference(context, reference, reference_size, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    auto const compressed_size = vbz_compress_sized_ctx(
+        context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+
+    // The prefix is normally taken by the zstd stage, but not if an earlier stage failed.
+    context->take_zstd_prefix();
+    return compressed_size;
+}
+
+vbz_size_t vbz_decompress_sized_prefix(
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size)
+{
+    vbz_context context;
+    return vbz_decompress_sized_prefix_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        reference,
+        reference_size
+    );
+}
+
+vbz_size_t vbz_decompress_sized_prefix_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size_t source_size,
+    void* destination,
+    vbz_size_t destination_capacity,
+    CompressionOptions const* options,
+    void const* reference,
+    vbz_size_t reference_size)
+{
+    auto const error = use_reference(context, reference, reference_size, options);
+    if (vbz_is_error(error))
+    {
+        return error;
+    }
+
+    auto const decompressed_size = vbz_decompress_sized_ctx(
+        context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+
+    context->take_zstd_prefix();
+    return decompressed_size;
+}
+
+}
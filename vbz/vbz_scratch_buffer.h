@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+
+// util for using malloc with unique_ptr.
+// This is required since a vector would throw if the size was too big.
+struct free_delete
+{
+    void operator()(void* x) { free(x); }
+};
+
+/// \brief Grow-only buffer used for intermediate results.
+///
+/// Memory is only reallocated when a request is larger than any previous request,
+/// so a buffer reused between calls reaches a steady state where no allocations are made.
+class ScratchBuffer
+{
+public:
+    /// \brief Find storage for [count] elements of type T.
+    /// \note Contents are not preserved when the buffer grows.
+    /// \return The storage, or nullptr if an allocation was required and failed.
+    template <typename T>
+    T* get(std::size_t count)
+    {
+        return static_cast<T*>(reserve(count * sizeof(T)));
+    }
+
+    /// \brief Find storage for at least [size] bytes.
+    /// \note Contents are not preserved when the buffer grows.
+    /// \return The storage, or nullptr if an allocation was required and failed.
+    void* reserve(std::size_t size)
+    {
+        if (size <= m_capacity && m_data)
+        {
+            return m_data.get();
+        }
+
+        // Avoid holding both the old and new buffers at once.
+        m_data.reset();
+        m_capacity = 0;
+
+        m_data.reset(malloc(size != 0 ? size : 1));
+        if (m_data)
+        {
+            m_capacity = size;
+        }
+        return m_data.get();
+    }
+
+    std::size_t capacity() const { return m_capacity; }
+
+private:
+    std::unique_ptr<void, free_delete> m_data;
+    std::size_t m_capacity = 0;
+};
@@ -0,0 +1,311 @@
+#include "vbz_context.h"
+#include "vbz_sized64.h"
+#include "vbz_stages.h"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// include last - it uses c headers which can mess things up.
+#include "vbz.h"
+
+namespace {
+
+// Header fields are not aligned, so are always copied in and out.
+std::uint64_t const sized64_header_size = sizeof(vbz_size_t) + sizeof(std::uint64_t) + sizeof(vbz_size_t);
+std::uint64_t const piece_header_size = sizeof(vbz_size_t);
+
+template <typename T>
+T read_value(char const* position)
+{
+    T value;
+    std::memcpy(&value, position, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void write_value(char* position, T value)
+{
+    std::memcpy(position, &value, sizeof(value));
+}
+
+/// \brief Find the largest part of [size] a 32 bit function can be given.
+vbz_size_t capped_size(vbz_size64_t size)
+{
+    return vbz_size_t(std::min<vbz_size64_t>(size, VBZ_FIRST_ERROR - 1));
+}
+
+}
+
+vbz_size64_t vbz_max_compressed_size64_pieces(
+    vbz_size64_t source_size,
+    CompressionOptions const* options,
+    vbz_size_t piece_size)
+{
+    if (source_size <= piece_size)
+    {
+        return vbz_to_size64(vbz_max_compressed_size(vbz_size_t(source_size), options));
+    }
+
+    // Includes a VbzSizedHeader, the same size as the compressed size stored before each piece.
+    auto const max_piece_size = vbz_max_compressed_size(piece_size, options);
+    if (vbz_is_error(max_piece_size))
+    {
+        return vbz_to_size64(max_piece_size);
+    }
+
+    auto const full_piece_count = source_size / piece_size;
+    auto const last_piece_size = vbz_size_t(source_size % piece_size);
+    auto const max_last_piece_size = last_piece_size != 0 ? vbz_max_compressed_size(last_piece_size, options) : 0;
+    return sized64_header_size + full_piece_count * max_piece_size + max_last_piece_size;
+}
+
+vbz_size64_t vbz_compress64_pieces(
+    vbz_context* context,
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options,
+    vbz_size_t piece_size)
+{
+    if (source_size <= piece_size)
+    {
+        return vbz_to_size64(vbz_compress_sized_ctx(
+            context,
+            source,
+            vbz_size_t(source_size),
+            destination,
+            capped_size(destination_capacity),
+            options
+        ));
+    }
+
+    // Checks the options are valid.
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return vbz_to_size64(error);
+    }
+    if (destination_capacity < sized64_header_size)
+    {
+        return vbz_to_size64(VBZ_DESTINATION_SIZE_ERROR);
+    }
+
+    auto const source_buffer = gsl::make_span(static_cast<char const*>(source), std::ptrdiff_t(source_size));
+    auto const dest_buffer = static_cast<char*>(destination);
+    write_value(dest_buffer, VBZ_SIZED64_MARKER);
+    write_value(dest_buffer + sizeof(vbz_size_t), std::uint64_t(source_size));
+    write_value(dest_buffer + sizeof(vbz_size_t) + sizeof(std::uint64_t), piece_size);
+
+    // Pieces are compressed straight from the source, only the output is split.
+    auto written = sized64_header_size;
+    for (std::uint64_t offset = 0; offset < source_size; offset += piece_size)
+    {
+        if (destination_capacity - written < piece_header_size)
+        {
+            return vbz_to_size64(VBZ_DESTINATION_SIZE_ERROR);
+        }
+
+        auto const piece_capacity = capped_size(destination_capacity - written - piece_header_size);
+        auto const compressed_size = vbz_compress_stages(
+            context,
+            source_buffer.subspan(std::ptrdiff_t(offset), std::ptrdiff_t(std::min<std::uint64_t>(piece_size, source_size - offset))),
+            gsl::make_span(dest_buffer + written + piece_header_size, piece_capacity),
+            options,
+            vbz_seed_before(source_buffer, offset, options)
+        );
+        if (vbz_is_error(compressed_size))
+        {
+            return vbz_to_size64(compressed_size);
+        }
+
+        write_value(dest_buffer + written, compressed_size);
+        written += piece_header_size + compressed_size;
+    }
+    return written;
+}
+
+extern "C" {
+
+bool vbz_is_error64(vbz_size64_t result_value)
+{
+    return result_value >= vbz_to_size64(VBZ_FIRST_ERROR);
+}
+
+vbz_size64_t vbz_max_compressed_size64(
+    vbz_size64_t source_size,
+    CompressionOptions const* options)
+{
+    return vbz_max_compressed_size64_pieces(source_size, options, VBZ_SIZED64_PIECE_SIZE);
+}
+
+vbz_size64_t vbz_compress64(
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_compress64_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size64_t vbz_compress64_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options)
+{
+    return vbz_compress64_pieces(
+        context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options,
+        VBZ_SIZED64_PIECE_SIZE
+    );
+}
+
+vbz_size64_t vbz_decompress64(
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options)
+{
+    vbz_context context;
+    return vbz_decompress64_ctx(
+        &context,
+        source,
+        source_size,
+        destination,
+        destination_capacity,
+        options
+    );
+}
+
+vbz_size64_t vbz_decompress64_ctx(
+    vbz_context* context,
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options)
+{
+    auto const source_buffer = static_cast<char const*>(source);
+    if (source_size < sizeof(vbz_size_t))
+    {
+        return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+    }
+
+    if (read_value<vbz_size_t>(source_buffer) != VBZ_SIZED64_MARKER)
+    {
+        if (source_size >= VBZ_FIRST_ERROR)
+        {
+            return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+        }
+        return vbz_to_size64(vbz_decompress_sized_ctx(
+            context,
+            source,
+            vbz_size_t(source_size),
+            destination,
+            capped_size(destination_capacity),
+            options
+        ));
+    }
+
+    // Checks the options are valid.
+    auto const error = vbz_max_compressed_size(0, options);
+    if (vbz_is_error(error))
+    {
+        return vbz_to_size64(error);
+    }
+    if (source_size < sized64_header_size)
+    {
+        return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+    }
+
+    auto const original_size = read_value<std::uint64_t>(source_buffer + sizeof(vbz_size_t));
+    auto const piece_size = read_value<vbz_size_t>(source_buffer + sizeof(vbz_size_t) + sizeof(std::uint64_t));
+    if (piece_size == 0 || piece_size % std::max(options->integer_size, 1u) != 0)
+    {
+        return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+    }
+    if (destination_capacity < original_size)
+    {
+        return vbz_to_size64(VBZ_DESTINATION_SIZE_ERROR);
+    }
+
+    auto const dest_buffer = gsl::make_span(static_cast<char*>(destination), std::ptrdiff_t(original_size));
+    auto read = sized64_header_size;
+    for (std::uint64_t offset = 0; offset < original_size; offset += piece_size)
+    {
+        if (source_size - read < piece_header_size)
+        {
+            return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+        }
+        auto const compressed_size = read_value<vbz_size_t>(source_buffer + read);
+        read += piece_header_size;
+        if (source_size - read < compressed_size)
+        {
+            return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+        }
+
+        // Earlier pieces are already decompressed, so the seed is read from the output.
+        auto const piece_length = std::min<std::uint64_t>(piece_size, original_size - offset);
+        auto const decompressed_size = vbz_decompress_stages(
+            context,
+            gsl::make_span(source_buffer + read, compressed_size),
+            dest_buffer.subspan(std::ptrdiff_t(offset), std::ptrdiff_t(piece_length)),
+            options,
+            vbz_seed_before(dest_buffer, offset, options)
+        );
+        if (vbz_is_error(decompressed_size))
+        {
+            return vbz_to_size64(decompressed_size);
+        }
+        if (decompressed_size != piece_length)
+        {
+            return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+        }
+        read += compressed_size;
+    }
+    return original_size;
+}
+
+vbz_size64_t vbz_decompressed_size64(
+    void const* source,
+    vbz_size64_t source_size,
+    CompressionOptions const* options)
+{
+    auto const source_buffer = static_cast<char const*>(source);
+    if (source_size < sizeof(vbz_size_t))
+    {
+        return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+    }
+
+    if (read_value<vbz_size_t>(source_buffer) != VBZ_SIZED64_MARKER)
+    {
+        return vbz_to_size64(vbz_decompressed_size(source, capped_size(source_size), options));
+    }
+    if (source_size < sizeof(vbz_size_t) + sizeof(std::uint64_t))
+    {
+        return vbz_to_size64(VBZ_INPUT_SIZE_ERROR);
+    }
+    return read_value<std::uint64_t>(source_buffer + sizeof(vbz_size_t));
+}
+
+}
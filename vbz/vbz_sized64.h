@@ -0,0 +1,46 @@
+#pragma once
+
+#include "vbz.h"
+
+#include <cstdint>
+
+// A 64 bit sized frame is this marker, in place of a VbzSizedHeader original size, then:
+//
+//  - the original size, as a uint64_t.
+//  - the number of bytes of input compressed into each piece, as a vbz_size_t.
+//  - each piece as its compressed size, as a vbz_size_t, then the data compressed as #vbz_compress
+//    would, with zig zag deltas continuing from the previous piece.
+//
+// #vbz_compress_sized never writes the marker as a size, so both frames can be read by #vbz_decompress64.
+constexpr vbz_size_t VBZ_SIZED64_MARKER = 0xFFFFFFFF;
+
+// Bytes of input compressed into each piece, small enough that a piece always compresses
+// to fewer bytes than a vbz_size_t can hold.
+constexpr std::uint64_t VBZ_SIZED64_PIECE_SIZE = std::uint64_t(1) << 30;
+
+/// \brief Widen a result from a 32 bit function, sign extending errors.
+inline vbz_size64_t vbz_to_size64(vbz_size_t result)
+{
+    if (vbz_is_error(result))
+    {
+        return vbz_size64_t(std::int64_t(std::int32_t(result)));
+    }
+    return result;
+}
+
+/// \brief As #vbz_compress64_ctx, storing input larger than [piece_size] bytes as pieces of [piece_size] bytes.
+/// \note Exposed so multi piece frames can be tested without gigabytes of input.
+vbz_size64_t vbz_compress64_pieces(
+    vbz_context* context,
+    void const* source,
+    vbz_size64_t source_size,
+    void* destination,
+    vbz_size64_t destination_capacity,
+    CompressionOptions const* options,
+    vbz_size_t piece_size);
+
+/// \brief Find a theoretical max size for the output of #vbz_compress64_pieces.
+vbz_size64_t vbz_max_compressed_size64_pieces(
+    vbz_size64_t source_size,
+    CompressionOptions const* options,
+    vbz_size_t piece_size);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "vbz.h"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+/// \brief Apply the streamvbyte and zstd stages enabled by [options] to [source], as #vbz_compress_ctx.
+/// \param seed The value preceding source[0], which zig zag deltas start from (0 for a whole stream).
+/// \param zstd_parameters Advanced zstd settings to apply, or null for the level's defaults.
+/// \return The size of the compressed data in bytes, or an error.
+vbz_size_t vbz_compress_stages(
+    vbz_context* context,
+    gsl::span<char const> source,
+    gsl::span<char> destination,
+    CompressionOptions const* options,
+    std::int32_t seed,
+    VbzZstdParameters const* zstd_parameters = nullptr);
+
+/// \brief Undo the stages applied by #vbz_compress_stages, as #vbz_decompress_ctx.
+/// \param seed The seed [source] was compressed with.
+/// \return The size of the decompressed data in bytes, or an error.
+vbz_size_t vbz_decompress_stages(
+    vbz_context* context,
+    gsl::span<char const> source,
+    gsl::span<char> destination,
+    CompressionOptions const* options,
+    std::int32_t seed);
+
+/// \brief Find the seed to compress data starting at byte [offset] of [data] with, as part of a longer stream.
+/// \return The integer preceding [offset], or 0 when there is none or [options] do not use zig zag deltas.
+inline std::int32_t vbz_seed_before(
+    gsl::span<char const> data,
+    std::uint64_t offset,
+    CompressionOptions const* options)
+{
+    if (offset == 0 || options->integer_size == 0 || !options->perform_delta_zig_zag)
+    {
+        return 0;
+    }
+
+    auto const position = data.data() + offset - options->integer_size;
+    switch (options->integer_size)
+    {
+        case 1:
+        {
+            std::int8_t value;
+            std::memcpy(&value, position, sizeof(value));
+            return value;
+        }
+        case 2:
+        {
+            std::int16_t value;
+            std::memcpy(&value, position, sizeof(value));
+            return value;
+        }
+        default:
+        {
+            std::int32_t value;
+            std::memcpy(&value, position, sizeof(value));
+            return value;
+        }
+    }
+}
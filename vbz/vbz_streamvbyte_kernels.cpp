@@ -0,0 +1,87 @@
+#include "vbz_streamvbyte_kernels.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+struct KernelTier
+{
+    char const* name;
+    StreamVByteKernels const& (*kernels)();
+};
+
+// Fastest first. Names are kept here, so tiers can be chosen without running code built for them.
+KernelTier const kernel_tiers[] = {
+#ifdef VBZ_HAVE_AVX2_KERNELS
+    { "avx2", vbz_streamvbyte_kernels_avx2 },
+#endif
+#ifdef VBZ_HAVE_SSSE3_KERNELS
+    { "ssse3", vbz_streamvbyte_kernels_ssse3 },
+#endif
+    { "scalar", vbz_streamvbyte_kernels_scalar },
+};
+
+}
+
+bool vbz_cpu_supports(char const* instruction_set)
+{
+    if (std::strcmp(instruction_set, "scalar") == 0)
+    {
+        return true;
+    }
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    // Also checks the OS saves the AVX registers.
+    if (std::strcmp(instruction_set, "ssse3") == 0)
+    {
+        return __builtin_cpu_supports("ssse3");
+    }
+    if (std::strcmp(instruction_set, "avx2") == 0)
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return false;
+}
+
+char const* vbz_select_streamvbyte_kernels(char const* forced_name, bool (*cpu_supports)(char const* instruction_set))
+{
+    if (forced_name)
+    {
+        for (auto const& tier : kernel_tiers)
+        {
+            if (std::strcmp(forced_name, tier.name) == 0 && cpu_supports(tier.name))
+            {
+                return tier.name;
+            }
+        }
+    }
+
+    for (auto const& tier : kernel_tiers)
+    {
+        if (cpu_supports(tier.name))
+        {
+            return tier.name;
+        }
+    }
+    return "scalar";
+}
+
+StreamVByteKernels const& vbz_streamvbyte_kernels_named(char const* name)
+{
+    for (auto const& tier : kernel_tiers)
+    {
+        if (std::strcmp(name, tier.name) == 0)
+        {
+            return tier.kernels();
+        }
+    }
+    return vbz_streamvbyte_kernels_scalar();
+}
+
+StreamVByteKernels const& vbz_streamvbyte_kernels()
+{
+    static StreamVByteKernels const& kernels = vbz_streamvbyte_kernels_named(
+        vbz_select_streamvbyte_kernels(std::getenv("VBZ_FORCE_ISA"), vbz_cpu_supports));
+    return kernels;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "vbz.h"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cstdint>
+
+// The streamvbyte workers are compiled once per instruction set, in the
+// vbz_streamvbyte_kernels_<isa>.cpp files, each built with its own compiler flags.
+// The worker headers put everything in an anonymous namespace, so each of those
+// translation units keeps its own copy, and code built for a newer instruction set
+// can never be linked into an older one. The fastest set the CPU supports is picked
+// once, at first use.
+
+/// \brief Compress or decompress one stream using a streamvbyte worker.
+///
+/// [seed] is the value preceding the first value of the stream, and must fit in the integer size
+/// of the stream. Zig zag deltas start from it, so streams compressed with a seed must be
+/// decompressed with the same seed.
+using StreamVByteKernelFn = vbz_size_t(*)(gsl::span<char const> input, gsl::span<char> output, std::int32_t seed);
+
+/// \brief Conversion applied to each value decoded to float: (value + offset) * scale.
+struct StreamVByteCalibration
+{
+    float offset;
+    float scale;
+};
+
+/// \brief Decompress one stream, converting values to calibrated floats as they are decoded.
+/// \return The size of the output in bytes, or an error.
+using StreamVByteFloatKernelFn = vbz_size_t(*)(
+    gsl::span<char const> input,
+    gsl::span<float> output,
+    StreamVByteCalibration calibration,
+    std::int32_t seed);
+
+/// \brief Decompress one stream, widening values to int32 as they are decoded.
+/// \return The size of the output in bytes, or an error.
+using StreamVByteInt32KernelFn = vbz_size_t(*)(
+    gsl::span<char const> input,
+    gsl::span<std::int32_t> output,
+    std::int32_t seed);
+
+/// \brief Streamvbyte workers compiled for one instruction set.
+///
+/// Tables are indexed by [#streamvbyte_kernel_index(integer_size)][use_delta_zig_zag_encoding].
+struct StreamVByteKernels
+{
+    char const* name;
+    StreamVByteKernelFn compress_v0[3][2];
+    StreamVByteKernelFn decompress_v0[3][2];
+    StreamVByteKernelFn compress_v1[3][2];
+    StreamVByteKernelFn decompress_v1[3][2];
+    StreamVByteFloatKernelFn decompress_float_v0[3][2];
+    StreamVByteFloatKernelFn decompress_float_v1[3][2];
+    StreamVByteInt32KernelFn decompress_int32_v0[3][2];
+    StreamVByteInt32KernelFn decompress_int32_v1[3][2];
+};
+
+/// \brief Find the index of [integer_size] in the StreamVByteKernels tables.
+/// \return The index, or -1 if the integer size is not supported.
+inline int streamvbyte_kernel_index(int integer_size)
+{
+    switch (integer_size)
+    {
+        case 1: return 0;
+        case 2: return 1;
+        case 4: return 2;
+        default: return -1;
+    }
+}
+
+/// \brief Find the fastest streamvbyte kernels the CPU supports.
+///
+/// Setting the environment variable VBZ_FORCE_ISA to "scalar", "ssse3" or "avx2" selects that
+/// instruction set instead, if it is built and supported, so each can be tested on one machine.
+StreamVByteKernels const& vbz_streamvbyte_kernels();
+
+/// \brief Check if the CPU supports the instruction set named [instruction_set], as "scalar", "ssse3" or "avx2".
+bool vbz_cpu_supports(char const* instruction_set);
+
+/// \brief Find the name of the kernels #vbz_streamvbyte_kernels uses.
+///
+/// Only names are compared, so no code built for an instruction set the CPU lacks is run.
+/// \param forced_name   The instruction set to use if it is built and supported, or null.
+/// \param cpu_supports  Checks if the CPU supports an instruction set, see #vbz_cpu_supports.
+char const* vbz_select_streamvbyte_kernels(char const* forced_name, bool (*cpu_supports)(char const* instruction_set));
+
+/// \brief Find the kernels named [name], or the scalar kernels if they are not built.
+/// \note Runs code built for that instruction set, which the CPU must support.
+StreamVByteKernels const& vbz_streamvbyte_kernels_named(char const* name);
+
+/// \brief Find the kernels for one instruction set.
+/// \note Only the instruction sets enabled in the build are defined (see VBZ_HAVE_*_KERNELS).
+StreamVByteKernels const& vbz_streamvbyte_kernels_scalar();
+StreamVByteKernels const& vbz_streamvbyte_kernels_ssse3();
+StreamVByteKernels const& vbz_streamvbyte_kernels_avx2();
@@ -0,0 +1,11 @@
+#include "vbz_streamvbyte_kernels_impl.h"
+
+#ifndef __AVX2__
+#error "vbz_streamvbyte_kernels_avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+StreamVByteKernels const& vbz_streamvbyte_kernels_avx2()
+{
+    static StreamVByteKernels const kernels = make_streamvbyte_kernels("avx2");
+    return kernels;
+}
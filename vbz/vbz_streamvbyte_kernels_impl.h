@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vbz_streamvbyte_kernels.h"
+
+#include "v0/vbz_streamvbyte_impl.h"
+#include "v1/vbz_streamvbyte_impl.h"
+
+#include <cstdint>
+
+namespace {
+
+/// \brief Decompress with [Worker], converting values decoded as T to calibrated floats.
+template <typename Worker, typename T>
+vbz_size_t decompress_float(
+    gsl::span<char const> input,
+    gsl::span<float> output,
+    StreamVByteCalibration calibration,
+    std::int32_t seed)
+{
+    auto const converted = ConvertedOutput<T, CalibrateToFloat>{
+        output.data(),
+        CalibrateToFloat{ calibration.offset, calibration.scale }
+    };
+    return decompressed_bytes<float>(Worker::decompress_to(input, output.size(), converted, seed));
+}
+
+/// \brief Decompress with [Worker], widening values decoded as T to int32.
+template <typename Worker, typename T>
+vbz_size_t decompress_int32(gsl::span<char const> input, gsl::span<std::int32_t> output, std::int32_t seed)
+{
+    auto const converted = ConvertedOutput<T, WidenToInt32>{ output.data(), WidenToInt32{} };
+    return decompressed_bytes<std::int32_t>(Worker::decompress_to(input, output.size(), converted, seed));
+}
+
+/// \brief Build the kernel table from the workers available to the current translation unit.
+StreamVByteKernels make_streamvbyte_kernels(char const* name)
+{
+    return StreamVByteKernels{
+        name,
+        {
+            { StreamVByteWorkerV0<std::int8_t, false>::compress, StreamVByteWorkerV0<std::int8_t, true>::compress },
+            { StreamVByteWorkerV0<std::int16_t, false>::compress, StreamVByteWorkerV0<std::int16_t, true>::compress },
+            { StreamVByteWorkerV0<std::int32_t, false>::compress, StreamVByteWorkerV0<std::int32_t, true>::compress },
+        },
+        {
+            { StreamVByteWorkerV0<std::int8_t, false>::decompress, StreamVByteWorkerV0<std::int8_t, true>::decompress },
+            { StreamVByteWorkerV0<std::int16_t, false>::decompress, StreamVByteWorkerV0<std::int16_t, true>::decompress },
+            { StreamVByteWorkerV0<std::int32_t, false>::decompress, StreamVByteWorkerV0<std::int32_t, true>::decompress },
+        },
+        // Integers larger than 1 byte have been shown to perform better (with zstd) when using version 0 compression
+        // likely the increased noise in the key section reduces compression efficiency negating the benefits of
+        // compressing 1 byte values into halfs.
+        {
+            { StreamVByteWorkerV1<std::int8_t, false>::compress, StreamVByteWorkerV1<std::int8_t, true>::compress },
+            { StreamVByteWorkerV0<std::int16_t, false>::compress, StreamVByteWorkerV0<std::int16_t, true>::compress },
+            { StreamVByteWorkerV0<std::int32_t, false>::compress, StreamVByteWorkerV0<std::int32_t, true>::compress },
+        },
+        {
+            { StreamVByteWorkerV1<std::int8_t, false>::decompress, StreamVByteWorkerV1<std::int8_t, true>::decompress },
+            { StreamVByteWorkerV0<std::int16_t, false>::decompress, StreamVByteWorkerV0<std::int16_t, true>::decompress },
+            { StreamVByteWorkerV0<std::int32_t, false>::decompress, StreamVByteWorkerV0<std::int32_t, true>::decompress },
+        },
+        {
+            { decompress_float<StreamVByteWorkerV0<std::int8_t, false>, std::int8_t>, decompress_float<StreamVByteWorkerV0<std::int8_t, true>, std::int8_t> },
+            { decompress_float<StreamVByteWorkerV0<std::int16_t, false>, std::int16_t>, decompress_float<StreamVByteWorkerV0<std::int16_t, true>, std::int16_t> },
+            { decompress_float<StreamVByteWorkerV0<std::int32_t, false>, std::int32_t>, decompress_float<StreamVByteWorkerV0<std::int32_t, true>, std::int32_t> },
+        },
+        {
+            { decompress_float<StreamVByteWorkerV1<std::int8_t, false>, std::int8_t>, decompress_float<StreamVByteWorkerV1<std::int8_t, true>, std::int8_t> },
+            { decompress_float<StreamVByteWorkerV0<std::int16_t, false>, std::int16_t>, decompress_float<StreamVByteWorkerV0<std::int16_t, true>, std::int16_t> },
+            { decompress_float<StreamVByteWorkerV0<std::int32_t, false>, std::int32_t>, decompress_float<StreamVByteWorkerV0<std::int32_t, true>, std::int32_t> },
+        },
+        {
+            { decompress_int32<StreamVByteWorkerV0<std::int8_t, false>, std::int8_t>, decompress_int32<StreamVByteWorkerV0<std::int8_t, true>, std::int8_t> },
+            { decompress_int32<StreamVByteWorkerV0<std::int16_t, false>, std::int16_t>, decompress_int32<StreamVByteWorkerV0<std::int16_t, true>, std::int16_t> },
+            { decompress_int32<StreamVByteWorkerV0<std::int32_t, false>, std::int32_t>, decompress_int32<StreamVByteWorkerV0<std::int32_t, true>, std::int32_t> },
+        },
+        {
+            { decompress_int32<StreamVByteWorkerV1<std::int8_t, false>, std::int8_t>, decompress_int32<StreamVByteWorkerV1<std::int8_t, true>, std::int8_t> },
+            { decompress_int32<StreamVByteWorkerV0<std::int16_t, false>, std::int16_t>, decompress_int32<StreamVByteWorkerV0<std::int16_t, true>, std::int16_t> },
+            { decompress_int32<StreamVByteWorkerV0<std::int32_t, false>, std::int32_t>, decompress_int32<StreamVByteWorkerV0<std::int32_t, true>, std::int32_t> },
+        },
+    };
+}
+
+}
@@ -0,0 +1,8 @@
+// Built without any instruction set flags, so runs on every CPU.
+#include "vbz_streamvbyte_kernels_impl.h"
+
+StreamVByteKernels const& vbz_streamvbyte_kernels_scalar()
+{
+    static StreamVByteKernels const kernels = make_streamvbyte_kernels("scalar");
+    return kernels;
+}
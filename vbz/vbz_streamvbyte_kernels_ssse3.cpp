@@ -0,0 +1,11 @@
+#include "vbz_streamvbyte_kernels_impl.h"
+
+#ifndef __SSSE3__
+#error "vbz_streamvbyte_kernels_ssse3.cpp must be compiled with SSSE3 enabled"
+#endif
+
+StreamVByteKernels const& vbz_streamvbyte_kernels_ssse3()
+{
+    static StreamVByteKernels const kernels = make_streamvbyte_kernels("ssse3");
+    return kernels;
+}
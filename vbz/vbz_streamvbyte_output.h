@@ -0,0 +1,220 @@
+#pragma once
+
+#include "vbz.h"
+#include "vbz_streamvbyte_tile.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Kept internal to each kernel translation unit, see vbz_streamvbyte_kernels.h.
+namespace {
+
+// Decompression workers write decoded values through an output, so values can be converted
+// while they are still in registers, instead of in a second pass over memory. Each output
+// stores values which have been decoded as T:
+//
+//  - store_tile: [count] streamvbyte values from a tile, undoing #to_streamvbyte_values.
+//  - store_lanes: a register of values in T sized lanes.
+//  - store_int32_lanes: 8 values held in the low bits of the 32 bit lanes of two registers.
+
+/// \brief Find the size in bytes of the values a worker's decompress_to decoded, passing errors through.
+template <typename OutputType>
+inline vbz_size_t decompressed_bytes(vbz_size_t decoded_count)
+{
+    if (decoded_count >= VBZ_FIRST_ERROR)
+    {
+        return decoded_count;
+    }
+    return vbz_size_t(decoded_count * sizeof(OutputType));
+}
+
+/// \brief Writes decoded values unchanged.
+template <typename T>
+struct IntegerOutput
+{
+    T* data;
+
+    template <bool UseZigZag>
+    void store_tile(std::size_t index, std::uint32_t const* tile, std::size_t count, std::uint32_t& previous)
+    {
+        from_streamvbyte_values<UseZigZag>(tile, data + index, count, previous);
+    }
+
+#ifdef __SSE2__
+    void store_lanes(std::size_t index, __m128i values)
+    {
+        _mm_storeu_si128((__m128i*)(data + index), values);
+    }
+
+    void store_int32_lanes(std::size_t index, __m128i low, __m128i high)
+    {
+        store_truncated(low, data + index);
+        store_truncated(high, data + index + 4);
+    }
+#endif
+
+#ifdef __AVX2__
+    void store_lanes(std::size_t index, __m256i values)
+    {
+        _mm256_storeu_si256((__m256i*)(data + index), values);
+    }
+#endif
+};
+
+/// \brief Converts values to float32 picoamps, as (value + offset) * scale.
+struct CalibrateToFloat
+{
+    using value_type = float;
+
+    float offset;
+    float scale;
+
+    float operator()(std::int32_t value) const
+    {
+        return (float(value) + offset) * scale;
+    }
+
+#ifdef __SSE2__
+    void store(__m128i values, float* output) const
+    {
+        auto const converted = _mm_add_ps(_mm_cvtepi32_ps(values), _mm_set1_ps(offset));
+        _mm_storeu_ps(output, _mm_mul_ps(converted, _mm_set1_ps(scale)));
+    }
+#endif
+
+#ifdef __AVX2__
+    void store(__m256i values, float* output) const
+    {
+        auto const converted = _mm256_add_ps(_mm256_cvtepi32_ps(values), _mm256_set1_ps(offset));
+        _mm256_storeu_ps(output, _mm256_mul_ps(converted, _mm256_set1_ps(scale)));
+    }
+#endif
+};
+
+/// \brief Converts values to int32.
+struct WidenToInt32
+{
+    using value_type = std::int32_t;
+
+    std::int32_t operator()(std::int32_t value) const
+    {
+        return value;
+    }
+
+#ifdef __SSE2__
+    void store(__m128i values, std::int32_t* output) const
+    {
+        _mm_storeu_si128((__m128i*)output, values);
+    }
+#endif
+
+#ifdef __AVX2__
+    void store(__m256i values, std::int32_t* output) const
+    {
+        _mm256_storeu_si256((__m256i*)output, values);
+    }
+#endif
+};
+
+#ifdef __SSE2__
+/// \brief Sign extend the low sizeof(T) bytes of each 32 bit lane.
+template <typename T>
+inline __m128i sign_extend_int32_lanes(__m128i values)
+{
+    if (sizeof(T) == 4)
+    {
+        return values;
+    }
+    auto const shift = int(32 - 8 * sizeof(T));
+    return _mm_srai_epi32(_mm_slli_epi32(values, shift), shift);
+}
+#endif
+
+/// \brief Writes decoded values converted by [Converter], for example to calibrated floats.
+template <typename T, typename Converter>
+struct ConvertedOutput
+{
+    typename Converter::value_type* data;
+    Converter convert;
+
+    template <bool UseZigZag>
+    void store_tile(std::size_t index, std::uint32_t const* tile, std::size_t count, std::uint32_t& previous)
+    {
+        // Narrow to T first, so values wrap exactly as they do when decoding to integers.
+        std::array<T, STREAMVBYTE_TILE_SIZE> values;
+        from_streamvbyte_values<UseZigZag>(tile, values.data(), count, previous);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            data[index + i] = convert(values[i]);
+        }
+    }
+
+#ifdef __SSE2__
+    void store_lanes(std::size_t index, __m128i values)
+    {
+        if (sizeof(T) == 4)
+        {
+            convert.store(values, data + index);
+            return;
+        }
+
+        __m128i low_shorts = values;
+        __m128i high_shorts = values;
+        if (sizeof(T) == 1)
+        {
+            low_shorts = _mm_srai_epi16(_mm_unpacklo_epi8(values, values), 8);
+            high_shorts = _mm_srai_epi16(_mm_unpackhi_epi8(values, values), 8);
+        }
+
+        convert.store(_mm_srai_epi32(_mm_unpacklo_epi16(low_shorts, low_shorts), 16), data + index);
+        convert.store(_mm_srai_epi32(_mm_unpackhi_epi16(low_shorts, low_shorts), 16), data + index + 4);
+        if (sizeof(T) == 1)
+        {
+            convert.store(_mm_srai_epi32(_mm_unpacklo_epi16(high_shorts, high_shorts), 16), data + index + 8);
+            convert.store(_mm_srai_epi32(_mm_unpackhi_epi16(high_shorts, high_shorts), 16), data + index + 12);
+        }
+    }
+
+    void store_int32_lanes(std::size_t index, __m128i low, __m128i high)
+    {
+        convert.store(sign_extend_int32_lanes<T>(low), data + index);
+        convert.store(sign_extend_int32_lanes<T>(high), data + index + 4);
+    }
+#endif
+
+#ifdef __AVX2__
+    void store_lanes(std::size_t index, __m256i values)
+    {
+        if (sizeof(T) == 4)
+        {
+            convert.store(values, data + index);
+            return;
+        }
+
+        auto const low = _mm256_castsi256_si128(values);
+        auto const high = _mm256_extracti128_si256(values, 1);
+        if (sizeof(T) == 2)
+        {
+            convert.store(_mm256_cvtepi16_epi32(low), data + index);
+            convert.store(_mm256_cvtepi16_epi32(high), data + index + 8);
+            return;
+        }
+
+        convert.store(_mm256_cvtepi8_epi32(low), data + index);
+        convert.store(_mm256_cvtepi8_epi32(_mm_srli_si128(low, 8)), data + index + 8);
+        convert.store(_mm256_cvtepi8_epi32(high), data + index + 16);
+        convert.store(_mm256_cvtepi8_epi32(_mm_srli_si128(high, 8)), data + index + 24);
+    }
+#endif
+};
+
+} // namespace
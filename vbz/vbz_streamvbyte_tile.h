@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Kept internal to each kernel translation unit, see vbz_streamvbyte_kernels.h.
+namespace {
+
+/// \brief Number of integers the generic streamvbyte workers convert at once.
+///
+/// One tile of 32 bit values (4KB) stays in L1 between converting the input and encoding it,
+/// so no copy of the whole input is ever made. Must be a multiple of 4 so each tile starts on
+/// a key byte boundary.
+static constexpr std::size_t STREAMVBYTE_TILE_SIZE = 1024;
+
+/// \brief Sum the sizes coded by the 32 keys packed into [keys], in data units.
+///
+/// Codes 0, 1, 2 and 3 take 0, 1, 2 and 4 nibbles in the v1 int8 format ([nibbles] set), otherwise
+/// they are the bytes each value uses beyond its first. Sums the code bits across the word without
+/// unpacking them, counting the high bit twice, and once more for code 3 nibbles.
+inline std::size_t streamvbyte_code_units(std::uint64_t keys, bool nibbles)
+{
+    auto const low = keys & 0x5555555555555555ull;
+    auto const high = (keys >> 1) & 0x5555555555555555ull;
+    auto const pairs = low + high;
+    auto const high_pairs = nibbles ? high + (low & high) : high;
+
+    auto sums = (pairs & 0x3333333333333333ull) + ((pairs >> 2) & 0x3333333333333333ull)
+        + (high_pairs & 0x3333333333333333ull) + ((high_pairs >> 2) & 0x3333333333333333ull);
+    sums = (sums & 0x0F0F0F0F0F0F0F0Full) + ((sums >> 4) & 0x0F0F0F0F0F0F0F0Full);
+    return std::size_t((sums * 0x0101010101010101ull) >> 56);
+}
+
+/// \brief Count the data units (bytes, or nibbles when [nibbles] is set) used by [count] values,
+///        from the keys at [key_ptr].
+inline std::size_t streamvbyte_data_units(std::uint8_t const* key_ptr, std::size_t count, bool nibbles)
+{
+    // Every value uses at least one byte, but may use no nibbles.
+    std::size_t units = nibbles ? 0 : count;
+    std::size_t key_index = 0;
+    for (; key_index + 8 <= count / 4; key_index += 8)
+    {
+        std::uint64_t keys = 0;
+        std::memcpy(&keys, key_ptr + key_index, sizeof(keys));
+        units += streamvbyte_code_units(keys, nibbles);
+    }
+
+    // At most 31 values remain, ignore any unused codes in the final key byte.
+    if (key_index * 4 >= count)
+    {
+        return units;
+    }
+    std::uint64_t keys = 0;
+    std::memcpy(&keys, key_ptr + key_index, (count + 3) / 4 - key_index);
+    keys &= (std::uint64_t(1) << (2 * (count - key_index * 4))) - 1;
+    return units + streamvbyte_code_units(keys, nibbles);
+}
+
+/// \brief Widen [count] integers from [input] into the unsigned values streamvbyte encodes.
+///
+/// When UseZigZag is set, deltas are taken after widening to 32 bits, then zig zag encoded.
+/// int16 deltas are wrapped back to 16 bits first, as the SIMD int16 kernels take them, so
+/// every kernel tier writes the same stream. Decoding truncates to T, so either round trips.
+/// \param previous The value preceding input[0] (widened), updated to the last value converted.
+template <bool UseZigZag, typename T>
+inline void to_streamvbyte_values(T const* input, std::uint32_t* output, std::size_t count, std::uint32_t& previous)
+{
+    if (!UseZigZag)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            output[i] = std::uint32_t(input[i]);
+        }
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto const value = std::uint32_t(input[i]);
+        auto delta = value - previous;
+        if (sizeof(T) == 2)
+        {
+            delta = std::uint32_t(std::int32_t(std::int16_t(delta)));
+        }
+        output[i] = (delta << 1) ^ (0u - (delta >> 31));
+        previous = value;
+    }
+}
+
+#ifdef __SSE2__
+/// \brief Store the 4 32 bit lanes of [values], truncated to T.
+template <typename T>
+inline void store_truncated(__m128i values, T* output)
+{
+    // Sign extend from the top bit kept first, so the saturating packs leave the kept bits unchanged.
+    if (sizeof(T) == 4)
+    {
+        _mm_storeu_si128((__m128i*)output, values);
+    }
+    else if (sizeof(T) == 2)
+    {
+        auto const narrowed = _mm_srai_epi32(_mm_slli_epi32(values, 16), 16);
+        _mm_storel_epi64((__m128i*)output, _mm_packs_epi32(narrowed, narrowed));
+    }
+    else
+    {
+        auto narrowed = _mm_srai_epi32(_mm_slli_epi32(values, 24), 24);
+        narrowed = _mm_packs_epi32(narrowed, narrowed);
+        auto const bytes = _mm_cvtsi128_si32(_mm_packs_epi16(narrowed, narrowed));
+        std::memcpy(output, &bytes, sizeof(bytes));
+    }
+}
+#endif
+
+/// \brief Narrow [count] values decoded by streamvbyte back into integers, undoing #to_streamvbyte_values.
+/// \param previous The value preceding output[0] (widened), updated to the last value written.
+template <bool UseZigZag, typename T>
+inline void from_streamvbyte_values(std::uint32_t const* input, T* output, std::size_t count, std::uint32_t& previous)
+{
+    if (!UseZigZag)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            output[i] = T(input[i]);
+        }
+        return;
+    }
+
+    std::size_t i = 0;
+#ifdef __SSE2__
+    // Summing one value at a time is a serial dependency, instead prefix sum 4 deltas in
+    // log2(4) shift and add steps, then add the running total.
+    auto const zero = _mm_setzero_si128();
+    auto const one = _mm_set1_epi32(1);
+    auto running = _mm_set1_epi32(std::int32_t(previous));
+    for (; i + 4 <= count; i += 4)
+    {
+        auto values = _mm_loadu_si128((__m128i const*)(input + i));
+        values = _mm_xor_si128(_mm_srli_epi32(values, 1), _mm_sub_epi32(zero, _mm_and_si128(values, one)));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        values = _mm_add_epi32(values, running);
+        running = _mm_shuffle_epi32(values, 0xFF);
+        store_truncated(values, output + i);
+    }
+    previous = std::uint32_t(_mm_cvtsi128_si32(running));
+#endif
+
+    for (; i < count; ++i)
+    {
+        auto const zig_zag = input[i];
+        previous += (zig_zag >> 1) ^ (0u - (zig_zag & 1));
+        output[i] = T(previous);
+    }
+}
+
+} // namespace
@@ -3,11 +3,14 @@
 
 #include "hdf_id_helper.h"
 #include "vbz_plugin.h"
+#include "vbz_plugin_parallel_utils.h"
 #include "vbz_plugin_user_utils.h"
 
 #include <hdf5.h>
 
 #include <array>
+#include <cstdlib>
+#include <cstring>
 
 #include <benchmark/benchmark.h>
 
@@ -141,6 +144,220 @@ void vbz_hdf_benchmark_random_zlib(benchmark::State& state)
     vbz_hdf_benchmark<SignalGenerator<IntType>>(state, sizeof(IntType), get_h5_type<IntType>(), zlib_filter);
 }
 
+#if H5_VERSION_GE(1, 10, 3)
+// Writes one vbz dataset per read, with the read as its only chunk.
+// range(0) selects whether chunks are written through the filter with H5Dwrite, or compressed outside
+// of HDF5 with vbz_write_chunks_parallel.
+// range(1) is the number of threads vbz_write_chunks_parallel compresses with, or 0 for one per hardware thread.
+template <typename Generator>
+void vbz_hdf_write_chunks_benchmark(benchmark::State& state, int integer_size, hid_t h5_type)
+{
+    (void)plugin_init_result;
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+    auto const write_directly = state.range(0) != 0;
+    auto const thread_count = unsigned(state.range(1));
+
+    std::array<hsize_t, 1> const offset{ { 0 } };
+    std::size_t item_count = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<IdRef> datasets;
+        std::size_t id = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+            std::array<hsize_t, 1> chunk_sizes{ { input_values.size() } };
+            H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+            vbz_filter_enable(creation_properties.get(), integer_size, true, 1);
+
+            std::string dset_name = std::to_string(id++);
+            datasets.push_back(create_dataset(file_id, dset_name.c_str(), h5_type, input_values.size(), creation_properties.get()));
+        }
+        state.ResumeTiming();
+
+        item_count = 0;
+        std::vector<VbzChunkWrite> chunks;
+        for (std::size_t i = 0; i < input_value_list.size(); ++i)
+        {
+            auto const& input_values = input_value_list[i];
+            if (write_directly)
+            {
+                chunks.push_back({ datasets[i].get(), offset.data(), input_values.data(), input_values.size() * integer_size });
+            }
+            else
+            {
+                auto val = write_full_dataset(datasets[i].get(), h5_type, input_values);
+                benchmark::DoNotOptimize(val);
+            }
+            item_count += input_values.size();
+        }
+        if (write_directly)
+        {
+            auto val = vbz_write_chunks_parallel(chunks.data(), chunks.size(), thread_count);
+            benchmark::DoNotOptimize(val);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * integer_size);
+}
+
+template <typename IntType>
+void vbz_hdf_write_chunks_benchmark_random(benchmark::State& state)
+{
+    vbz_hdf_write_chunks_benchmark<SignalGenerator<IntType>>(state, sizeof(IntType), get_h5_type<IntType>());
+}
+#endif
+
+#if H5_VERSION_GE(1, 10, 5) && !defined(_WIN32)
+// Reads back one vbz dataset per read, with the read as its only chunk.
+// range(0) selects whether chunks are read through the filter with H5Dread, or read and decompressed
+// outside of HDF5 with vbz_read_chunks_parallel, using an index of the chunks made before timing starts.
+// range(1) is the number of threads vbz_read_chunks_parallel reads with, or 0 for one per hardware thread.
+template <typename Generator>
+void vbz_hdf_read_chunks_benchmark(benchmark::State& state, int integer_size, hid_t h5_type)
+{
+    (void)plugin_init_result;
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+    auto const read_directly = state.range(0) != 0;
+    auto const thread_count = unsigned(state.range(1));
+
+    std::size_t item_count = 0;
+    {
+        auto file = IdRef::claim(H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT));
+        std::size_t id = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+            std::array<hsize_t, 1> chunk_sizes{ { input_values.size() } };
+            H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+            vbz_filter_enable(creation_properties.get(), integer_size, true, 1);
+
+            std::string dset_name = std::to_string(id++);
+            auto dataset = create_dataset(file.get(), dset_name.c_str(), h5_type, input_values.size(), creation_properties.get());
+            write_full_dataset(dataset.get(), h5_type, input_values);
+            item_count += input_values.size();
+        }
+    }
+
+    // Without a chunk cache, H5Dread decompresses every chunk on every iteration, as a first read does.
+    auto access_properties = IdRef::claim(H5Pcreate(H5P_DATASET_ACCESS));
+    H5Pset_chunk_cache(access_properties.get(), 0, 0, 1);
+
+    auto file = IdRef::claim(H5Fopen("./test_file.h5", H5F_ACC_RDONLY, H5P_DEFAULT));
+    std::vector<IdRef> datasets;
+    VbzChunkIndex index;
+    for (std::size_t id = 0; id < input_value_list.size(); ++id)
+    {
+        datasets.push_back(IdRef::claim(H5Dopen(file.get(), std::to_string(id).c_str(), access_properties.get())));
+        vbz_index_chunks(datasets.back().get(), &index);
+    }
+
+    std::vector<std::vector<char>> output(input_value_list.size());
+    std::vector<VbzChunkRead> reads;
+    for (std::size_t i = 0; i < input_value_list.size(); ++i)
+    {
+        output[i].resize(input_value_list[i].size() * integer_size);
+        reads.push_back({ i, output[i].data(), output[i].size() });
+    }
+
+    for (auto _ : state)
+    {
+        if (read_directly)
+        {
+            auto val = vbz_read_chunks_parallel(index, reads.data(), reads.size(), thread_count);
+            benchmark::DoNotOptimize(val);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < datasets.size(); ++i)
+            {
+                auto val = H5Dread(datasets[i].get(), h5_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, output[i].data());
+                benchmark::DoNotOptimize(val);
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * integer_size);
+}
+
+template <typename IntType>
+void vbz_hdf_read_chunks_benchmark_random(benchmark::State& state)
+{
+    vbz_hdf_read_chunks_benchmark<SignalGenerator<IntType>>(state, sizeof(IntType), get_h5_type<IntType>());
+}
+#endif
+
+// Calls the filter directly, as HDF5 does for each chunk, compressing then decompressing every read.
+// range(0) selects whether the filter's cached state is kept between chunks, or released after each.
+// range(1) is the block size to split chunks into, or 0 to compress chunks whole.
+template <typename Generator>
+void vbz_filter_benchmark(benchmark::State& state, int integer_size)
+{
+    std::size_t max_element_count = 0;
+    auto input_value_list = Generator::generate(max_element_count);
+    auto const keep_cache = state.range(0) != 0;
+    auto const block_size = state.range(1);
+
+    auto const filter = static_cast<H5Z_class2_t const*>(vbz_plugin_info())->filter;
+    std::array<unsigned int, FILTER_VBZ_OPTION_COUNT> cd_values{ { FILTER_VBZ_VERSION, unsigned(integer_size), 1, 1 } };
+    cd_values[FILTER_VBZ_BLOCK_SIZE_OPTION] = unsigned(block_size);
+
+    std::size_t item_count = 0;
+    std::size_t held_bytes = 0;
+    for (auto _ : state)
+    {
+        item_count = 0;
+        held_bytes = 0;
+        for (auto const& input_values : input_value_list)
+        {
+            // HDF5 owns the chunk buffer, and the filter replaces it.
+            auto buf_size = input_values.size() * integer_size;
+            void* buf = malloc(buf_size);
+            std::memcpy(buf, input_values.data(), buf_size);
+
+            auto const compressed_size = filter(0, cd_values.size(), cd_values.data(), buf_size, &buf_size, &buf);
+            held_bytes += buf_size;
+
+            // HDF5 reads back only the compressed bytes.
+            buf_size = compressed_size;
+            auto const decompressed_size = filter(H5Z_FLAG_REVERSE, cd_values.size(), cd_values.data(), compressed_size, &buf_size, &buf);
+            free(buf);
+            if (!keep_cache)
+            {
+                vbz_plugin_release_cache();
+            }
+
+            item_count += input_values.size();
+            benchmark::DoNotOptimize(decompressed_size);
+        }
+    }
+
+    // Size of the buffers HDF5 holds for compressed chunks, relative to the chunks.
+    state.counters["held_ratio"] = double(held_bytes) / double(item_count * integer_size);
+    state.SetItemsProcessed(state.iterations() * item_count);
+    state.SetBytesProcessed(state.iterations() * item_count * integer_size);
+}
+
+template <typename IntType>
+void vbz_filter_benchmark_short_reads(benchmark::State& state)
+{
+    vbz_filter_benchmark<ShortReadGenerator<IntType>>(state, sizeof(IntType));
+}
+
+template <typename IntType>
+void vbz_filter_benchmark_random(benchmark::State& state)
+{
+    vbz_filter_benchmark<SignalGenerator<IntType>>(state, sizeof(IntType));
+}
+
 /*BENCHMARK_TEMPLATE2(vbz_hdf_benchmark_sequence, std::int8_t, 0);
 BENCHMARK_TEMPLATE2(vbz_hdf_benchmark_sequence, std::int16_t, 0);
 BENCHMARK_TEMPLATE2(vbz_hdf_benchmark_sequence, std::int32_t, 0);
@@ -162,6 +379,16 @@ BENCHMARK_TEMPLATE2(vbz_hdf_benchmark_random, std::int8_t, 1);
 BENCHMARK_TEMPLATE2(vbz_hdf_benchmark_random, std::int16_t, 1);
 BENCHMARK_TEMPLATE2(vbz_hdf_benchmark_random, std::int32_t, 1);
 
+#if H5_VERSION_GE(1, 10, 3)
+BENCHMARK_TEMPLATE(vbz_hdf_write_chunks_benchmark_random, std::int16_t)->Args({ 0, 0 })->Args({ 1, 1 })->Args({ 1, 0 });
+#endif
+#if H5_VERSION_GE(1, 10, 5) && !defined(_WIN32)
+BENCHMARK_TEMPLATE(vbz_hdf_read_chunks_benchmark_random, std::int16_t)->Args({ 0, 0 })->Args({ 1, 1 })->Args({ 1, 0 });
+#endif
+
+BENCHMARK_TEMPLATE(vbz_filter_benchmark_short_reads, std::int16_t)->Args({ 0, 0 })->Args({ 1, 0 });
+BENCHMARK_TEMPLATE(vbz_filter_benchmark_random, std::int16_t)->Args({ 0, 0 })->Args({ 1, 0 })->Args({ 1, 16 * 1024 })->Args({ 1, 64 * 1024 });
+
 /*
 BENCHMARK_TEMPLATE(vbz_hdf_benchmark_random_uncompressed, std::int8_t);
 BENCHMARK_TEMPLATE(vbz_hdf_benchmark_random_uncompressed, std::int16_t);
@@ -1,12 +1,16 @@
 #include "test_utils.h"
 #include "hdf_id_helper.h"
 #include "vbz_plugin.h"
+#include "vbz_plugin_parallel_utils.h"
 #include "vbz_plugin_user_utils.h"
 
 #include <hdf5.h>
 #include <catch2/catch.hpp>
 
 #include <array>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <numeric>
 #include <random>
 
@@ -135,3 +139,415 @@ SCENARIO("Using zstd filter on a uint32 dataset")
     run_random_test<std::uint32_t>(H5T_NATIVE_UINT32, 10 * 1000 * 1000);
 }
 
+
+SCENARIO("Using zstd filter with advanced zstd settings")
+{
+    GIVEN("An empty hdf file and a data set")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(100 * 1000);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+
+        WHEN("Inserting data filtered with a fast level, long distance matching and zstd workers")
+        {
+            auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+            std::array<hsize_t, 1> chunk_sizes{ { data.size() / 8 } };
+            H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+            vbz_filter_enable_advanced(creation_properties.get(), sizeof(std::int16_t), true, -5, 20, 0, true, 2);
+
+            auto dataset = create_dataset(file_id, "foo", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+
+            write_full_dataset(dataset.get(), H5T_NATIVE_INT16, data);
+
+            THEN("Data is read back correctly")
+            {
+                auto read_data = read_1d_dataset<std::int16_t>(file_id, "foo", H5T_NATIVE_INT16);
+                CHECK(read_data == data);
+            }
+        }
+    }
+}
+
+SCENARIO("Using zstd filter after releasing its cache")
+{
+    GIVEN("An empty hdf file and a data set")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(100 * 1000);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+
+        WHEN("Inserting filtered data in many chunks, releasing the cache part way through")
+        {
+            auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+            std::array<hsize_t, 1> chunk_sizes{ { data.size() / 8 } };
+            H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+            vbz_filter_enable(creation_properties.get(), sizeof(std::int16_t), true, 1);
+
+            auto dataset = create_dataset(file_id, "foo", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+            write_full_dataset(dataset.get(), H5T_NATIVE_INT16, data);
+            vbz_plugin_release_cache();
+
+            auto second_dataset = create_dataset(file_id, "bar", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+            write_full_dataset(second_dataset.get(), H5T_NATIVE_INT16, data);
+
+            THEN("Data is read back correctly")
+            {
+                CHECK(read_1d_dataset<std::int16_t>(file_id, "foo", H5T_NATIVE_INT16) == data);
+                vbz_plugin_release_cache();
+                CHECK(read_1d_dataset<std::int16_t>(file_id, "bar", H5T_NATIVE_INT16) == data);
+            }
+        }
+    }
+}
+
+SCENARIO("Calling the vbz filter directly")
+{
+    auto const filter = static_cast<H5Z_class2_t const*>(vbz_plugin_info())->filter;
+    std::array<unsigned int, 4> const cd_values{ { FILTER_VBZ_VERSION, sizeof(std::int16_t), 1, 1 } };
+
+    std::vector<std::int16_t> data(10 * 1000);
+    std::iota(data.begin(), data.end(), std::int16_t(0));
+    auto const data_size = data.size() * sizeof(data[0]);
+
+    GIVEN("A compressed chunk")
+    {
+        std::size_t buf_size = data_size;
+        void* buf = malloc(buf_size);
+        std::memcpy(buf, data.data(), buf_size);
+
+        auto const compressed_size = filter(0, cd_values.size(), cd_values.data(), data_size, &buf_size, &buf);
+        REQUIRE(compressed_size != 0);
+
+        THEN("The chunk's buffer is exactly the compressed size")
+        {
+            CHECK(compressed_size < data_size);
+            CHECK(buf_size == compressed_size);
+        }
+
+        WHEN("Decompressing into a new buffer")
+        {
+            auto const decompressed_size = filter(H5Z_FLAG_REVERSE, cd_values.size(), cd_values.data(), compressed_size, &buf_size, &buf);
+
+            THEN("The data is decompressed")
+            {
+                REQUIRE(decompressed_size == data_size);
+                CHECK(buf_size == data_size);
+                CHECK(std::memcmp(buf, data.data(), data_size) == 0);
+            }
+        }
+
+        WHEN("Decompressing from a buffer large enough to hold the data, with trailing bytes")
+        {
+            auto const large_size = data_size + 100;
+            auto large_buf = malloc(large_size);
+            std::memset(large_buf, 0xff, large_size);
+            std::memcpy(large_buf, buf, compressed_size);
+            free(buf);
+            buf = large_buf;
+            buf_size = large_size;
+
+            auto const decompressed_size = filter(H5Z_FLAG_REVERSE, cd_values.size(), cd_values.data(), compressed_size, &buf_size, &buf);
+
+            THEN("The data is decompressed into the same buffer")
+            {
+                REQUIRE(decompressed_size == data_size);
+                CHECK(buf == large_buf);
+                CHECK(buf_size == large_size);
+                CHECK(std::memcmp(buf, data.data(), data_size) == 0);
+            }
+        }
+
+        free(buf);
+    }
+}
+
+SCENARIO("Using zstd filter with a checksum filter")
+{
+    GIVEN("An empty hdf file and a data set")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(100 * 1000);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+
+        WHEN("Inserting data filtered with vbz, then checksummed")
+        {
+            auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+            std::array<hsize_t, 1> chunk_sizes{ { data.size() / 8 } };
+            H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+            vbz_filter_enable(creation_properties.get(), sizeof(std::int16_t), true, 1);
+            H5Pset_fletcher32(creation_properties.get());
+
+            auto dataset = create_dataset(file_id, "foo", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+            write_full_dataset(dataset.get(), H5T_NATIVE_INT16, data);
+
+            THEN("Data is read back correctly")
+            {
+                CHECK(read_1d_dataset<std::int16_t>(file_id, "foo", H5T_NATIVE_INT16) == data);
+            }
+        }
+    }
+}
+
+SCENARIO("Using zstd filter with chunks split into blocks")
+{
+    GIVEN("An empty hdf file and a data set")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(100 * 1000);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+
+        for (unsigned int thread_count : { 0, 1, 3 })
+        {
+            WHEN("Inserting data in blocked chunks, using " << thread_count << " threads")
+            {
+                vbz_plugin_set_thread_count(thread_count);
+
+                auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+                std::array<hsize_t, 1> chunk_sizes{ { data.size() / 2 } };
+                H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+                vbz_filter_enable_blocked(creation_properties.get(), sizeof(std::int16_t), true, 1, 4096);
+
+                auto dataset = create_dataset(file_id, "foo", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+                write_full_dataset(dataset.get(), H5T_NATIVE_INT16, data);
+
+                THEN("Data is read back correctly")
+                {
+                    CHECK(read_1d_dataset<std::int16_t>(file_id, "foo", H5T_NATIVE_INT16) == data);
+                }
+
+                vbz_plugin_set_thread_count(0);
+            }
+        }
+    }
+}
+
+#if H5_VERSION_GE(1, 10, 3)
+SCENARIO("Writing vbz chunks directly on several threads")
+{
+    GIVEN("An empty hdf file and datasets with different vbz settings")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(100 * 1000);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+        std::size_t const chunk_count = 4;
+        hsize_t const chunk_size = data.size() / chunk_count;
+
+        auto const create_chunked = [&](char const* name, std::function<void(hid_t)> enable_filter)
+        {
+            auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+            std::array<hsize_t, 1> chunk_sizes{ { chunk_size } };
+            H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+            enable_filter(creation_properties.get());
+            return create_dataset(file_id, name, H5T_NATIVE_INT16, data.size(), creation_properties.get());
+        };
+
+        std::vector<IdRef> datasets;
+        datasets.push_back(create_chunked("simple", [](hid_t properties) {
+            vbz_filter_enable(properties, sizeof(std::int16_t), true, 1);
+        }));
+        datasets.push_back(create_chunked("advanced", [](hid_t properties) {
+            vbz_filter_enable_advanced(properties, sizeof(std::int16_t), true, 19, 20, 9, true, 0);
+        }));
+        datasets.push_back(create_chunked("blocked", [](hid_t properties) {
+            vbz_filter_enable_blocked(properties, sizeof(std::int16_t), true, 1, 4096);
+        }));
+
+        std::vector<std::array<hsize_t, 1>> offsets(chunk_count);
+        std::vector<VbzChunkWrite> chunks;
+        for (auto const& dataset : datasets)
+        {
+            for (std::size_t i = 0; i < chunk_count; ++i)
+            {
+                offsets[i][0] = i * chunk_size;
+                chunks.push_back({ dataset.get(), offsets[i].data(), data.data() + i * chunk_size, chunk_size * sizeof(std::int16_t) });
+            }
+        }
+
+        for (unsigned int thread_count : { 0, 1, 3 })
+        {
+            WHEN("Writing chunks of every dataset at once, using " << thread_count << " threads")
+            {
+                auto const result = vbz_write_chunks_parallel(chunks.data(), chunks.size(), thread_count);
+
+                THEN("Data is read back correctly through the filter")
+                {
+                    CHECK(result >= 0);
+                    CHECK(read_1d_dataset<std::int16_t>(file_id, "simple", H5T_NATIVE_INT16) == data);
+                    CHECK(read_1d_dataset<std::int16_t>(file_id, "advanced", H5T_NATIVE_INT16) == data);
+                    CHECK(read_1d_dataset<std::int16_t>(file_id, "blocked", H5T_NATIVE_INT16) == data);
+                }
+            }
+        }
+
+        WHEN("Writing chunks to a dataset without the vbz filter")
+        {
+            auto unfiltered = create_chunked("unfiltered", [](hid_t) {});
+            VbzChunkWrite chunk{ unfiltered.get(), offsets[0].data(), data.data(), chunk_size * sizeof(std::int16_t) };
+
+            THEN("The write fails")
+            {
+                CHECK(vbz_write_chunks_parallel(&chunk, 1, 0) < 0);
+            }
+        }
+    }
+}
+#endif
+
+#if H5_VERSION_GE(1, 10, 5) && !defined(_WIN32)
+SCENARIO("Reading vbz chunks directly on several threads")
+{
+    GIVEN("An hdf file with datasets with different vbz settings")
+    {
+        std::vector<std::int16_t> data(100 * 1000 + 10);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+        hsize_t const chunk_size = 25 * 1000;
+        char const* const names[] = { "simple", "advanced", "blocked" };
+
+        {
+            auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+            auto file = IdRef::claim(file_id);
+            for (auto name : names)
+            {
+                auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+                std::array<hsize_t, 1> chunk_sizes{ { chunk_size } };
+                H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+                if (std::strcmp(name, "advanced") == 0)
+                {
+                    vbz_filter_enable_advanced(creation_properties.get(), sizeof(std::int16_t), true, 19, 20, 9, true, 0);
+                }
+                else if (std::strcmp(name, "blocked") == 0)
+                {
+                    vbz_filter_enable_blocked(creation_properties.get(), sizeof(std::int16_t), true, 1, 4096);
+                }
+                else
+                {
+                    vbz_filter_enable(creation_properties.get(), sizeof(std::int16_t), true, 1);
+                }
+
+                auto dataset = create_dataset(file_id, name, H5T_NATIVE_INT16, data.size(), creation_properties.get());
+                write_full_dataset(dataset.get(), H5T_NATIVE_INT16, data);
+            }
+        }
+
+        auto file_id = H5Fopen("./test_file.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        VbzChunkIndex index;
+        bool indexed = true;
+        for (auto name : names)
+        {
+            auto dataset = IdRef::claim(H5Dopen(file_id, name, H5P_DEFAULT));
+            indexed = indexed && vbz_index_chunks(dataset.get(), &index) >= 0;
+        }
+
+        for (unsigned int thread_count : { 0, 1, 3 })
+        {
+            WHEN("Reading every chunk at once, using " << thread_count << " threads")
+            {
+                // Chunks are read whole, so the last chunk of each dataset is padded.
+                std::vector<std::vector<std::int16_t>> read_data(index.datasets.size(), std::vector<std::int16_t>(5 * chunk_size));
+                std::vector<VbzChunkRead> reads;
+                for (std::size_t i = 0; i < index.chunks.size(); ++i)
+                {
+                    auto const& chunk = index.chunks[i];
+                    reads.push_back({ i, read_data[chunk.dataset].data() + chunk.offset[0], chunk.size });
+                }
+                auto const result = vbz_read_chunks_parallel(index, reads.data(), reads.size(), thread_count);
+
+                THEN("Every chunk of every dataset is read back correctly")
+                {
+                    CHECK(indexed);
+                    CHECK(index.chunks.size() == 15);
+                    CHECK(result >= 0);
+                    for (auto& dataset_data : read_data)
+                    {
+                        dataset_data.resize(data.size());
+                        CHECK(dataset_data == data);
+                    }
+                }
+            }
+        }
+
+        WHEN("Reading a chunk into a buffer smaller than the chunk")
+        {
+            std::vector<std::int16_t> read_data(chunk_size - 1);
+            VbzChunkRead read{ 0, read_data.data(), read_data.size() * sizeof(std::int16_t) };
+
+            THEN("The read fails")
+            {
+                CHECK(vbz_read_chunks_parallel(index, &read, 1, 0) < 0);
+            }
+        }
+    }
+
+    GIVEN("An hdf file with a chunk holding less data than the chunk size")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(1000);
+        std::iota(data.begin(), data.end(), std::int16_t(0));
+        auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+        std::array<hsize_t, 1> chunk_sizes{ { data.size() } };
+        H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+        vbz_filter_enable(creation_properties.get(), sizeof(std::int16_t), true, 1);
+        auto dataset = create_dataset(file_id, "short", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+
+        // Compress only half the chunk, and store it as the whole chunk.
+        CompressionOptions options{ true, sizeof(std::int16_t), 1, FILTER_VBZ_VERSION };
+        auto const half_size = vbz_size_t(data.size() / 2 * sizeof(std::int16_t));
+        std::vector<char> compressed(vbz_max_compressed_size(half_size, &options));
+        auto const compressed_size = vbz_compress_sized(data.data(), half_size, compressed.data(), vbz_size_t(compressed.size()), &options);
+        hsize_t const offset[] = { 0 };
+        H5Dwrite_chunk(dataset.get(), H5P_DEFAULT, 0, offset, compressed_size, compressed.data());
+
+        WHEN("Reading the chunk")
+        {
+            VbzChunkIndex index;
+            auto const indexed = vbz_index_chunks(dataset.get(), &index);
+            std::vector<std::int16_t> read_data(data.size());
+            VbzChunkRead read{ 0, read_data.data(), read_data.size() * sizeof(std::int16_t) };
+
+            THEN("The read fails")
+            {
+                CHECK(indexed >= 0);
+                CHECK(vbz_read_chunks_parallel(index, &read, 1, 0) < 0);
+            }
+        }
+    }
+
+    GIVEN("An hdf file with a dataset without the vbz filter")
+    {
+        auto file_id = H5Fcreate("./test_file.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        auto file = IdRef::claim(file_id);
+
+        std::vector<std::int16_t> data(1000);
+        auto creation_properties = IdRef::claim(H5Pcreate(H5P_DATASET_CREATE));
+        std::array<hsize_t, 1> chunk_sizes{ { data.size() } };
+        H5Pset_chunk(creation_properties.get(), int(chunk_sizes.size()), chunk_sizes.data());
+        auto dataset = create_dataset(file_id, "unfiltered", H5T_NATIVE_INT16, data.size(), creation_properties.get());
+        write_full_dataset(dataset.get(), H5T_NATIVE_INT16, data);
+
+        WHEN("Indexing its chunks")
+        {
+            VbzChunkIndex index;
+
+            THEN("Indexing fails")
+            {
+                CHECK(vbz_index_chunks(dataset.get(), &index) < 0);
+                CHECK(index.chunks.empty());
+            }
+        }
+    }
+}
+#endif
@@ -1,14 +1,20 @@
 #include "vbz_plugin/vbz_hdf_plugin_export.h"
 #include "vbz_plugin.h"
 #include "vbz.h"
+#include "vbz_scratch_buffer.h"
 
 #include <gsl/gsl-lite.hpp>
 #include <hdf5/hdf5_plugin_types.h>
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
 
 #ifdef _WIN32
 # ifndef NOMINMAX
@@ -91,6 +97,102 @@ struct h5free_delete
     void operator()(void* x) { h5_free(x); }
 };
 
+/// \brief State a filter call needs, kept between calls.
+struct FilterState
+{
+    FilterState()
+    : context(vbz_create_context(), vbz_free_context)
+    {
+    }
+
+    std::unique_ptr<vbz_context, decltype(&vbz_free_context)> context;
+
+    // Compressed or decompressed data, before it is copied into a buffer of exactly its size.
+    ScratchBuffer output;
+};
+
+/// \brief States kept between filter calls, so chunks after the first make no zstd or scratch allocations.
+///
+/// HDF5 calls the filter once per chunk. Each call takes a state from the cache and returns it when
+/// done, so calls on different threads never share one, and the cache holds one state for each
+/// thread which has been inside the filter at the same time. States are freed when the plugin is
+/// unloaded, or by #vbz_plugin_release_cache.
+class FilterStateCache
+{
+public:
+    /// \return A state, or null if one could not be allocated.
+    std::unique_ptr<FilterState> acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_states.empty())
+            {
+                auto state = std::move(m_states.back());
+                m_states.pop_back();
+                return state;
+            }
+        }
+
+        std::unique_ptr<FilterState> state(new (std::nothrow) FilterState());
+        if (!state || !state->context)
+        {
+            return nullptr;
+        }
+        return state;
+    }
+
+    void release(std::unique_ptr<FilterState> state)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        try
+        {
+            m_states.push_back(std::move(state));
+        }
+        catch (std::bad_alloc const&)
+        {
+            // The state is freed, the next call makes another.
+        }
+    }
+
+    /// \brief Free the states not in use, those in use are kept when they are released.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_states.clear();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<FilterState>> m_states;
+};
+
+// Threads used for each blocked chunk, see #vbz_plugin_set_thread_count.
+std::atomic<unsigned int> blocked_thread_count{ 0 };
+
+FilterStateCache& filter_state_cache()
+{
+    static FilterStateCache cache;
+    return cache;
+}
+
+/// \brief A state taken from the cache for one filter call.
+struct CachedFilterState
+{
+    CachedFilterState()
+    : state(filter_state_cache().acquire())
+    {
+    }
+
+    ~CachedFilterState()
+    {
+        if (state)
+        {
+            filter_state_cache().release(std::move(state));
+        }
+    }
+
+    std::unique_ptr<FilterState> state;
+};
 
 }
 
@@ -98,7 +200,7 @@ size_t vbz_filter(
     unsigned flags,
     size_t cd_nelmts,
     const unsigned int cd_values[],
-    [[maybe_unused]]size_t nbytes,
+    size_t nbytes,
     size_t* buf_size,
     void** buf)
 {
@@ -111,6 +213,14 @@ size_t vbz_filter(
         return 0;
     }
 
+    CachedFilterState cached_state;
+    if (!cached_state.state)
+    {
+        std::cerr << "vbz_filter: failed to allocate context" << std::endl;
+        return 0;
+    }
+    auto const context = cached_state.state->context.get();
+
     unsigned int vbz_version = cd_values[FILTER_VBZ_VERSION_OPTION];
     unsigned int integer_size = cd_values[FILTER_VBZ_INTEGER_SIZE_OPTION];
     bool use_zig_zag = cd_values[FILTER_VBZ_USE_DELTA_ZIG_ZAG_COMPRESSION] != 0;
@@ -122,20 +232,35 @@ size_t vbz_filter(
     }
     
     CompressionOptions options{ use_zig_zag, integer_size, compression_level, vbz_version };
+
+    // Only applied when compressing, zstd needs none of them to decompress.
+    VbzZstdParameters zstd_parameters{};
+    bool const has_zstd_parameters = cd_nelmts > FILTER_VBZ_ZSTD_WINDOW_LOG_OPTION;
+    auto const zstd_parameter = [&](std::size_t index) { return index < cd_nelmts ? int(cd_values[index]) : 0; };
+    zstd_parameters.window_log = zstd_parameter(FILTER_VBZ_ZSTD_WINDOW_LOG_OPTION);
+    zstd_parameters.strategy = zstd_parameter(FILTER_VBZ_ZSTD_STRATEGY_OPTION);
+    zstd_parameters.enable_long_distance_matching = zstd_parameter(FILTER_VBZ_ZSTD_LONG_DISTANCE_MATCHING_OPTION);
+    zstd_parameters.worker_count = zstd_parameter(FILTER_VBZ_ZSTD_WORKER_COUNT_OPTION);
+
+    // Blocked chunks are compressed on several threads, each with its own context, so neither the
+    // cached context nor the advanced zstd settings apply to them.
+    vbz_size_t const block_size = cd_nelmts > FILTER_VBZ_BLOCK_SIZE_OPTION ? cd_values[FILTER_VBZ_BLOCK_SIZE_OPTION] : 0;
+    auto const thread_count = blocked_thread_count.load();
     
 #if VBZ_DEBUG
     std::cout << "======================================================\n"
         << "Using options:"
         << " integer_size: " << integer_size
         << " use_zig_zag: " << use_zig_zag
-        << " compression_level: " << compression_level
+        << " compression_level: " << int(compression_level)
         << std::endl;
 #endif
 
+    // HDF5 may pass a buffer larger than the chunk, so only the first nbytes are used.
     // If decompressing
     if (flags & H5Z_FLAG_REVERSE)
     {
-        auto input_span = gsl::make_span(static_cast<char*>(*buf), *buf_size);
+        auto input_span = gsl::make_span(static_cast<char*>(*buf), nbytes);
         if (input_span.size() > std::numeric_limits<vbz_size_t>::max())
         {
             std::cerr << "vbz_filter: Chunk size too large." << std::endl;
@@ -155,14 +280,46 @@ size_t vbz_filter(
             std::cerr << "vbz_filter: size error" << std::endl;
             return 0;
         }
-        outbuf.reset(h5_malloc(expected_uncompressed_size));
 
-        outbuf_used_size = vbz_decompress_sized(
-            input_span.data(),
-            vbz_size_t(input_span.size()),
-            outbuf.get(),
-            expected_uncompressed_size,
-            &options);
+        // Decompress straight into a new buffer, unless the chunk's buffer can be reused,
+        // which needs the data decompressed elsewhere first.
+        void* output = nullptr;
+        bool const reuse_buffer = expected_uncompressed_size <= *buf_size;
+        if (reuse_buffer)
+        {
+            output = cached_state.state->output.reserve(expected_uncompressed_size);
+        }
+        else
+        {
+            outbuf.reset(h5_malloc(expected_uncompressed_size));
+            output = outbuf.get();
+        }
+        if (!output)
+        {
+            std::cerr << "vbz_filter: failed to allocate output" << std::endl;
+            return 0;
+        }
+
+        if (block_size != 0)
+        {
+            outbuf_used_size = vbz_decompress_blocked(
+                input_span.data(),
+                vbz_size_t(input_span.size()),
+                output,
+                expected_uncompressed_size,
+                &options,
+                thread_count);
+        }
+        else
+        {
+            outbuf_used_size = vbz_decompress_sized_ctx(
+                context,
+                input_span.data(),
+                vbz_size_t(input_span.size()),
+                output,
+                expected_uncompressed_size,
+                &options);
+        }
         if (vbz_is_error(outbuf_used_size))
         {
             std::cerr << "vbz_filter: compression error" << std::endl;
@@ -176,41 +333,77 @@ size_t vbz_filter(
         }
 
 #if VBZ_DEBUG
-        std::cout << "Decompressed dataset from " << *buf_size << "  bytes to " << outbuf_used_size
-            << " with checksum " << checksum(gsl::make_span(static_cast<char*>(outbuf.get()), outbuf_used_size)) << std::endl;
+        std::cout << "Decompressed dataset from " << nbytes << "  bytes to " << outbuf_used_size
+            << " with checksum " << checksum(gsl::make_span(static_cast<char*>(output), outbuf_used_size)) << std::endl;
 #endif
+
+        if (reuse_buffer)
+        {
+            std::memcpy(*buf, output, outbuf_used_size);
+            return outbuf_used_size;
+        }
+        outbuf_size = outbuf_used_size;
     }
     else // compressing
     {
 #if VBZ_DEBUG
-        std::cout << "Compressing data with checksum " << checksum(gsl::make_span(static_cast<char*>(*buf), *buf_size)) << std::endl;
+        std::cout << "Compressing data with checksum " << checksum(gsl::make_span(static_cast<char*>(*buf), nbytes)) << std::endl;
 #endif
-        if (*buf_size > std::numeric_limits<vbz_size_t>::max())
+        if (nbytes > std::numeric_limits<vbz_size_t>::max())
         {
             std::cerr << "vbz_filter: Chunk size too large." << std::endl;
             return 0;
         }
 
-        auto const byte_remainder = *buf_size % integer_size;
+        auto const byte_remainder = nbytes % integer_size;
         if (byte_remainder != 0)
         {
             std::cerr << "vbz_filter: Invalid integer_size specified" << std::endl;
             return 0;
         }
 
-        outbuf_size = vbz_max_compressed_size(vbz_size_t(*buf_size), &options);
-        outbuf.reset(h5_malloc(outbuf_size));
-        
-        auto output_span = gsl::make_span(static_cast<char*>(outbuf.get()), outbuf_size);
+        // Compress into scratch space sized for the worst case, then copy the data to a buffer of
+        // exactly its size, so HDF5 never holds the worst case size for a chunk.
+        auto const max_size = block_size != 0
+            ? vbz_max_compressed_size_blocked(vbz_size_t(nbytes), &options, block_size)
+            : vbz_max_compressed_size(vbz_size_t(nbytes), &options);
+        if (vbz_is_error(max_size))
+        {
+            std::cerr << "vbz_filter: compression error" << std::endl;
+            return 0;
+        }
+        auto const output = cached_state.state->output.reserve(max_size);
+        if (!output)
+        {
+            std::cerr << "vbz_filter: failed to allocate output" << std::endl;
+            return 0;
+        }
 
         // do compress
-        outbuf_used_size += vbz_compress_sized(
-            *buf,
-            vbz_size_t(*buf_size),
-            output_span.data(),
-            vbz_size_t(output_span.size()),
-            &options
-        );
+        if (block_size != 0)
+        {
+            outbuf_used_size = vbz_compress_blocked(
+                *buf,
+                vbz_size_t(nbytes),
+                output,
+                max_size,
+                &options,
+                block_size,
+                thread_count
+            );
+        }
+        else
+        {
+            outbuf_used_size = vbz_compress_sized_advanced_ctx(
+                context,
+                *buf,
+                vbz_size_t(nbytes),
+                output,
+                max_size,
+                &options,
+                has_zstd_parameters ? &zstd_parameters : nullptr
+            );
+        }
         if (vbz_is_error(outbuf_used_size))
         {
             std::cerr << "vbz_filter: compression error" << std::endl;;
@@ -218,8 +411,17 @@ size_t vbz_filter(
         }
 
 #if VBZ_DEBUG
-        std::cout << "Compressed dataset from " << *buf_size << "  bytes to " << outbuf_used_size << " with checksum " << checksum(gsl::make_span(output_span.data(), outbuf_used_size)) << std::endl;
+        std::cout << "Compressed dataset from " << nbytes << "  bytes to " << outbuf_used_size << " with checksum " << checksum(gsl::make_span(static_cast<char*>(output), outbuf_used_size)) << std::endl;
 #endif
+
+        outbuf_size = outbuf_used_size;
+        outbuf.reset(h5_malloc(outbuf_size));
+        if (!outbuf)
+        {
+            std::cerr << "vbz_filter: failed to allocate output" << std::endl;
+            return 0;
+        }
+        std::memcpy(outbuf.get(), output, outbuf_used_size);
     }    
 
     h5_free(*buf);
@@ -244,6 +446,16 @@ extern "C" VBZ_HDF_PLUGIN_EXPORT const void* vbz_plugin_info(void)
     return &vbz_filter_struct;
 }
 
+extern "C" VBZ_HDF_PLUGIN_EXPORT void vbz_plugin_release_cache(void)
+{
+    filter_state_cache().clear();
+}
+
+extern "C" VBZ_HDF_PLUGIN_EXPORT void vbz_plugin_set_thread_count(unsigned int thread_count)
+{
+    blocked_thread_count = thread_count;
+}
+
 // hdf plugin hooks
 extern "C" VBZ_HDF_PLUGIN_EXPORT H5PL_type_t H5PLget_plugin_type(void)
 {
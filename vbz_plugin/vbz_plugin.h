@@ -8,3 +8,14 @@
 #define FILTER_VBZ_INTEGER_SIZE_OPTION              1
 #define FILTER_VBZ_USE_DELTA_ZIG_ZAG_COMPRESSION    2
 #define FILTER_VBZ_ZSTD_COMPRESSION_LEVEL_OPTION    3
+
+// Optional advanced zstd settings, see VbzZstdParameters. Each is 0 for the level's default.
+#define FILTER_VBZ_ZSTD_WINDOW_LOG_OPTION           4
+#define FILTER_VBZ_ZSTD_STRATEGY_OPTION             5
+#define FILTER_VBZ_ZSTD_LONG_DISTANCE_MATCHING_OPTION 6
+#define FILTER_VBZ_ZSTD_WORKER_COUNT_OPTION         7
+
+// Optional number of integers in each independently compressed block of a chunk, or 0 to compress
+// chunks whole. Blocked chunks are compressed and decompressed on several threads, see vbz_compress_blocked.
+#define FILTER_VBZ_BLOCK_SIZE_OPTION                8
+#define FILTER_VBZ_OPTION_COUNT                     9
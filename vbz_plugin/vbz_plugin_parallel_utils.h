@@ -0,0 +1,459 @@
+#pragma once
+
+#include <hdf5.h>
+#if !defined(_WIN32)
+# include <unistd.h>
+#endif
+#include "vbz.h"
+#include "vbz_parallel.h"
+#include "vbz_plugin.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+/// \brief The settings the vbz filter on a dataset compresses its chunks with.
+struct VbzDatasetOptions
+{
+    CompressionOptions options;
+    // Advanced zstd settings, only used if has_zstd_parameters is set.
+    VbzZstdParameters zstd_parameters;
+    bool has_zstd_parameters;
+    // Number of integers in each block, or 0 if chunks are compressed whole.
+    unsigned int block_size;
+};
+
+/// \brief Read the settings of the vbz filter on [dataset], as the filter reads them from its cd_values.
+/// \return false if vbz is not the only filter on [dataset], so its chunks cannot be compressed outside of HDF5.
+inline bool vbz_dataset_options(hid_t dataset, VbzDatasetOptions* dataset_options)
+{
+    auto const creation_properties = H5Dget_create_plist(dataset);
+    if (creation_properties < 0)
+    {
+        return false;
+    }
+
+    unsigned int flags = 0;
+    std::size_t cd_nelmts = FILTER_VBZ_OPTION_COUNT;
+    unsigned int cd_values[FILTER_VBZ_OPTION_COUNT] = {};
+    bool const found = H5Pget_nfilters(creation_properties) == 1
+        && H5Pget_filter_by_id2(creation_properties, FILTER_VBZ_ID, &flags, &cd_nelmts, cd_values, 0, nullptr, nullptr) >= 0
+        && cd_nelmts >= 3;
+    H5Pclose(creation_properties);
+    if (!found)
+    {
+        return false;
+    }
+
+    auto const cd_value = [&](std::size_t index, unsigned int default_value) { return index < cd_nelmts ? cd_values[index] : default_value; };
+    auto& options = dataset_options->options;
+    options.vbz_version = cd_values[FILTER_VBZ_VERSION_OPTION];
+    options.integer_size = cd_values[FILTER_VBZ_INTEGER_SIZE_OPTION];
+    options.perform_delta_zig_zag = cd_values[FILTER_VBZ_USE_DELTA_ZIG_ZAG_COMPRESSION] != 0;
+    options.zstd_compression_level = cd_value(FILTER_VBZ_ZSTD_COMPRESSION_LEVEL_OPTION, 1);
+
+    auto& zstd_parameters = dataset_options->zstd_parameters;
+    zstd_parameters.window_log = int(cd_value(FILTER_VBZ_ZSTD_WINDOW_LOG_OPTION, 0));
+    zstd_parameters.strategy = int(cd_value(FILTER_VBZ_ZSTD_STRATEGY_OPTION, 0));
+    zstd_parameters.enable_long_distance_matching = int(cd_value(FILTER_VBZ_ZSTD_LONG_DISTANCE_MATCHING_OPTION, 0));
+    zstd_parameters.worker_count = int(cd_value(FILTER_VBZ_ZSTD_WORKER_COUNT_OPTION, 0));
+    dataset_options->has_zstd_parameters = cd_nelmts > FILTER_VBZ_ZSTD_WINDOW_LOG_OPTION;
+
+    dataset_options->block_size = cd_value(FILTER_VBZ_BLOCK_SIZE_OPTION, 0);
+    return true;
+}
+
+/// \brief Find the number of threads #vbz_parallel_for_each runs [item_count] items on.
+inline std::size_t vbz_worker_count(std::size_t item_count, unsigned int thread_count)
+{
+    return std::min<std::size_t>(vbz_resolve_thread_count(thread_count), item_count);
+}
+
+/// \brief Run fn(worker_index, context, item_index) for every item in [0, item_count) on up to [thread_count]
+///        threads, each with its own vbz context.
+/// \return false if a context could not be created, or [fn] ran out of memory for an item.
+template <typename Fn>
+bool vbz_parallel_for_each(std::size_t item_count, unsigned int thread_count, Fn fn)
+{
+    std::vector<std::unique_ptr<vbz_context, decltype(&vbz_free_context)>> contexts;
+    try
+    {
+        auto const worker_count = vbz_worker_count(item_count, thread_count);
+        for (std::size_t worker = 0; worker < worker_count; ++worker)
+        {
+            contexts.emplace_back(vbz_create_context(), vbz_free_context);
+            if (!contexts.back())
+            {
+                return false;
+            }
+        }
+    }
+    catch (std::bad_alloc const&)
+    {
+        return false;
+    }
+
+    // An exception escaping a worker thread terminates the process, so it is caught for each item.
+    std::atomic<bool> out_of_memory{ false };
+    vbz_parallel_for(item_count, contexts.size(), [&](std::size_t worker, std::size_t item)
+    {
+        try
+        {
+            fn(worker, contexts[worker].get(), item);
+        }
+        catch (std::bad_alloc const&)
+        {
+            out_of_memory = true;
+        }
+    });
+    return !out_of_memory;
+}
+
+#if H5_VERSION_GE(1, 10, 3)
+/// \brief A chunk to write with #vbz_write_chunks_parallel.
+struct VbzChunkWrite
+{
+    // Dataset to write to, which must have the vbz filter as its only filter.
+    hid_t dataset;
+    // Logical position of the chunk in the dataset, one entry per dimension, as for H5Dwrite_chunk.
+    hsize_t const* offset;
+    // The chunk's uncompressed data, a whole chunk of the dataset's type.
+    void const* data;
+    // Size of the chunk's data, in bytes.
+    std::size_t size;
+};
+
+/// \brief Compress chunks as the vbz filter would on several threads, then write them with H5Dwrite_chunk.
+///
+/// HDF5 runs filters one chunk at a time under its global lock, so writers using H5Dwrite on several
+/// threads still compress one chunk at a time. Chunks written here are compressed first, outside of
+/// HDF5, so HDF5 is only used to write the compressed bytes. They can be read back through the filter
+/// as normal, using the options each dataset's filter was created with.
+/// \param chunks                   Chunks to write, in any mix of datasets.
+/// \param chunk_count              Number of chunks to write.
+/// \param thread_count             The maximum number of threads to compress with, or 0 for one per hardware thread.
+/// \return A non-negative value on success, or a negative value if a dataset does not use only the vbz filter,
+///         or a chunk could not be compressed or written.
+inline herr_t vbz_write_chunks_parallel(
+    VbzChunkWrite const* chunks,
+    std::size_t chunk_count,
+    unsigned int thread_count)
+{
+    struct CompressedChunk
+    {
+        VbzDatasetOptions options;
+        std::vector<char> data;
+        vbz_size_t size;
+    };
+    std::vector<CompressedChunk> compressed;
+    try
+    {
+        compressed.resize(chunk_count);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return -1;
+    }
+
+    // Reading each dataset's settings calls HDF5, so is done before compression starts.
+    for (std::size_t i = 0; i < chunk_count; ++i)
+    {
+        if (std::size_t(vbz_size_t(chunks[i].size)) != chunks[i].size)
+        {
+            return -1;
+        }
+        if (i > 0 && chunks[i].dataset == chunks[i - 1].dataset)
+        {
+            compressed[i].options = compressed[i - 1].options;
+        }
+        else if (!vbz_dataset_options(chunks[i].dataset, &compressed[i].options))
+        {
+            return -1;
+        }
+    }
+
+    // Chunks are already spread over threads, so blocked chunks compress their blocks on the same thread.
+    // Running out of memory for a chunk's output fails the whole write, see #vbz_parallel_for_each.
+    auto const compress_chunk = [&](std::size_t, vbz_context* context, std::size_t i)
+    {
+        auto& chunk = compressed[i];
+        auto const& options = chunk.options;
+        auto const source_size = vbz_size_t(chunks[i].size);
+        auto const max_size = options.block_size != 0
+            ? vbz_max_compressed_size_blocked(source_size, &options.options, options.block_size)
+            : vbz_max_compressed_size(source_size, &options.options);
+        if (vbz_is_error(max_size))
+        {
+            chunk.size = max_size;
+            return;
+        }
+
+        chunk.data.resize(max_size);
+        if (options.block_size != 0)
+        {
+            chunk.size = vbz_compress_blocked(chunks[i].data, source_size, chunk.data.data(), max_size, &options.options, options.block_size, 1);
+        }
+        else
+        {
+            chunk.size = vbz_compress_sized_advanced_ctx(
+                context,
+                chunks[i].data,
+                source_size,
+                chunk.data.data(),
+                max_size,
+                &options.options,
+                options.has_zstd_parameters ? &options.zstd_parameters : nullptr
+            );
+        }
+    };
+    if (!vbz_parallel_for_each(chunk_count, thread_count, compress_chunk))
+    {
+        return -1;
+    }
+
+    for (std::size_t i = 0; i < chunk_count; ++i)
+    {
+        if (vbz_is_error(compressed[i].size))
+        {
+            return -1;
+        }
+
+        // A filter mask of 0 marks the chunk as passed through every filter, ie. vbz.
+        if (H5Dwrite_chunk(chunks[i].dataset, H5P_DEFAULT, 0, chunks[i].offset, compressed[i].size, compressed[i].data.data()) < 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif
+
+#if H5_VERSION_GE(1, 10, 5) && !defined(_WIN32)
+/// \brief Where a chunk written with the vbz filter is stored, see #vbz_index_chunks.
+struct VbzChunkLocation
+{
+    // Index of the chunk's dataset in VbzChunkIndex::datasets.
+    std::size_t dataset;
+    // Logical position of the chunk in its dataset, one entry per dimension.
+    std::vector<hsize_t> offset;
+    // Position of the compressed chunk in the file, in bytes.
+    haddr_t address;
+    // Size of the compressed chunk, in bytes.
+    hsize_t stored_size;
+    // Size of the chunk once decompressed, in bytes.
+    std::size_t size;
+};
+
+/// \brief The chunks of one or more datasets, found once so they can be read without calling HDF5.
+struct VbzChunkIndex
+{
+    // Descriptor of the file holding the datasets, owned by HDF5.
+    int file_descriptor = -1;
+    std::vector<VbzDatasetOptions> datasets;
+    std::vector<VbzChunkLocation> chunks;
+};
+
+/// \brief Add the chunks of [dataset] to [index], so they can be read with #vbz_read_chunks_parallel.
+///
+/// Only chunks which have been written are added, in the order HDF5 stores them. The file is flushed
+/// first, so chunks written through the same file handle are on disk. The index is valid until the
+/// file is closed or the dataset written again.
+/// \return A non-negative value on success, or a negative value if vbz is not the only filter on [dataset],
+///         its file is not opened with the default (sec2) driver, or it is in a different file to datasets
+///         already in [index].
+inline herr_t vbz_index_chunks(hid_t dataset, VbzChunkIndex* index)
+{
+    VbzDatasetOptions options;
+    if (!vbz_dataset_options(dataset, &options) || H5Fflush(dataset, H5F_SCOPE_LOCAL) < 0)
+    {
+        return -1;
+    }
+
+    // Chunks are read straight from the file's descriptor, which needs the file to be a plain file.
+    int file_descriptor = -1;
+    {
+        auto const file = H5Iget_file_id(dataset);
+        auto const access_properties = file < 0 ? -1 : H5Fget_access_plist(file);
+        void* file_handle = nullptr;
+        if (access_properties >= 0
+            && H5Pget_driver(access_properties) == H5FD_SEC2
+            && H5Fget_vfd_handle(file, access_properties, &file_handle) >= 0)
+        {
+            file_descriptor = *static_cast<int*>(file_handle);
+        }
+        if (access_properties >= 0)
+        {
+            H5Pclose(access_properties);
+        }
+        if (file >= 0)
+        {
+            H5Fclose(file);
+        }
+    }
+    if (file_descriptor < 0 || (index->file_descriptor >= 0 && index->file_descriptor != file_descriptor))
+    {
+        return -1;
+    }
+
+    // Every chunk decompresses to a whole chunk, even those at the edge of the dataset.
+    auto const creation_properties = H5Dget_create_plist(dataset);
+    auto const type = H5Dget_type(dataset);
+    std::vector<hsize_t> chunk_dims(H5S_MAX_RANK);
+    auto const rank = creation_properties < 0 ? -1 : H5Pget_chunk(creation_properties, int(chunk_dims.size()), chunk_dims.data());
+    std::size_t chunk_size = type < 0 ? 0 : H5Tget_size(type);
+    for (int dim = 0; dim < rank; ++dim)
+    {
+        chunk_size *= std::size_t(chunk_dims[dim]);
+    }
+    if (type >= 0)
+    {
+        H5Tclose(type);
+    }
+    if (creation_properties >= 0)
+    {
+        H5Pclose(creation_properties);
+    }
+
+    // Older HDF5 versions do not accept H5S_ALL for the dataset's dataspace.
+    auto const dataspace = H5Dget_space(dataset);
+    hsize_t chunk_count = 0;
+    if (dataspace < 0 || rank <= 0 || chunk_size == 0 || H5Dget_num_chunks(dataset, dataspace, &chunk_count) < 0)
+    {
+        if (dataspace >= 0)
+        {
+            H5Sclose(dataspace);
+        }
+        return -1;
+    }
+
+    auto const first_chunk = index->chunks.size();
+    auto const dataset_index = index->datasets.size();
+    for (hsize_t i = 0; i < chunk_count; ++i)
+    {
+        VbzChunkLocation chunk;
+        chunk.dataset = dataset_index;
+        chunk.offset.resize(std::size_t(rank));
+        chunk.size = chunk_size;
+
+        // A set filter mask means vbz was skipped for the chunk, which the filter never does.
+        unsigned int filter_mask = 0;
+        if (H5Dget_chunk_info(dataset, dataspace, i, chunk.offset.data(), &filter_mask, &chunk.address, &chunk.stored_size) < 0
+            || filter_mask != 0)
+        {
+            H5Sclose(dataspace);
+            index->chunks.resize(first_chunk);
+            return -1;
+        }
+        index->chunks.push_back(std::move(chunk));
+    }
+    H5Sclose(dataspace);
+
+    index->file_descriptor = file_descriptor;
+    index->datasets.push_back(options);
+    return 0;
+}
+
+/// \brief A chunk to read with #vbz_read_chunks_parallel.
+struct VbzChunkRead
+{
+    // Index of the chunk to read in VbzChunkIndex::chunks.
+    std::size_t chunk;
+    // Buffer to decompress the chunk into.
+    void* destination;
+    // Size of [destination], at least VbzChunkLocation::size bytes.
+    std::size_t capacity;
+};
+
+/// \brief Read chunks from [index] with pread and decompress them, on several threads, without calling HDF5.
+///
+/// HDF5 reads and filters chunks under its global lock, so readers using H5Dread on several threads
+/// still decompress one chunk at a time. Chunks read here are only located by HDF5, in #vbz_index_chunks,
+/// so any number can be read at once, and reads can run alongside other threads' HDF5 calls.
+/// \param index                    Chunks found with #vbz_index_chunks, whose file must still be open.
+/// \param reads                    Chunks to read, and where to decompress them to.
+/// \param read_count               Number of chunks to read.
+/// \param thread_count             The maximum number of threads to read with, or 0 for one per hardware thread.
+/// \return A non-negative value on success, or a negative value if a chunk could not be read or decompressed,
+///         or does not fit its destination.
+inline herr_t vbz_read_chunks_parallel(
+    VbzChunkIndex const& index,
+    VbzChunkRead const* reads,
+    std::size_t read_count,
+    unsigned int thread_count)
+{
+    for (std::size_t i = 0; i < read_count; ++i)
+    {
+        if (reads[i].chunk >= index.chunks.size() || reads[i].capacity < index.chunks[reads[i].chunk].size)
+        {
+            return -1;
+        }
+    }
+
+    // Each worker reads its chunks' compressed bytes into the same buffer.
+    std::vector<std::vector<char>> read_buffers;
+    try
+    {
+        read_buffers.resize(vbz_worker_count(read_count, thread_count));
+    }
+    catch (std::bad_alloc const&)
+    {
+        return -1;
+    }
+
+    std::atomic<bool> failed{ false };
+    auto const read_chunk = [&](std::size_t worker, vbz_context* context, std::size_t i)
+    {
+        auto const& chunk = index.chunks[reads[i].chunk];
+        auto const& options = index.datasets[chunk.dataset];
+        auto& compressed = read_buffers[worker];
+        try
+        {
+            compressed.resize(std::size_t(chunk.stored_size));
+        }
+        catch (std::bad_alloc const&)
+        {
+            failed = true;
+            return;
+        }
+
+        std::size_t read_size = 0;
+        while (read_size < compressed.size())
+        {
+            auto const result = pread(
+                index.file_descriptor,
+                compressed.data() + read_size,
+                compressed.size() - read_size,
+                off_t(chunk.address + read_size)
+            );
+            if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (result <= 0)
+            {
+                failed = true;
+                return;
+            }
+            read_size += std::size_t(result);
+        }
+
+        auto const decompressed_size = options.block_size != 0
+            ? vbz_decompress_blocked(compressed.data(), vbz_size_t(compressed.size()), reads[i].destination, vbz_size_t(chunk.size), &options.options, 1)
+            : vbz_decompress_sized_ctx(context, compressed.data(), vbz_size_t(compressed.size()), reads[i].destination, vbz_size_t(chunk.size), &options.options);
+        // A chunk which decodes short would leave the end of its destination unwritten.
+        if (vbz_is_error(decompressed_size) || decompressed_size != chunk.size)
+        {
+            failed = true;
+        }
+    };
+    if (!vbz_parallel_for_each(read_count, thread_count, read_chunk) || failed)
+    {
+        return -1;
+    }
+    return 0;
+}
+#endif
@@ -7,6 +7,24 @@
 
 extern "C" const void* vbz_plugin_info(void);
 
+/// \brief Free the compression state the filter keeps between chunks.
+///
+/// The filter keeps one context for each thread using it at once, each grown to the largest chunk it
+/// has processed. They are freed when the plugin is unloaded, and by #vbz_register's H5close hook where
+/// HDF5 supports one, or can be freed sooner by calling this. Later filter calls create them again.
+extern "C" void vbz_plugin_release_cache(void);
+
+/// \brief Set the maximum number of threads the filter uses for each blocked chunk, see #vbz_filter_enable_blocked.
+/// \param thread_count             The maximum number of threads, or 0 (the default) for one per hardware thread.
+extern "C" void vbz_plugin_set_thread_count(unsigned int thread_count);
+
+#if H5_VERSION_GE(1, 14, 0)
+inline void vbz_release_cache_at_close(void*)
+{
+    vbz_plugin_release_cache();
+}
+#endif
+
 /// \brief Call to enable the vbz filter on the specified creation properties.
 /// \param integer_size             Size of integer type to be compressed. Leave at 0 to extract this information from the hdf type.
 /// \param use_zig_zag              Control if zig zag encoding should be used on the type. If integer_size is not specified then the
@@ -50,6 +68,68 @@ inline int vbz_filter_enable(
     );
 }
 
+/// \brief Call to enable the vbz filter on the specified creation properties, with advanced zstd settings.
+/// \param zstd_compression_level   Control the level of compression used to filter the dataset. Negative values
+///                                 select zstd's fast levels.
+/// \param window_log               Log2 of the zstd window size, or 0 for the level's default.
+/// \param strategy                 zstd strategy, from 1 (fast) to 9 (btultra2), or 0 for the level's default.
+/// \param long_distance_matching   Control if zstd long distance matching is used.
+/// \param worker_count             Number of threads zstd compresses each chunk with, or 0 to use the calling thread.
+/// \see vbz_filter_enable for the remaining parameters.
+inline int vbz_filter_enable_advanced(
+    hid_t creation_properties,
+    unsigned int integer_size,
+    bool use_zig_zag,
+    int zstd_compression_level,
+    int window_log,
+    int strategy,
+    bool long_distance_matching,
+    unsigned int worker_count)
+{
+    unsigned int values[FILTER_VBZ_OPTION_COUNT] = {
+        (unsigned int)FILTER_VBZ_VERSION,
+        integer_size,
+        use_zig_zag,
+        (unsigned int)zstd_compression_level,
+        (unsigned int)window_log,
+        (unsigned int)strategy,
+        long_distance_matching,
+        worker_count
+    };
+
+    return H5Pset_filter(creation_properties, FILTER_VBZ_ID, 0, FILTER_VBZ_OPTION_COUNT, values);
+}
+
+/// \brief Call to enable the vbz filter on the specified creation properties, splitting each chunk into blocks.
+///
+/// Blocks are compressed independently, so each chunk is compressed and decompressed on several threads
+/// (see #vbz_plugin_set_thread_count). This suits datasets stored as one large chunk per read, where
+/// reading a read is otherwise a single filter call on one thread. Smaller blocks compress slightly worse.
+/// \param block_size               The number of integers in each block, eg. VBZ_DEFAULT_BLOCK_SIZE, or 0 to
+///                                 compress chunks whole.
+/// \see vbz_filter_enable for the remaining parameters.
+inline int vbz_filter_enable_blocked(
+    hid_t creation_properties,
+    unsigned int integer_size,
+    bool use_zig_zag,
+    unsigned int zstd_compression_level,
+    unsigned int block_size)
+{
+    unsigned int values[FILTER_VBZ_OPTION_COUNT] = {
+        (unsigned int)FILTER_VBZ_VERSION,
+        integer_size,
+        use_zig_zag,
+        zstd_compression_level,
+        0,
+        0,
+        0,
+        0,
+        block_size
+    };
+
+    return H5Pset_filter(creation_properties, FILTER_VBZ_ID, 0, FILTER_VBZ_OPTION_COUNT, values);
+}
+
 inline bool vbz_register()
 {
     int retval = H5Zregister(vbz_plugin_info());
@@ -58,5 +138,9 @@ inline bool vbz_register()
         return 0;
     }
 
+#if H5_VERSION_GE(1, 14, 0)
+    H5atclose(vbz_release_cache_at_close, nullptr);
+#endif
+
     return 1;
 }